@@ -7,6 +7,31 @@
 
 #include <Arduino.h>
 #include <RemoteLogger.h>
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+#include <wiring_private.h>     // pinPeripheral - for read_adc
+#endif
+
+#ifdef ARDUINO_ARCH_SAMD
+/* heap and stack for memory_stats */
+extern "C" char *sbrk(int incr);
+extern "C" char __StackTop;         // top of RAM, from the linker script
+
+/* newlib-nano's list of freed heap blocks (weak - its address is 0 with another malloc) */
+struct FreeChunk {
+    long size;                      // header included
+    FreeChunk *next;
+};
+extern "C" FreeChunk *__malloc_free_list __attribute__((weak));
+
+#ifdef RL_COUNT_ALLOCS
+/* count every allocation - link with -Wl,--wrap=malloc,--wrap=realloc (see memory_stats) */
+static uint32_t allocCount = 0;
+extern "C" void *__real_malloc(size_t size);
+extern "C" void *__real_realloc(void *ptr, size_t size);
+extern "C" void *__wrap_malloc(size_t size){ allocCount++; return __real_malloc(size); }
+extern "C" void *__wrap_realloc(void *ptr, size_t size){ allocCount++; return __real_realloc(ptr, size); }
+#endif
+#endif
 
 /* CONSTRUCTORS AND STARTUP */
 
@@ -22,7 +47,7 @@ RemoteLogger::RemoteLogger(String header){
 RemoteLogger::RemoteLogger(String header, byte num_params, float *multipliers, String letters){
     myHeader = header;
     myMultipliers = multipliers;
-    myParams = num_params;
+    myParams = num_params > MAX_PARAMS ? MAX_PARAMS : num_params;      // the records hold MAX_PARAMS values, the rest aren't kept
     myLetters = letters;
 }
 
@@ -31,6 +56,10 @@ RemoteLogger::RemoteLogger(String header, byte num_params, float *multipliers, S
  * user is responsible for setting up any sensors (SDI-12, etc) to pass to sample functions
 */
 void RemoteLogger::begin(){
+    memset(&profile, 0, sizeof(ProfileRecord));
+    paint_stack();          // for the stack depth in memory_stats
+    PhaseTimer timer(*this, PHASE_BEGIN);
+
     // set up main logger pins
     pinMode(ledPin, OUTPUT);
     pinMode(vbatPin, INPUT);
@@ -40,10 +69,11 @@ void RemoteLogger::begin(){
     // start RTC
     rtc.begin();
 
-    // start SD card
-    SD.begin(chipSelect);
+    // start SD card, and finish any write a power cut interrupted (one small file, however long deployed)
+    if (sd_ready()) recover_journal();
 
-    /* would read any parameters here */
+    // settings from PARAM.txt (written by apply_params), if there is one
+    read_params();
 }
 
 
@@ -61,11 +91,11 @@ void RemoteLogger::begin(){
 void RemoteLogger::blinky(int n, int high_ms, int low_ms, int btw_ms){
     for(int i = 1; i <=n; i++){
         digitalWrite(ledPin, HIGH);
-        delay(high_ms);
+        idle_wait(high_ms);
         digitalWrite(ledPin, LOW);
-        delay(low_ms);
+        idle_wait(low_ms);
     }
-    delay(btw_ms);
+    idle_wait(btw_ms);
 }
 
 /**
@@ -73,29 +103,15 @@ void RemoteLogger::blinky(int n, int high_ms, int low_ms, int btw_ms){
  * does not manage matching the lengths for you -- you are responsible for making sure your datastring is the right length
  * do NOT add newline characters to the end of datastrings, this will add empty lines in CSV file
  * only writes header if the file is newly created (i.e. has no header yet)
+ * lines are kept in RAM and written to the card in whole blocks - call flush_logs (or tpl_done) before
+ * the power goes off
  * 
  * header: column headers for CSV file
  * datastring_for_csv: the line of data to write to the CSV file
  * outname: name of the CSV file (e.g. /HOURLY.csv)
 */
 void RemoteLogger::write_to_csv(String header, String datastring_for_csv, String outname){
-    //File dataFile;      // File instance -- only used within this function
-
-    /* If file doesn't exist, write header and data, otherwise only write data */
-    if (!SD.exists(outname)){
-        dataFile = SD.open(outname, FILE_WRITE);
-        if (dataFile){
-            dataFile.println(header);       // write header to file
-            dataFile.println(datastring_for_csv);       // write data to file
-        }
-        dataFile.close();       // make sure the file is closed
-    } else {
-        dataFile = SD.open(outname, FILE_WRITE);
-        if (dataFile) {
-            dataFile.println(datastring_for_csv);       // write data to file
-        }
-        dataFile.close();       // make sure the file is closed
-    }
+    append_log(outname.c_str(), header.c_str(), datastring_for_csv.c_str());
 }
 
 /**
@@ -105,16 +121,158 @@ void RemoteLogger::write_to_csv(String header, String datastring_for_csv, String
 */
 float RemoteLogger::sample_batt_v(){
    pinMode(vbatPin, INPUT);
-   float batt_v = (analogRead(vbatPin) * 2 * 3.3) / 1024;      // preset conversion to volts
+   float batt_v = (read_adc(vbatPin) * 2 * 3.3) / 4096;      // preset conversion to volts (halved by the board's divider)
    return batt_v; 
 }
 
 /**
- * sample amount of RAM (memory) available on board
+ * median of a burst of analog readings from pin, scaled to 12 bits (0-4095 over 0-3.3 V)
+ * noise is averaged out by the ADC hardware within each reading and spikes by the median across them
+ * pin: analog pin, numbered as for analogRead
+ * samples: readings in the burst, at most ADC_MAX_BURST
+ * returns 0 if pin isn't an analog pin
+*/
+uint16_t RemoteLogger::read_adc(int pin, int samples){
+    uint16_t values[ADC_MAX_BURST];
+    int n = adc_burst(pin, values, samples);
+    if (n == 0) return 0;
+    return median_u16(values, n);
+}
+
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+// the SAMD21 has one ADC and one DMA controller, so one descriptor for the channel bursts use
+static DmacDescriptor adcDescriptors[ADC_DMA_CHANNEL + 1] __attribute__((aligned(16)));
+static DmacDescriptor adcWriteback[ADC_DMA_CHANNEL + 1] __attribute__((aligned(16)));
+
+static void adc_sync(){
+    while (ADC->STATUS.bit.SYNCBUSY);
+}
+#endif
+
+/**
+ * fill out with a burst of n back to back 12 bit analog readings from pin
+ * on the SAMD21 each reading is ADC_AVERAGE conversions averaged by the ADC (AVGCTRL), and the ADC runs
+ * freely with DMA moving each result to out, so a burst of 10 takes under a millisecond
+ * the ADC settings are put back afterwards, so analogRead and analogReadResolution are unaffected
+ * elsewhere, falls back to analogRead (10 bits, scaled to 12)
+ * returns the number of readings, 0 if pin isn't an analog pin or the burst didn't finish
+*/
+int RemoteLogger::adc_burst(int pin, uint16_t *out, int n){
+    if (n > ADC_MAX_BURST) n = ADC_MAX_BURST;
+    if (n <= 0) return 0;
+
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+    // same pin numbering as analogRead
+    if (pin <= 5) pin += A0;
+#ifdef PIN_A6
+    else if (pin == 6) pin = PIN_A6;
+#endif
+#ifdef PIN_A7
+    else if (pin == 7) pin = PIN_A7;
+#endif
+    if (pin >= (int)PINS_COUNT || g_APinDescription[pin].ulADCChannelNumber == No_ADC_Channel) return 0;
+    pinPeripheral(pin, PIO_ANALOG);
+
+    // the core's settings, put back at the end
+    adc_sync();
+    uint16_t ctrlb = ADC->CTRLB.reg;
+    uint8_t avgctrl = ADC->AVGCTRL.reg;
+    uint8_t sampctrl = ADC->SAMPCTRL.reg;
+    uint32_t inputctrl = ADC->INPUTCTRL.reg;
+    uint8_t ctrla = ADC->CTRLA.reg;
+
+    ADC->CTRLA.bit.ENABLE = 0;
+    adc_sync();
+    ADC->CTRLB.reg = ADC_CTRLB_PRESCALER_DIV32 | ADC_CTRLB_RESSEL_16BIT | ADC_CTRLB_FREERUN;     // 1.5 MHz from 48 MHz
+    ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_8 | ADC_AVGCTRL_ADJRES(3);         // sum of 8, shifted back to 12 bits
+    ADC->SAMPCTRL.reg = ADC_SAMPCTRL_SAMPLEN(15);       // ~5 us to charge - enough for the 50k battery divider
+    adc_sync();
+    ADC->INPUTCTRL.bit.MUXPOS = g_APinDescription[pin].ulADCChannelNumber;
+    adc_sync();
+
+    // the first result after changing input is thrown away, so the burst is one longer
+    uint16_t raw[ADC_MAX_BURST + 1];
+    int count = n + 1;
+
+    // DMA if nobody else is using the controller, otherwise collect each result here
+    bool dma = (DMAC->CTRL.reg & DMAC_CTRL_DMAENABLE) == 0;
+    if (dma) {
+        PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+        PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+        DMAC->BASEADDR.reg = (uint32_t)adcDescriptors;
+        DMAC->WRBADDR.reg = (uint32_t)adcWriteback;
+        DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+
+        DmacDescriptor *desc = &adcDescriptors[ADC_DMA_CHANNEL];
+        desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_HWORD | DMAC_BTCTRL_DSTINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+        desc->BTCNT.reg = count;
+        desc->SRCADDR.reg = (uint32_t)&ADC->RESULT.reg;
+        desc->DSTADDR.reg = (uint32_t)(raw + count);       // end of the block when the address increments
+        desc->DESCADDR.reg = 0;
+
+        DMAC->CHID.reg = DMAC_CHID_ID(ADC_DMA_CHANNEL);
+        DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+        while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST);
+        DMAC->CHCTRLB.reg = DMAC_CHCTRLB_TRIGSRC(ADC_DMAC_ID_RESRDY) | DMAC_CHCTRLB_TRIGACT_BEAT;
+        DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+        DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+    }
 
+    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
+    ADC->CTRLA.bit.ENABLE = 1;
+    adc_sync();
+    ADC->SWTRIG.bit.START = 1;
+
+    unsigned long start = micros();
+    int got = 0;
+    bool done = false;
+    while (!done && micros() - start < ADC_TIMEOUT_US) {
+        if (dma) {
+            DMAC->CHID.reg = DMAC_CHID_ID(ADC_DMA_CHANNEL);
+            done = DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL;
+        } else if (ADC->INTFLAG.bit.RESRDY) {
+            raw[got++] = ADC->RESULT.reg;           // reading RESULT clears RESRDY
+            done = got == count;
+        }
+    }
+
+    // stop and put everything back
+    ADC->CTRLA.bit.ENABLE = 0;
+    adc_sync();
+    if (dma) {
+        DMAC->CHID.reg = DMAC_CHID_ID(ADC_DMA_CHANNEL);
+        DMAC->CHCTRLA.reg = 0;
+        DMAC->CTRL.reg = 0;
+    }
+    ADC->CTRLB.reg = ctrlb;
+    ADC->AVGCTRL.reg = avgctrl;
+    ADC->SAMPCTRL.reg = sampctrl;
+    adc_sync();
+    ADC->INPUTCTRL.reg = inputctrl;
+    adc_sync();
+    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
+    ADC->CTRLA.reg = ctrla;
+    adc_sync();
+
+    if (!done) return 0;
+    memcpy(out, raw + 1, n * sizeof(uint16_t));
+    return n;
+#else
+    for (int i = 0; i < n; i++) out[i] = analogRead(pin) << 2;
+    return n;
+#endif
+}
+
+/**
+ * sample amount of RAM (memory) available on board
+ * by default the RAM between the heap and the stack; see setMemoryReport for the largest free block
+ * or the least room the stack has left, which show fragmentation and stack growth that this hides
 */
 int RemoteLogger::sample_memory(){
-    return freeMemory();
+    if (memoryReport == MEM_FREE) return freeMemory();
+    MemoryStats stats;
+    memory_stats(&stats);
+    return memoryReport == MEM_LARGEST_BLOCK ? stats.largest_block : stats.stack_margin;
 }
 
 /**
@@ -123,22 +281,235 @@ int RemoteLogger::sample_memory(){
  * TODO: set A0 to low in setup code first thing to avoid alerting prematurely?
 */
 void RemoteLogger::tpl_done(){
+    sleep_modem();      // a warmed modem nothing was sent with - keeps the signal it saw
+    flush_logs();       // the TPL is about to cut the power
+    if (profiling) write_profile();
     pinMode(tplPin, OUTPUT);       // just in case
-    digitalWrite(tplPin, LOW); delay(50); digitalWrite(tplPin, HIGH); delay(50);
-    digitalWrite(tplPin, LOW); delay(50); digitalWrite(tplPin, HIGH); delay(50);
-    digitalWrite(tplPin, LOW); delay(50); digitalWrite(tplPin, HIGH); delay(50);
-    digitalWrite(tplPin, LOW); delay(50); digitalWrite(tplPin, HIGH); delay(50);
+    for (int i = 0; i < 4; i++) {
+        digitalWrite(tplPin, LOW); low_power_wait(50, false);
+        digitalWrite(tplPin, HIGH); low_power_wait(50, false);
+    }
+}
+
+/**
+ * write every CSV line buffered by write_to_csv and write_measurement to the card
+ * tpl_done calls this - call it yourself before any other way the power could go off
+*/
+void RemoteLogger::flush_logs(){
+    PhaseTimer timer(*this, PHASE_SD);
+    for (int i = 0; i < LOG_SINKS; i++) {
+        LogSink *sink = &logSinks[i];
+        if (sink->name[0] == '\0') continue;
+        if (sink->len > 0) write_log_block(sink, sink->len);
+        sink->name[0] = '\0';
+    }
+}
+
+/**
+ * wait in low power instead of delay()
+ * the processor sleeps in idle between interrupts (millis, serial, SDI-12 all keep working), or in
+ * standby for waits of at least the standby threshold (see setStandbyThreshold - off by default)
+ * a watchdog started with Watchdog.enable() keeps being fed for the whole wait
+ * 
+ * ms: time to wait in milliseconds
+*/
+void RemoteLogger::idle_wait(unsigned long ms){
+    low_power_wait(ms, true);
+}
+
+/**
+ * set the shortest wait that puts the processor in standby instead of idle
+ * standby uses far less power but turns off USB (Serial monitor disconnects) - leave at 0 (off) while debugging
+ * library waits that expect a reply from a sensor or the modem always stay in idle
+ * 
+ * ms: shortest wait for standby, e.g. 1000; 0 to never use standby
+*/
+void RemoteLogger::setStandbyThreshold(unsigned long ms){ standbyThreshold = ms; }
+
+/**
+ * milliseconds since startup, including any time spent in standby (millis() stops in standby)
+ * use in place of millis() for timing around idle_wait
+*/
+unsigned long RemoteLogger::now_ms(){
+    return millis() + sleptMs;
 }
 
 /**
  * remove datalogging and tracking files from the SD card
  */
 void RemoteLogger::wipe_files(){
+    for (int i = 0; i < LOG_SINKS; i++) logSinks[i].name[0] = '\0';       // drop anything buffered
     SD.remove("/TRACKING.csv");
     SD.remove("/DATA.csv");
     SD.remove("/HOURLY.csv");
+    SD.remove("/HOURLY.bin");
+    SD.remove("/STATE.bin");
+    SD.remove("/OUTBOX.bin");
+    SD.remove("/IMAGE.bin");
+    SD.remove("/JOURNAL.bin");
+    wipe_archive();
+    hourlyLoaded = false;
+    stateLoaded = false;
+    outboxLoaded = false;
+    imageLoaded = false;
+}
+
+
+
+
+/* PROFILING */
+
+/**
+ * start timing a phase of the wake (PHASE_BEGIN etc.) - the time is added when the timer goes out of scope
+ */
+PhaseTimer::PhaseTimer(RemoteLogger &logger, byte phase) : myLogger(logger), myPhase(phase){
+    startUs = myLogger.now_us();
+}
+
+PhaseTimer::~PhaseTimer(){
+    myLogger.add_phase_time(myPhase, myLogger.now_us() - startUs);
+}
+
+/**
+ * keep a profile of every wake in /PROFILE.bin: time spent in each phase (begin, each kind of sensor,
+ * CSV writes, message building, modem power up and sends) and the battery before and during the modem
+ * session, whose drop gives an idea of the energy the modem used
+ * the library's own phases are always timed (a couple of micros() calls each), the record is only
+ * written by tpl_done when profiling is on - one small write per wake into a ring of PROFILE_CAPACITY
+ * 
+ * on: true to write a profile record every wake
+ * in_msg: true to add the last wake's summary to text messages (see prep_msg)
+ */
+void RemoteLogger::setProfiling(bool on, bool in_msg){
+    profiling = on;
+    profileInMsg = on && in_msg;
+}
+
+/**
+ * add time to one phase of this wake's profile - PhaseTimer does this for you
+ * 
+ * phase: PHASE_BEGIN .. PHASE_USER
+ * us: microseconds to add
+ */
+void RemoteLogger::add_phase_time(byte phase, unsigned long us){
+    if (phase < PROFILE_PHASES) profile.phase_us[phase] += us;
+}
+
+/**
+ * micros() that keeps counting through standby (see now_ms)
+ */
+unsigned long RemoteLogger::now_us(){
+    return micros() + sleptMs * 1000UL;
+}
+
+/**
+ * number of wakes kept in /PROFILE.bin
+ */
+int RemoteLogger::num_profiles(){
+    if (!sd_ready()) return 0;
+    File profileFile = SD.open("/PROFILE.bin", FILE_READ);
+    if (!profileFile) return 0;
+    ProfileHeader header;
+    bool ok = load_profile_header(profileFile, &header);
+    profileFile.close();
+    return ok ? header.count : 0;
+}
+
+/**
+ * read the profile of one wake from /PROFILE.bin
+ * 
+ * index: 0 for the oldest wake kept, num_profiles() - 1 for the most recent
+ * record: where to put it
+ * returns false if there is no profile at that index
+ */
+bool RemoteLogger::read_profile(int index, ProfileRecord *record){
+    if (!sd_ready()) return false;
+    File profileFile = SD.open("/PROFILE.bin", FILE_READ);
+    if (!profileFile) return false;
+
+    ProfileHeader header;
+    bool ok = load_profile_header(profileFile, &header) && index >= 0 && index < header.count;
+    if (ok) {
+        uint16_t slot = (header.head + header.capacity - header.count + index) % header.capacity;
+        profileFile.seek(sizeof(ProfileHeader) + (uint32_t)slot * sizeof(ProfileRecord));
+        ok = profileFile.read((uint8_t *)record, sizeof(ProfileRecord)) == sizeof(ProfileRecord);
+    }
+    profileFile.close();
+    return ok;
+}
+
+
+/**
+ * how the RAM is doing: free RAM, how fragmented the heap is, and how deep the stack has been
+ * heap figures walk newlib-nano's free list (a few blocks) and the stack figures scan the RAM
+ * painted by paint_stack up to the deepest the stack went - well under a millisecond, so it can
+ * run every wake (tpl_done adds it to the profile); a station heading for an out-of-memory crash shows
+ * as a shrinking largest_block or stack_margin long before freeMemory() runs out
+ * allocs counts malloc/realloc calls (String uses them) when the library is built with RL_COUNT_ALLOCS
+ * and linked with -Wl,--wrap=malloc,--wrap=realloc, e.g. in platform.local.txt:
+ *   compiler.cpp.extra_flags=-DRL_COUNT_ALLOCS
+ *   compiler.c.elf.extra_flags=-Wl,--wrap=malloc,--wrap=realloc
+ * on other boards only free_bytes is filled in
+ * 
+ * stats: where to put the figures
+ */
+void RemoteLogger::memory_stats(MemoryStats *stats){
+    memset(stats, 0, sizeof(MemoryStats));
+    stats->free_bytes = freeMemory();
+
+#ifdef ARDUINO_ARCH_SAMD
+    long largest = 0;
+    if (&__malloc_free_list != NULL) {
+        for (FreeChunk *chunk = __malloc_free_list; chunk != NULL; chunk = chunk->next) {
+            stats->free_fragments++;
+            stats->heap_free += chunk->size;
+            if (chunk->size > largest) largest = chunk->size;
+        }
+    }
+    stats->largest_block = (uint32_t)largest > stats->free_bytes ? largest : stats->free_bytes;
+
+    if (stackPaintStart != NULL) {
+        // the stack grows down into the painted RAM - the first word it changed is the deepest it went
+        uint32_t *heap_top = (uint32_t *)(((uintptr_t)sbrk(0) + 3) & ~(uintptr_t)3);
+        uint32_t *word = stackPaintStart > heap_top ? stackPaintStart : heap_top;
+        uint32_t here;
+        while (word < &here && *word == STACK_PAINT) word++;
+        stats->stack_used = &__StackTop - (char *)word;
+        stats->stack_margin = (char *)word - (char *)heap_top;
+    }
+#endif
+#if defined(ARDUINO_ARCH_SAMD) && defined(RL_COUNT_ALLOCS)
+    stats->allocs = allocCount;
+#endif
+}
+
+/**
+ * paint the free RAM between the heap and the stack so memory_stats can tell how deep the stack went,
+ * and start counting allocations again - begin does this, call it again to measure from another point
+ * (newlib-nano never gives heap back, so heap growth only covers RAM the stack didn't need yet)
+ */
+void RemoteLogger::paint_stack(){
+#ifdef ARDUINO_ARCH_SAMD
+    uint32_t here;
+    uint32_t *word = (uint32_t *)(((uintptr_t)sbrk(0) + 3) & ~(uintptr_t)3);
+    uint32_t *end = (uint32_t *)(((uintptr_t)&here - STACK_PAINT_GUARD) & ~(uintptr_t)3);
+    stackPaintStart = word;
+    while (word < end) *word++ = STACK_PAINT;
+#endif
+#if defined(ARDUINO_ARCH_SAMD) && defined(RL_COUNT_ALLOCS)
+    allocCount = 0;
+#endif
 }
 
+/**
+ * choose what sample_memory returns, and so the memory field of DATA.csv and of messages
+ * 
+ * what: MEM_FREE (default) for freeMemory(), MEM_LARGEST_BLOCK for the largest allocation that would
+ *       succeed, or MEM_STACK_MARGIN for the least room there has been between the stack and the heap
+ */
+void RemoteLogger::setMemoryReport(byte what){
+    memoryReport = what;
+}
 
 
 
@@ -150,7 +521,23 @@ void RemoteLogger::wipe_files(){
  * use num_samples to access counter value
 */
 void RemoteLogger::increment_samples(){
-    write_to_csv("n", "1", "/TRACKING.csv");
+    if (!load_state()) return;
+    state.samples_since_hourly++;
+    save_state();
+}
+
+/**
+ * same as increment_samples, and also adds the sample to the running statistics for each parameter
+ * (mean, min, max and standard deviation since the last write to hourly - see setAggregates)
+ * the statistics are kept with the counters so they survive the TPL cutting the power
+ * 
+ * msmt: this wake's measurement
+*/
+void RemoteLogger::increment_samples(Measurement *msmt){
+    if (!load_state()) return;
+    state.samples_since_hourly++;
+    add_to_stats(msmt);
+    save_state();
 }
 
 /**
@@ -159,23 +546,17 @@ void RemoteLogger::increment_samples(){
  * use increment_samples to increment counter
 */
 int RemoteLogger::num_samples(){
-    CSV_Parser cp("s", true, ',');     //for reading from TRACKING.csv
-    cp.readSDfile("/TRACKING.csv");
-    return cp.getRowsCount() - 1; //don't count the header
+    if (!load_state()) return 0;
+    return state.samples_since_hourly;
 }
 
 /**
  * access counter of number of hourly samples waiting to be transmitted
+ * read straight from the hourly store header - does not scan the file
 */
 int RemoteLogger::num_hours(){
-    String csv_setting = produce_csv_setting();
-    char buf[csv_setting.length()+1];
-    csv_setting.toCharArray(buf, csv_setting.length()+1);
-
-    CSV_Parser cp(buf, true, ',');
-    cp.readSDfile("/HOURLY.csv");
-
-    return cp.getRowsCount();
+    if (!load_hourly()) return 0;
+    return hourlyHeader.count;
 }
 
 /**
@@ -183,671 +564,2159 @@ int RemoteLogger::num_hours(){
  * counts samples taken since a write to hourly
 */
 void RemoteLogger::reset_sample_counter(){
-    SD.remove("/TRACKING.csv");
+    if (!load_state()) return;
+    state.samples_since_hourly = 0;
+    save_state();
 }
 
 /**
  * set hourly counter to zero
  * counts hourly samples waiting to be transmitted
- * warning: resetting this counter deletes all data stored in hourly file
+ * warning: resetting this counter discards all data waiting in the hourly store (it is still in DATA.csv)
 */
 void RemoteLogger::reset_hourly(){
-    SD.remove("/HOURLY.csv");
+    if (!load_hourly()) return;
+    hourlyHeader.tail = hourlyHeader.head;
+    hourlyHeader.count = 0;
+    save_hourly_header();
 }
 
+/**
+ * access counter of hourly samples written since the last successful send
+ * incremented by write_hourly, set back to zero by send_msg when a message goes through
+ * unlike num_hours this keeps counting if the hourly store is reset or overflows
+*/
+int RemoteLogger::num_hours_since_send(){
+    if (!load_state()) return 0;
+    return state.hours_since_send;
+}
 
-
-
-/* TELEMETRY */
+/**
+ * access counter of send attempts that have failed in a row
+ * incremented by send_msg on failure, set back to zero on a successful send
+*/
+int RemoteLogger::num_failed_sends(){
+    if (!load_state()) return 0;
+    return state.failed_sends;
+}
 
 /**
- * send provided message over the Iridium network
- * connect Iridium sleep pin (7 - grey) to pin 13 or change value of IridSlpPin
- * TODO: investigate -- did removing the Watchdog mess things up? try it with the TPL
+ * set failed send counter to zero
 */
-int RemoteLogger::send_msg(String myMsg){
-    digitalWrite(IridSlpPin, HIGH);     // wake up the modem
-    delay(2000);        // wait for RockBlock to power on
+void RemoteLogger::reset_failed_sends(){
+    if (!load_state()) return;
+    state.failed_sends = 0;
+    save_state();
+}
 
-    IridiumSerial.begin(19200);     // Iridium serial at 19200 baud
-    modem.setPowerProfile(IridiumSBD::USB_POWER_PROFILE);
 
-    int err = modem.begin();        // start up the modem
-    if (err == ISBD_IS_ASLEEP){
-        err = modem.begin();    // try to start up again
-    }
 
-    err = modem.sendSBDText(myMsg.c_str());    // try to send the message
 
-    if (err != ISBD_SUCCESS) { // if unsuccessful try again
-        err = modem.begin();
-        err = modem.sendSBDText(myMsg.c_str());
-    }
+/* HOURLY STORE */
 
-    // calibrate the RTC time roughly every 5 days
-    /** TODO: will this miss days by accident? what if we miss noon? (i.e. only sending every two hours)*/
-    /** TODO: do we need the pre/post time strings? */
-    if (rtc.now().hour() == 12 & rtc.now().day() % 5 == 0) {
-        sync_clock();
+/**
+ * add a sample to the hourly store (/HOURLY.bin) to be sent in the next message
+ * the store is a preallocated ring of fixed-size binary records, so writing never grows the file
+ * once HOURLY_CAPACITY records are waiting the oldest is overwritten
+ *
+ * time: timestamp of the sample (usually the time the logger woke up)
+ * sample: comma-separated sample, same as written to DATA.csv without the timestamp (batt_v,memory,param1,...)
+*/
+void RemoteLogger::write_hourly(DateTime time, String sample){
+    if (!load_hourly()) return;
+
+    HourlyRecord record;
+    float *fields = &record.batt_v;         // batt_v, memory and the params are laid out back to back
+    const char *p = sample.c_str();
+    char *end;
+
+    for (int i = 0; i < myParams + 2; i++) {
+        fields[i] = strtod(p, &end);
+        if (end == p) fields[i] = NO_READING;       // empty or missing field
+        p = end;
+        while (*p && *p != ',') p++;        // skip anything strtod didn't use
+        if (*p == ',') p++;
     }
+    record.timestamp = time.unixtime();
 
-    digitalWrite(IridSlpPin, LOW);      // put the modem back to sleep
-    return err; 
+    append_hourly(&record);
 }
 
 /**
- * test the Iridium modem + connection by sending a message
- * sends "Hello world" + provided message
- * will print firmware version and test signal quality
- * if any functions fail it will leave the function immediately 
- * warning that this will attempt to send a message and use credits
- * prints status messages to Serial - does not return any status information from function
+ * add a sample to the hourly store from a Measurement - same as above without parsing a String
+ *
+ * time: timestamp of the sample (usually the time the logger woke up)
+ * msmt: measurement filled by start_measurement and the sampling functions
 */
-void RemoteLogger::irid_test(String msg){
-    digitalWrite(IridSlpPin, HIGH);         // turn on modem
-    delay(2000);        // wait for modem to start up
-
-    int signalQuality = -1;     // need this to pass in for signal quality query
-
-    IridiumSerial.begin(19200);
-    modem.setPowerProfile(IridiumSBD::USB_POWER_PROFILE);
-
-    /* begin satellite modem operation */
-    Serial.println(" - starting modem...");
-    int err = modem.begin();
-    if (err != ISBD_SUCCESS) {
-        Serial.print(" - begin failed: error ");
-        Serial.println(err);
-        if (err == ISBD_NO_MODEM_DETECTED) {
-            Serial.println(" - no modem detected: check wiring.");
-        }
-        return;     // leave the function - no point in trying to send
-    }
-
-    /* print the firmware version */
-    char version[12];
-    err = modem.getFirmwareVersion(version, sizeof(version));
-    if (err != ISBD_SUCCESS) {      // didn't get version info
-        Serial.print(" - firmware version failed: error ");
-        Serial.println(err);
-        return;     // leave the test function
-    }
-    Serial.print(" - firmware version is ");
-    Serial.print(version);
-    Serial.println(".");
-
-    /* get signal quality */
-    int n = 0;
-    while (n < 10) {    // test signal quality 10 times
-        err = modem.getSignalQuality(signalQuality);    // query signal quality
-        if (err != ISBD_SUCCESS) {
-            Serial.print(" - signalQuality failed: error ");
-            Serial.println(err);
-            return;        // leave the test function
-        }
-        Serial.print(" - signal quality is currently ");
-        Serial.print(signalQuality);
-        Serial.println(".");
-        n++;
-        delay(1000);
+void RemoteLogger::write_hourly(DateTime time, Measurement *msmt){
+    if (!load_hourly()) return;
+
+    HourlyRecord record;
+    record.timestamp = time.unixtime();
+    record.batt_v = msmt->batt_v;
+    record.memory = msmt->memory;
+    for (int i = 0; i < myParams; i++) {
+        record.values[i] = stat_value(i, msmt);
     }
 
-    /* send the message */
-    Serial.print(" - Attempting: ");
-    msg = "Hello world! " + msg;
-    Serial.println(msg);
-    err = modem.sendSBDText(msg.c_str());
-    if (err != ISBD_SUCCESS) {
-        Serial.print(" - sendSBDText failed: error ");
-        Serial.println(err);
-        if (err == ISBD_SENDRECEIVE_TIMEOUT) {
-            Serial.println(" - try again with a better view of the sky.");
-        }
-    } else {
-        Serial.println(" - hey, it worked!");
+    // start the statistics again for the next hour (saved with the counters in append_hourly)
+    if (myAggregates != NULL && load_state()) {
+        memset(state.stats, 0, sizeof(state.stats));
     }
 
-    /* sync clock to Iridium */
-    Serial.println("Sync clock to Iridium");
-    sync_clock();
-    
+    append_hourly(&record);
 }
 
 /**
- * prepare message from hourly data file to send via Iridium to database
- * actual data values are multiplied by varying powers of 10 to remove decimals
- * see documentation for letter-to-header mappings and multipliers
- * 
- * if there are more lines in hourly data file than allowable in a single message, will send only
- * the most recent from bottom of file (e.g. if max in message is 8 and 10 data samples, will send samples 3-10)
- * 
- * e.g. 
- * Data file: 
- * datetime,batt_v,memory,water_level_mm,water_temp_c,water_ec_dcm
- * 2001-01-10T01:11:05,4.31,24627,10,18.7,3
+ * choose what write_hourly(time, msmt) stores for each parameter, in the same order as the multipliers:
+ * STAT_LAST (the sample itself), STAT_MEAN, STAT_MIN, STAT_MAX or STAT_STDDEV of every sample added with
+ * increment_samples(msmt) since the last write - so prep_msg and the outbox send those instead of one
+ * snapshot an hour
  * 
- * Message:
- * ABC:01011001:431,246,10,187,3:
+ * aggregates: one STAT_ code per parameter, must stay in scope (like the multipliers), NULL to stop
 */
-String RemoteLogger::prep_msg(){
-    int maxInMsg = 18;
-
-    // process header to determine number of columns (parameters)
-    // Serial.println(F("preparing csv setting..."));         /** TODO: remove */
-    String csv_setting = produce_csv_setting();
-    // Serial.println(csv_setting);    /** TODO: remove */
-
-    SD.begin(chipSelect);       //start the SD card connection
-    
-    // Serial.println(freeMemory());       /** TODO: remove */
-    // Serial.println(F("preparing CSV parser..."));      /** TODO: remove */
-    char buf[csv_setting.length()+1];   Serial.println(1);  /** TODO: remove */
-    csv_setting.toCharArray(buf, csv_setting.length()+1);  
-    // Serial.println(freeMemory());       /** TODO: remove */
-    CSV_Parser cp(buf, true, ',');      
-    cp.readSDfile("/HOURLY.csv");       
-    int num_rows = cp.getRowsCount(); 
-
-    int first;          // where to start adding data to message (limit message size)
-    if (num_rows > maxInMsg) first = num_rows - maxInMsg; 
-    else first = 0;
-
-    // Serial.println(6);      /** TODO: remove */
-
-    // Serial.println(F("preparing header index..."));        /** TODO: remove */
-    // figure out where each parameter's info is in the dictionary
-    // int **headerIndex;
-    // headerIndex[num_params];
-    // populate_header_index(headerIndex, num_params);
-
-    // Serial.println(F("building message..."));      /** TODO: remove */
-    // generate the letters
-    String datastring_msg = "";
-    datastring_msg.reserve(200);
-    // for(int i = 0; i < num_params; i++){
-    //     datastring_msg += LETTERS[*headerIndex[i]];
-    // }
-
-    datastring_msg += myLetters;
-    datastring_msg += ":";
-
-    int column = 0;        // position of the header we're on
-
-    // Serial.println(F("date and time..."));     /** TODO: remove */
-    //datetime (of first measurement in message)
-    char **out_datetimes = (char **)cp[column];       // get list of datetimes 
-    datastring_msg += String(out_datetimes[first]).substring(2,4); 
-    datastring_msg += String(out_datetimes[first]).substring(5,7);
-    datastring_msg += String(out_datetimes[first]).substring(8,10);
-    datastring_msg += String(out_datetimes[first]).substring(11,13);
-    datastring_msg += ":";
-
-    delete out_datetimes;       // free up memory
-
-    column++;
-
-    float *floatOut;        //temporary variable for float columns to live in
-
-    // Serial.println(F("battery voltage and memory..."));   /** TODO: remove */
-    //battery voltage (most recent)
-    floatOut = (float *)cp[column];
-    datastring_msg += String(round(floatOut[num_rows-1] * BATT_MULT));
-    datastring_msg += ":";
-
-    column++;
-
-    //free memory (most recent)
-    floatOut = (float *)cp[column];
-    datastring_msg += String(round(floatOut[num_rows-1] * MEM_MULT)); 
-    datastring_msg += ":";
-
-    // Serial.print(F("adding data... "));           /** TODO: remove */
-    //sampled data
-    for (int row = first; row < num_rows; row++) {        // for each row in the data file
-        column = 3;    //start each time at the start of the sampled data (fourth column)
-        // Serial.print(F("row ")); Serial.print(row); Serial.print(F("   "));   /** TODO: remove */
+void RemoteLogger::setAggregates(const byte *aggregates){
+    myAggregates = aggregates;
+}
 
-        while (column < myParams+3) {      // for each column (sampled data point) in the row 
-            // floatOut = (float *)cp[column];
-            // datastring_msg += String(round(floatOut[row] * myMultipliers[column-3]));
+/**
+ * helper function
+ * add a measurement to the running statistics - Welford's method, so no samples need to be kept
+*/
+void RemoteLogger::add_to_stats(Measurement *msmt){
+    for (int i = 0; i < msmt->count && i < MAX_PARAMS; i++) {
+        float value = msmt->values[i];
+        if (value == NO_READING) continue;
+
+        RunningStats *st = &state.stats[i];
+        st->n++;
+        if (st->n == 1) {
+            st->mean = value;
+            st->m2 = 0;
+            st->min = value;
+            st->max = value;
+            continue;
+        }
+        float delta = value - st->mean;
+        st->mean += delta / st->n;
+        st->m2 += delta * (value - st->mean);
+        if (value < st->min) st->min = value;
+        if (value > st->max) st->max = value;
+    }
+}
 
-            // if(column != myParams+2) { datastring_msg += ","; }           // add commas between data points
-            // else { datastring_msg += ":"; }     // add a colon only to data from last column
+/**
+ * helper function
+ * what write_hourly stores for one parameter - the sample itself unless setAggregates chose a statistic
+ * falls back on the sample if no readings were added to the statistics
+*/
+float RemoteLogger::stat_value(int param, Measurement *msmt){
+    float last = param < msmt->count ? msmt->values[param] : NO_READING;
+    if (myAggregates == NULL || myAggregates[param] == STAT_LAST || !load_state()) return last;
+
+    RunningStats *st = &state.stats[param];
+    if (st->n == 0) return last;
+
+    switch (myAggregates[param]) {
+        case STAT_MEAN: return st->mean;
+        case STAT_MIN: return st->min;
+        case STAT_MAX: return st->max;
+        case STAT_STDDEV: return st->n > 1 ? sqrt(st->m2 / (st->n - 1)) : 0;
+    }
+    return last;
+}
 
-            // manage selection of which parameters to send with multipliers
-            if(myMultipliers[column-3] != 0){         // want to send this in the message
-                floatOut = (float *)cp[column];
-                datastring_msg += String(round(floatOut[row] * myMultipliers[column-3]));
+/**
+ * helper function
+ * write a record at the head of the hourly ring and advance the header
+ * both go through the journal, so a power cut can't leave the header pointing at a torn record
+*/
+void RemoteLogger::append_hourly(HourlyRecord *record){
+    uint32_t offset = sizeof(HourlyHeader) + (uint32_t)hourlyHeader.head * hourlyHeader.record_size;
 
-                datastring_msg += ",";         // add commas between 
-            }
+    hourlyHeader.head = (hourlyHeader.head + 1) % hourlyHeader.capacity;
+    if (hourlyHeader.count == hourlyHeader.capacity) {      // full - drop the oldest
+        hourlyHeader.tail = (hourlyHeader.tail + 1) % hourlyHeader.capacity;
+    } else {
+        hourlyHeader.count++;
+    }
 
-            column++;       //go to the next column
-        }
-        datastring_msg.setCharAt(datastring_msg.length()-1, ':');       // set the last character 
+    JournalWrite writes[2] = {
+        {"/HOURLY.bin", offset, record, hourlyHeader.record_size},
+        {"/HOURLY.bin", 0, &hourlyHeader, sizeof(HourlyHeader)},
+    };
+    if (!journal_writes(writes, 2)) {
+        hourlyLoaded = false;           // read the header again, whatever made it to the card
+        return;
     }
-    // Serial.println();       /** TODO: remove */
 
-    // free up memory
-    delete floatOut;
-    // delete headerIndex;
-    
-    return datastring_msg;
+    if (load_state()) {
+        state.hours_since_send++;
+        save_state();
+    }
 }
 
 /**
- * prepare message in same format as usual but with only the most recent sample written to hourly data file
- * intended for use during low power mode as absolute minimum amount of data transfer
- */
-String RemoteLogger::low_pwr_prep_msg(){
-    String csv_setting = produce_csv_setting();
+ * read one waiting record from the hourly store
+ * seeks straight to the record, nothing else in the file is read
+ * the file is opened for the one record, unless a message build is holding it open (open_hourly)
+ * returns false if there is no record at that position
+ *
+ * index: position among waiting records, 0 is the oldest and num_hours()-1 the most recent
+ * record: filled with the timestamp, battery, memory and the first myParams values
+*/
+bool RemoteLogger::read_hourly(int index, HourlyRecord *record){
+    if (!load_hourly()) return false;
+    if (index < 0 || index >= hourlyHeader.count) return false;
 
-    SD.begin(chipSelect);       //start the SD card connection
+    uint16_t slot = (hourlyHeader.tail + index) % hourlyHeader.capacity;
 
-    char buf[csv_setting.length()+1];   // Serial.println(1);  /** TODO: remove */
-    csv_setting.toCharArray(buf, csv_setting.length()+1); 
-    CSV_Parser cp(buf, true, ',');      
-    cp.readSDfile("/HOURLY.csv");       
-    int num_rows = cp.getRowsCount(); 
+    bool held = hourlyFile;
+    File hourly = held ? hourlyFile : SD.open("/HOURLY.bin", FILE_READ);
+    if (!hourly) return false;
+    hourly.seek(sizeof(HourlyHeader) + (uint32_t)slot * hourlyHeader.record_size);
+    int got = hourly.read((uint8_t *)record, hourlyHeader.record_size);
+    if (!held) hourly.close();
 
-    String datastring_msg = "";
-    datastring_msg.reserve(40);
+    return got == hourlyHeader.record_size;
+}
 
-    datastring_msg += myLetters;
-    datastring_msg += ":";
+/**
+ * helper function
+ * open /HOURLY.bin once for the reads of a message build, so walking the rows that fit and building
+ * the message costs one open - the rows are read in order, so the card reads each block of the range
+ * once (twice where the ring wraps) and the other reads come from the SD library's block cache
+ * close_hourly when the build is done, before anything writes the store
+*/
+void RemoteLogger::open_hourly(){
+    if (!hourlyFile) hourlyFile = SD.open("/HOURLY.bin", FILE_READ);
+}
 
-    int column = 0;        // position of the header we're on
+/**
+ * helper function
+ * close the file opened by open_hourly - read_hourly opens its own again
+*/
+void RemoteLogger::close_hourly(){
+    if (hourlyFile) hourlyFile.close();
+}
 
-    // date and time
-    char **out_datetimes = (char **)cp[column];       // get list of datetimes 
-    datastring_msg += String(out_datetimes[num_rows-1]).substring(2,4); 
-    datastring_msg += String(out_datetimes[num_rows-1]).substring(5,7);
-    datastring_msg += String(out_datetimes[num_rows-1]).substring(8,10);
-    datastring_msg += String(out_datetimes[num_rows-1]).substring(11,13);
-    datastring_msg += ":";
 
-    delete out_datetimes;       // free up memory
 
-    column++;
 
-    float *floatOut;        //temporary variable for float columns to live in
+/* ARCHIVE */
 
-    // battery voltage (most recent)
-    floatOut = (float *)cp[column];
-    datastring_msg += String(round(floatOut[num_rows-1] * BATT_MULT));
-    datastring_msg += ":";
+/**
+ * keep a measurement in the archive: a binary record (the hourly store layout) appended to the day's
+ * segment, /LOG/YYMM/DD.bin, with one folder per month so no folder grows past 31 files
+ * each write opens one small file, so it takes the same time in the third year as on the first day
+ * (unlike DATA.csv, which the card has to follow to its end), and a record cut short by a power cut
+ * is written over by the next one
+ * a new day is listed in /LOG/INDEX.bin before its segment is started, so a power cut can't leave a
+ * segment that read_archive doesn't know about
+ *
+ * time: timestamp of the sample (usually the time the logger woke up)
+ * msmt: measurement filled by start_measurement and the sampling functions
+*/
+void RemoteLogger::write_archive(DateTime time, Measurement *msmt){
+    PhaseTimer timer(*this, PHASE_SD);
+    if (!sd_ready()) return;
+
+    HourlyRecord record;
+    record.timestamp = time.unixtime();
+    record.batt_v = msmt->batt_v;
+    record.memory = msmt->memory;
+    for (int i = 0; i < myParams; i++) {
+        record.values[i] = i < msmt->count ? msmt->values[i] : NO_READING;
+    }
+    uint16_t size = hourly_record_size();
+
+    uint32_t day = record.timestamp - record.timestamp % 86400;
+    char path[32];
+    archive_path(day, path);
+    File segment = SD.open(path, FILE_RW);
+    if (!segment) {             // first day of the month - make its folder
+        path[9] = '\0';
+        SD.mkdir(path);
+        path[9] = '/';
+        segment = SD.open(path, FILE_RW);
+        if (!segment) return;
+    }
 
-    column++;
+    ArchiveHeader header;
+    uint32_t length = segment.size();
+    bool fresh = length < sizeof(ArchiveHeader)
+        || segment.read((uint8_t *)&header, sizeof(ArchiveHeader)) != sizeof(ArchiveHeader)
+        || header.magic != ARCHIVE_MAGIC || header.record_size != size;
+    if (fresh) {            // a new day (or the parameters changed, and the day starts again)
+        segment.close();
+        add_archive_day(day, size);         // listed first - a segment cut short before its header is fresh next time
+        segment = SD.open(path, FILE_RW | O_TRUNC);
+        if (!segment) return;
+        header.magic = ARCHIVE_MAGIC;
+        header.record_size = size;
+        header.reserved = 0;
+        segment.write((const uint8_t *)&header, sizeof(ArchiveHeader));
+        length = sizeof(ArchiveHeader);
+    }
 
-    //free memory (most recent)
-    floatOut = (float *)cp[column];
-    datastring_msg += String(round(floatOut[num_rows-1] * MEM_MULT)); 
-    datastring_msg += ":";
+    // after the last whole record
+    segment.seek(sizeof(ArchiveHeader) + (length - sizeof(ArchiveHeader)) / size * size);
+    segment.write((const uint8_t *)&record, size);
+    segment.close();
+}
 
-    column = 3;
-    while(column < myParams+3){
-        // manage selection of which parameters to send with multipliers
-        if(myMultipliers[column-3] != 0){         // want to send this in the message
-            floatOut = (float *)cp[column];
-            datastring_msg += String(round(floatOut[num_rows-1] * myMultipliers[column-3]));
-
-            datastring_msg += ",";         // add commas between 
+/**
+ * read archived records with from <= timestamp < to, oldest first
+ * finds the first day in /LOG/INDEX.bin and the first record in its segment by bisection, so a week
+ * from a multi-year archive costs a few small reads and then the week's records - nothing else is read
+ * 
+ * from, to: seconds since 1970 (DateTime::unixtime)
+ * records: filled with up to max records (the first myParams values of each)
+ * next: if not NULL, set to where to carry on from if max records were read, to otherwise
+ * returns the number of records read
+*/
+int RemoteLogger::read_archive(uint32_t from, uint32_t to, HourlyRecord *records, int max, uint32_t *next){
+    if (next) *next = to;
+    if (!sd_ready() || max <= 0) return 0;
+
+    File index = SD.open(ARCHIVE_INDEX, FILE_READ);
+    if (!index) return 0;
+    int days = index.size() / sizeof(ArchiveEntry);
+
+    // the last day starting at or before from
+    ArchiveEntry entry;
+    int first = 0;
+    int lo = 0, hi = days - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        index.seek((uint32_t)mid * sizeof(ArchiveEntry));
+        if (index.read((uint8_t *)&entry, sizeof(ArchiveEntry)) != sizeof(ArchiveEntry)) break;
+        if (entry.day <= from) {
+            first = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
         }
-
-        column++;       //go to the next column
     }
-    datastring_msg.setCharAt(datastring_msg.length()-1, ':');       // set the last character 
 
-    // free up memory
-    delete floatOut;
+    int got = 0;
+    for (int d = first; d < days && got < max; d++) {
+        index.seek((uint32_t)d * sizeof(ArchiveEntry));
+        if (index.read((uint8_t *)&entry, sizeof(ArchiveEntry)) != sizeof(ArchiveEntry)) break;
+        if (entry.day >= to) break;
+        got += read_archive_day(&entry, from, to, records + got, max - got);
+    }
+    index.close();
 
-    return datastring_msg;
+    if (next && got == max) *next = records[got - 1].timestamp + 1;
+    return got;
 }
 
+/**
+ * number of days in the archive (segments listed in /LOG/INDEX.bin)
+*/
+int RemoteLogger::num_archive_days(){
+    if (!sd_ready()) return 0;
+    File index = SD.open(ARCHIVE_INDEX, FILE_READ);
+    if (!index) return 0;
+    int days = index.size() / sizeof(ArchiveEntry);
+    index.close();
+    return days;
+}
 
-
-
-/* SAMPLING FUNCTIONS */
+/**
+ * helper function
+ * file name of the archive segment for a day: /LOG/YYMM/DD.bin
+*/
+void RemoteLogger::archive_path(uint32_t day, char *out){
+    DateTime date(day);
+    snprintf(out, 32, "/LOG/%02d%02d/%02d.bin", date.year() % 100, date.month(), date.day());
+}
 
 /**
- * sample from Hydros21 sensor
- * supply with bus and address of sensor 
- * 
- * bus: valid SDI12 bus initialized with the data pin attached to Hydros sensor, must have had begin() called already
- * sensor_address: SDI-12 address of the Hydros sensor, usually assumed to be 0
+ * helper function
+ * list a newly started segment in /LOG/INDEX.bin (or update its entry if the day started again)
 */
-String RemoteLogger::sample_hydros_M(SDI12 bus, int sensor_address){
-    sdiResponse = "";
-    myCommand = String(sensor_address) + "M!";       // first command to take a measurement
+void RemoteLogger::add_archive_day(uint32_t day, uint16_t record_size){
+    File index = SD.open(ARCHIVE_INDEX, FILE_RW);
+    if (!index) return;
+
+    ArchiveEntry entry;
+    uint32_t n = index.size() / sizeof(ArchiveEntry);      // whole entries - a torn one is written over
+    if (n > 0) {
+        index.seek((n - 1) * sizeof(ArchiveEntry));
+        if (index.read((uint8_t *)&entry, sizeof(ArchiveEntry)) == sizeof(ArchiveEntry) && entry.day == day) n--;
+    }
 
-    bus.sendCommand(myCommand);
-    delay(30);
+    entry.day = day;
+    entry.record_size = record_size;
+    entry.reserved = 0;
+    index.seek(n * sizeof(ArchiveEntry));
+    index.write((const uint8_t *)&entry, sizeof(ArchiveEntry));
+    index.close();
+}
 
-    while (bus.available()) {
-        char c = bus.read();
-        if ((c != '\n') && (c != '\r')) {
-            sdiResponse += c;
-            delay(10);      // 1 character ~ 7.5ms
-        }
+/**
+ * helper function
+ * read the records of one day's segment with from <= timestamp < to into records (up to max)
+ * returns the number read
+*/
+int RemoteLogger::read_archive_day(ArchiveEntry *entry, uint32_t from, uint32_t to, HourlyRecord *records, int max){
+    char path[32];
+    archive_path(entry->day, path);
+    File segment = SD.open(path, FILE_READ);
+    if (!segment) return 0;
+
+    ArchiveHeader header;
+    if (segment.read((uint8_t *)&header, sizeof(ArchiveHeader)) != sizeof(ArchiveHeader)
+            || header.magic != ARCHIVE_MAGIC || header.record_size == 0 || header.record_size > sizeof(HourlyRecord)) {
+        segment.close();
+        return 0;
     }
-
-    /* clear buffer */
-    if (sdiResponse.length() > 1) {
-        bus.clearBuffer();
+    uint16_t size = header.record_size;
+    int count = (segment.size() - sizeof(ArchiveHeader)) / size;
+
+    // first record at or after from - records are in the order they were written
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        uint32_t timestamp = 0;
+        segment.seek(sizeof(ArchiveHeader) + (uint32_t)mid * size);
+        segment.read((uint8_t *)&timestamp, sizeof(uint32_t));
+        if (timestamp < from) lo = mid + 1;
+        else hi = mid;
     }
-    delay(2000);        // delay between taking reading and requesting data
-    sdiResponse = "";    // clear response string (to get ready to read data)
 
-    myCommand = String(sensor_address) + "D0!";         // string to request data from last measurement
-    bus.sendCommand(myCommand);
-    delay(30);      // wait for a response
-
-    while (bus.available()) {
-        char c = bus.read();
-        if ((c != '\n') && (c != '\r')) {
-            sdiResponse += c;
-            delay(10);          // 1 character ~ 7.5ms
-        }
+    int got = 0;
+    segment.seek(sizeof(ArchiveHeader) + (uint32_t)lo * size);
+    for (int i = lo; i < count && got < max; i++) {
+        memset(&records[got], 0, sizeof(HourlyRecord));
+        if (segment.read((uint8_t *)&records[got], size) != size) break;
+        if (records[got].timestamp >= to) break;
+        got++;
     }
+    segment.close();
+    return got;
+}
 
-    sdiResponse = sdiResponse.substring(3);
-
-    for (int i = 0; i < sdiResponse.length(); i++) {
-        char c = sdiResponse.charAt(i);
-        if (c == '+') {
-            sdiResponse.setCharAt(i, ',');  // replace any + with ,
+/**
+ * helper function
+ * remove every archive segment listed in the index, the month folders and the index
+*/
+void RemoteLogger::wipe_archive(){
+    File index = SD.open(ARCHIVE_INDEX, FILE_READ);
+    if (index) {
+        ArchiveEntry entry;
+        char path[32];
+        while (index.read((uint8_t *)&entry, sizeof(ArchiveEntry)) == sizeof(ArchiveEntry)) {
+            archive_path(entry.day, path);
+            SD.remove(path);
+            path[9] = '\0';
+            SD.rmdir(path);         // only goes once the month's last day is removed
         }
+        index.close();
     }
+    SD.remove(ARCHIVE_INDEX);
+    SD.rmdir("/LOG");
+}
 
-    /* clear buffer */
-    if (sdiResponse.length() > 1) {
-        bus.clearBuffer();
-    }
 
-    if (sdiResponse == ""){
-        sdiResponse = "-9,-9,-9";   // no reading
-    }
 
-    bus.clearBuffer();
 
-    return sdiResponse;
-}
+/* ADAPTIVE SAMPLING */
 
 /**
- * sample measurements from OTT PLS
- * returns water level, water temp, ott status
+ * decide whether this wake's sample goes to the hourly store, from how fast one parameter is changing
+ * call every wake after sampling, in place of increment_samples / num_samples / write_hourly
+ * the last ADAPT_WINDOW samples of the parameter chosen in setAdaptive are kept with the counters, and:
+ *   event   - changing at rate_per_h or faster, or just crossed level: every sample is written, and the
+ *             first sample of an event asks plan_send for an early send; events last ADAPT_HOLD samples
+ *             after the last trigger so a peak isn't cut short
+ *   flat    - changing at less than a quarter of rate_per_h: a row every setBaseHours hours
+ *   normal  - a row every hour (60 / sample_freq_m samples)
+ * with setAdaptive off (the default) this is the usual row every hour
+ * rows are no longer an hour apart, so auto_send queues binary messages (which carry each row's time)
  * 
- * bus: SDI12 object, has been started by the user with attached datapin
- * sensor_address: address of sensor, factory default 0 (see OTT docs to change)
+ * time: time of the sample
+ * msmt: the sample
+ * returns ADAPT_EVENT or ADAPT_HOURLY if the sample was written to the hourly store, ADAPT_SKIP if not
  */
-String RemoteLogger::sample_ott_M(SDI12 bus, int sensor_address){
-    myCommand = String(sensor_address) + "M!";      // first command to take a measurement
-
-    bus.sendCommand(myCommand);
-    delay(30);
+byte RemoteLogger::adaptive_sample(DateTime time, Measurement *msmt){
+    if (!load_state()) return ADAPT_SKIP;
+    state.samples_since_hourly++;
+    add_to_stats(msmt);
+
+    int per_hour = sampleFreqM < 60 ? 60 / sampleFreqM : 1;
+    int every = per_hour;
+    bool event = false;
+
+    if (adaptParam >= 0 && adaptParam < msmt->count && msmt->values[adaptParam] != NO_READING) {
+        float value = msmt->values[adaptParam];
+
+        // keep the window, oldest first
+        if (state.recent_count == ADAPT_WINDOW) {
+            memmove(state.recent, state.recent + 1, (ADAPT_WINDOW - 1) * sizeof(float));
+            memmove(state.recent_time, state.recent_time + 1, (ADAPT_WINDOW - 1) * sizeof(uint32_t));
+            state.recent_count--;
+        }
+        float prev = state.recent_count > 0 ? state.recent[state.recent_count - 1] : value;
+        state.recent[state.recent_count] = value;
+        state.recent_time[state.recent_count] = time.unixtime();
+        state.recent_count++;
+
+        // rate of change across the window, per hour
+        float rate = 0;
+        uint32_t span = state.recent_time[state.recent_count - 1] - state.recent_time[0];
+        if (state.recent_count > 1 && span > 0) {
+            rate = fabs(value - state.recent[0]) * 3600.0 / span;
+        }
 
-    while(bus.available()){     // build response string
-        char c = bus.read();
-        if ((c != '\n') && (c != '\r')) {
-            sdiResponse += c;
-            delay(10);      // 1 character = ~7.5 ms
+        bool crossed = !isnan(adaptLevel) && (prev < adaptLevel) != (value < adaptLevel);
+        if (crossed || (adaptRate > 0 && rate >= adaptRate)) {
+            if (state.event_hold == 0) state.event_send = 1;        // new event - send early
+            state.event_hold = ADAPT_HOLD;
+        } else if (state.event_hold > 0) {
+            state.event_hold--;
         }
+
+        event = state.event_hold > 0;
+        if (!event && rate < adaptRate / 4) every = per_hour * baseHours;
     }
 
-    // clear buffer
-    if(sdiResponse.length() > 1){
-        bus.clearBuffer();
+    byte written = ADAPT_SKIP;
+    if (event || state.samples_since_hourly >= every) {
+        state.samples_since_hourly = 0;
+        save_state();
+        write_hourly(time, msmt);
+        written = event ? ADAPT_EVENT : ADAPT_HOURLY;
+    } else {
+        save_state();
     }
-    delay(2000);        // wait for sensor to take measurement
-    sdiResponse = "";   // clear response string
+    return written;
+}
 
-    // next command to request data
-    myCommand = String(sensor_address) + "D0!";
+/**
+ * true while adaptive_sample is in an event
+ */
+bool RemoteLogger::in_event(){
+    return load_state() && state.event_hold > 0;
+}
 
-    bus.sendCommand(myCommand);
-    delay(30);
+/**
+ * turn on adaptive sampling (see adaptive_sample)
+ * 
+ * param: which sampled value to watch, 0 for the first one after batt_v and memory (-1 turns it off)
+ * rate_per_h: change per hour (in the parameter's units) that starts an event - 0 for none
+ * level: crossing this value starts an event (e.g. a flood stage) - leave out for none
+ */
+void RemoteLogger::setAdaptive(int param, float rate_per_h, float level){
+    adaptParam = param;
+    adaptRate = rate_per_h;
+    adaptLevel = level;
+}
 
-    while(bus.available()){
-        char c = bus.read();
-        if ((c != '\n') && (c != '\r')) {
-            sdiResponse += c;
-            delay(10);      // 1 character = ~7.5 ms
-        }
-    }
+/**
+ * hours between hourly rows while the parameter is flat (default 1 - no thinning)
+ */
+void RemoteLogger::setBaseHours(int hours){
+    baseHours = hours > 0 ? hours : 1;
+}
 
-    // subset string
-    sdiResponse = sdiResponse.substring(3);
 
-    // replace + with ,
-    for (int i = 0; i < sdiResponse.length(); i++) {
-        char c = sdiResponse.charAt(i);
-        if (c == '+') {
-            sdiResponse.setCharAt(i, ',');
-        }
-    }
 
-    // clear buffer
-    if(sdiResponse.length() > 1){
-        bus.clearBuffer();
-    }
 
-    if(sdiResponse == ""){      // no data
-        sdiResponse = "-9,-9,-9";
-    }
+/* TELEMETRY */
 
-    return sdiResponse;
+/**
+ * send provided message over the Iridium network
+ * connect Iridium sleep pin (7 - grey) to pin 13 or change value of IridSlpPin
+ * TODO: investigate -- did removing the Watchdog mess things up? try it with the TPL
+*/
+int RemoteLogger::send_msg(String myMsg){
+    return modem_send(myMsg.c_str(), NULL, 0);
 }
 
 /**
- * sample system test information 
- * returns relative humidity, dew (?), deg (?) of OTT - see docs
+ * send a binary message (from prep_binary_msg) over the Iridium network
+ * same modem handling and send counters as send_msg
  * 
- * bus: SDI12 object, has been started by the user with attached datapin
- * sensor_address: address of sensor, factory default 0 (see OTT docs to change)
- */
-String RemoteLogger::sample_ott_V(SDI12 bus, int sensor_address){
-    myCommand = String(sensor_address) + "V!";      // first command to take a measurement
+ * msg: message bytes
+ * len: number of bytes (340 at most)
+*/
+int RemoteLogger::send_binary_msg(const uint8_t *msg, int len){
+    return modem_send(NULL, msg, len);
+}
+
+/**
+ * test the Iridium modem + connection by sending a message
+ * sends "Hello world" + provided message
+ * will print firmware version and test signal quality
+ * if any functions fail it will leave the function immediately 
+ * warning that this will attempt to send a message and use credits
+ * prints status messages to Serial - does not return any status information from function
+*/
+void RemoteLogger::irid_test(String msg){
+    digitalWrite(IridSlpPin, HIGH);         // turn on modem
+    idle_wait(2000);        // wait for modem to start up
+
+    int signalQuality = -1;     // need this to pass in for signal quality query
 
-    bus.sendCommand(myCommand);
-    delay(30);
+    IridiumSerial.begin(19200);
+    modem.setPowerProfile(IridiumSBD::USB_POWER_PROFILE);
 
-    while(bus.available()){     // build response string
-        char c = bus.read();
-        if ((c != '\n') && (c != '\r')) {
-            sdiResponse += c;
-            delay(10);      // 1 character = ~7.5 ms
+    /* begin satellite modem operation */
+    Serial.println(" - starting modem...");
+    int err = modem.begin();
+    if (err != ISBD_SUCCESS) {
+        Serial.print(" - begin failed: error ");
+        Serial.println(err);
+        if (err == ISBD_NO_MODEM_DETECTED) {
+            Serial.println(" - no modem detected: check wiring.");
         }
+        return;     // leave the function - no point in trying to send
     }
 
-    // clear buffer
-    if(sdiResponse.length() > 1){
-        bus.clearBuffer();
+    /* print the firmware version */
+    char version[12];
+    err = modem.getFirmwareVersion(version, sizeof(version));
+    if (err != ISBD_SUCCESS) {      // didn't get version info
+        Serial.print(" - firmware version failed: error ");
+        Serial.println(err);
+        return;     // leave the test function
     }
-    delay(2000);        // wait for sensor to take measurement
-    sdiResponse = "";   // clear response string
-
-    // next command to request data
-    myCommand = String(sensor_address) + "D0!";
-
-    bus.sendCommand(myCommand);
-    delay(30);
+    Serial.print(" - firmware version is ");
+    Serial.print(version);
+    Serial.println(".");
 
-    while(bus.available()){
-        char c = bus.read();
-        if ((c != '\n') && (c != '\r')) {
-            sdiResponse += c;
-            delay(10);      // 1 character = ~7.5 ms
+    /* get signal quality */
+    int n = 0;
+    while (n < 10) {    // test signal quality 10 times
+        err = modem.getSignalQuality(signalQuality);    // query signal quality
+        if (err != ISBD_SUCCESS) {
+            Serial.print(" - signalQuality failed: error ");
+            Serial.println(err);
+            return;        // leave the test function
         }
+        Serial.print(" - signal quality is currently ");
+        Serial.print(signalQuality);
+        Serial.println(".");
+        n++;
+        low_power_wait(1000, false);        // modem is talking - stay on serial
     }
 
-    // subset string
-    sdiResponse = sdiResponse.substring(3);
-
-    // replace + with ,
-    for (int i = 0; i < sdiResponse.length(); i++) {
-        char c = sdiResponse.charAt(i);
-        if (c == '+') {
-            sdiResponse.setCharAt(i, ',');
+    /* send the message */
+    Serial.print(" - Attempting: ");
+    msg = "Hello world! " + msg;
+    Serial.println(msg);
+    err = modem.sendSBDText(msg.c_str());
+    if (err != ISBD_SUCCESS) {
+        Serial.print(" - sendSBDText failed: error ");
+        Serial.println(err);
+        if (err == ISBD_SENDRECEIVE_TIMEOUT) {
+            Serial.println(" - try again with a better view of the sky.");
         }
+    } else {
+        Serial.println(" - hey, it worked!");
     }
 
-    // clear buffer
-    if(sdiResponse.length() > 1){
-        bus.clearBuffer();
-    }
+    /* sync clock to Iridium */
+    Serial.println("Sync clock to Iridium");
+    sync_clock();
+    
+}
+
+/**
+ * prepare message from hourly data file to send via Iridium to database
+ * actual data values are multiplied by varying powers of 10 to remove decimals
+ * see documentation for letter-to-header mappings and multipliers
+ * 
+ * if there are more records in the hourly store than allowable in a single message, will send only
+ * the most recent (e.g. if max in message is 8 and 10 data samples, will send samples 3-10)
+ * fewer are sent if the most recent ones would not fit in the 340 byte message, and only the run of
+ * rows an hour apart that ends with the most recent (the message has the first row's time only)
+ * returns an empty string if there is nothing in the hourly store
+ * 
+ * e.g. 
+ * Data file: 
+ * datetime,batt_v,memory,water_level_mm,water_temp_c,water_ec_dcm
+ * 2001-01-10T01:11:05,4.31,24627,10,18.7,3
+ * 
+ * Message:
+ * ABC:01011001:431,246,10,187,3:
+*/
+String RemoteLogger::prep_msg(){
+    PhaseTimer timer(*this, PHASE_PREP);
+    int maxInMsg = 18;
 
-    if(sdiResponse == ""){      // no data
-        sdiResponse = "-9,-9,-9";
+    if (!sd_ready()) return "";
+
+    int num_rows = num_hours();
+    if (num_rows == 0) return "";
+
+    HourlyRecord record;
+    char value[16];         // one formatted value
+
+    open_hourly();
+    // fixed part of the message: letters, datetime, battery, memory (from the most recent record)
+    read_hourly(num_rows - 1, &record);
+    int fixed = text_fixed_size(&record);
+
+    // walk back from the most recent record until the message is full
+    int first = num_rows;       // where to start adding data to message (limit message size)
+    int used = fixed;
+    uint32_t next_time = record.timestamp;      // time of the row after the one being added
+    while (first > 0 && num_rows - first < maxInMsg) {
+        read_hourly(first - 1, &record);
+        // the text format only has the first row's hour - stop where the rows stop being an hour apart (as text_rows_fit)
+        if (first < num_rows && (next_time - record.timestamp < 3000 || next_time - record.timestamp > 4200)) break;
+        next_time = record.timestamp;
+        int row = 0;
+        for (int i = 0; i < myParams; i++) {
+            if (param_multiplier(i) != 0) row += format_msg_value(value, record.values[i], param_multiplier(i)) + 1;
+        }
+        if (used + row > (int)sizeof(msgBuf) - 2) break;
+        used += row;
+        first--;
     }
+    if (first == num_rows) first = num_rows - 1;        // always send the most recent
 
-    return sdiResponse;
+    build_text_msg(first, num_rows - first);
+    close_hourly();
+    return String(msgBuf);
 }
 
 /**
- * sample all 6 parameters from OTT PLS
- * returns water level, water temp, status, RH, dew, deg 
- * corresponds to default OTT header (see docs)
- * 
- * bus: SDI12 object, has been started by the user with attached datapin
- * sensor_address: address of sensor, factory default 0 (see OTT docs to change)
+ * prepare message in same format as usual but with only the most recent sample written to hourly data file
+ * intended for use during low power mode as absolute minimum amount of data transfer
+ * returns an empty string if there is nothing in the hourly store
  */
-String RemoteLogger::sample_ott(SDI12 bus, int sensor_address){
-    String sample;
-    sample.reserve(30);
-    sample = sample_ott_M(bus, sensor_address) + "," + sample_ott_V(bus, sensor_address);
+String RemoteLogger::low_pwr_prep_msg(){
+    PhaseTimer timer(*this, PHASE_PREP);
+    if (!sd_ready()) return "";
 
-    return sample;
+    int num_rows = num_hours();
+    if (num_rows == 0) return "";
+
+    open_hourly();
+    build_text_msg(num_rows - 1, 1);        // only the most recent record
+    close_hourly();
+    return String(msgBuf);
 }
 
 /**
- * sample turbidity from Analite 195 sensor
- * must be attached to two digital outputs (wiper set/unset) and one analog input (data pin)
- * the analog input pin does not need to be set to input 
+ * prepare a compact binary message from the hourly store, for send_binary_msg
+ * holds the same data as prep_msg (values * multipliers, rounded) but as bytes instead of text:
+ * each row is stored as the change from the row before, in as few bytes as the change needs,
+ * so several times more hours fit in one message than with prep_msg (no 18 row limit)
+ * as many of the most recent records are included as fit in len bytes (up to 255)
  * 
- * wiper frequency is tied to hourly writes to the CSV
- * will run wiper once every four power cycles (once per hour with 15 min TPL)
+ * layout (multi-byte fields little endian):
+ *   0       format version (BINARY_MSG_VERSION)
+ *   1-2     schema id - CRC-16 of letters and multipliers, see binary_schema_id
+ *   3-6     time of the first row, seconds since 1970
+ *   7       number of rows
+ *   varint  battery voltage * 100 (most recent)
+ *   varint  free memory * 0.01 (most recent)
+ *   rows    varint seconds since previous row (0 for first), then one varint per sent parameter:
+ *           the value for the first row, the change from the previous row after that
+ *   varints are zig-zag encoded: 0,-1,1,-2... become 0,1,2,3... then 7 bits per byte, high bit = more
  * 
- * analogDataPin: analog input for data read from Analite 195
- * wiperSetPin: digital output pin for wiper set on Analite 195 (see Analite docs for setup)
- * wiperUnsetPin: digital output pin for wiper unset on Analite 195 (see Analite docs for setup)
- */
-String RemoteLogger::sample_analite_195(int analogDataPin, int wiperSetPin, int wiperUnsetPin){
-    // set up pins in case the user didn't
-    pinMode(wiperSetPin, OUTPUT);
-    pinMode(wiperUnsetPin, OUTPUT);
+ * buf: where to write the message
+ * len: size of buf - 340 for a single SBD message
+ * returns the number of bytes written, 0 if there is nothing in the hourly store
+*/
+int RemoteLogger::prep_binary_msg(uint8_t *buf, int len){
+    PhaseTimer timer(*this, PHASE_PREP);
+    if (!sd_ready()) return 0;
+
+    int num_rows = num_hours();
+    if (num_rows == 0 || len < BINARY_HEADER_BYTES + 16) return 0;
+
+    HourlyRecord record, prev;
+    open_hourly();
+    read_hourly(num_rows - 1, &record);
+    int fixed = binary_fixed_size(&record);
+    long batt = scale_msg_value(record.batt_v, BATT_MULT);          // from the most recent row
+    long memory = scale_msg_value(record.memory, MEM_MULT);
+
+    // walk back from the most recent record until the message is full, encoding each row as it is read
+    // rows after the first are stored as changes, so they go in from the end of buf and only the first
+    // row's size depends on where it starts
+    int first = num_rows - 1;
+    int end = len;                  // changes for rows first+1 .. newest are in buf[end .. len)
+    while (first > 0 && num_rows - first < 255) {
+        if (!read_hourly(first - 1, &prev)) break;
+        int change = binary_row(NULL, &record, &prev);          // record is row first
+        if (fixed + (len - end) + change + binary_row(NULL, &prev, NULL) > len) break;
+        end -= change;
+        binary_row(buf + end, &record, &prev);
+        record = prev;
+        first--;
+    }
+    close_hourly();
 
-    analogReadResolution(12);
-    float values[10];
+    // header and the first row whole, then the changes moved down behind them
+    int n = rl_codec::put_binary_header(buf, binary_schema_id(), record.timestamp, num_rows - first, batt, memory);
+    n += binary_row(buf + n, &record, NULL);
+    memmove(buf + n, buf + end, len - end);
+    return n + len - end;
+}
 
-    // check how many lines in tracker file
-    int samplesSinceHourly = num_samples();
-    if (samplesSinceHourly == 4){     // it's been an hour -- time to wipe
-        digitalWrite(wiperSetPin, HIGH); delay(150); 
-        digitalWrite(wiperSetPin, LOW); delay(50);
-        digitalWrite(wiperUnsetPin, HIGH); delay(50);
-        digitalWrite(wiperUnsetPin, LOW); delay(50); delay(14000);      // wait for wipe cycle - 6 seconds ish
-    } else {    // not wiping, just make sure it's off
-        digitalWrite(wiperUnsetPin, HIGH); delay(20);
-        digitalWrite(wiperUnsetPin, LOW); delay(20);
-    }
 
-    // sample 10 values from sensor
-    for(int i = 0; i < 10; i++){
-        values[i] = (float)analogRead(analogDataPin);       // read from probe
-        delay(5);
-    }
 
-    float medTurbAlog = stats.median(values, 10);       // compute median 12-bit analog value
 
-    // convert from analog value to NTU with provided calibration coefficients
-    /** TODO: this just reads it straight across - need to add the calibration stuff */
-    float ntuAnalog = medTurbAlog;
-    int ntuInt = round(ntuAnalog);      // round to an integer
+/* MODEM SESSION */
 
-    analogReadResolution(10);       /** TODO: what is this useful for? */
+// logger the modem's waits belong to - for ISBDCallback
+static RemoteLogger *modemLogger = NULL;
 
-    return String(ntuInt);
+/**
+ * power up the modem for a session of several sends - the 2 s start up and network search are paid once
+ * follow with session_send for each message, session_receive, then always end_session
+ * send_msg, send_binary_msg and send_outbox each run a whole session themselves
+ * returns the error from modem.begin()
+ */
+int RemoteLogger::begin_session(){
+    sessionErr = ISBD_NO_NETWORK;
+    return modem_start();
 }
 
 /**
- * sample range from MaxBotix MB7369 ultrasonic ranger
- * attach to 2 digital outputs and 1 digital input 
- * use a PWM pin for input (all pins but A1, A5 on Feather M0 Adalogger, see docs for other boards)
- * returns minimum of 10 samples
- * 
- * powerPin: digital output controlling ranger power, see ranger docs for setup
- * triggerPin: digital output controlling ranger active time, see ranger docs for setup
- * pulseInputPin: digital input to collect data, see ranger docs for setup
- * 
- * TODO: should this be returned as a string for continuity? or left as long for memory efficiency?
+ * send a text message in the open session
+ * anything waiting for the logger comes back in the same exchange and is applied (see apply_params)
+ * returns the error from the modem, ISBD_SUCCESS if the message went
  */
-String RemoteLogger::sample_ultrasonic(int powerPin, int triggerPin, int pulseInputPin){
-    pinMode(powerPin, OUTPUT);
-    digitalWrite(powerPin, HIGH); delay(500);   // turn on the ranger
+int RemoteLogger::session_send(const char *text){
+    return link_send(&iridium, (const uint8_t *)text, strlen(text), false);
+}
 
-    // set up pins
-    pinMode(triggerPin, OUTPUT);
-    pinMode(pulseInputPin, INPUT);
+/**
+ * send a binary message (e.g. from prep_binary_msg) in the open session, as session_send(text)
+ */
+int RemoteLogger::session_send(const uint8_t *data, int len){
+    return link_send(&iridium, data, len, true);
+}
 
-    float values[10];
-    digitalWrite(triggerPin, HIGH);     // start the ranger
-    delay(30);
+/**
+ * pick up messages still waiting for the logger after the sends, up to MT_MAX_PER_SESSION
+ * only checks the mailbox if the last send reported messages waiting, so it costs nothing otherwise
+ * returns the number of messages received
+ */
+int RemoteLogger::session_receive(){
+    return link_receive(&iridium);
+}
 
-    for(int i = 0; i < 10; i++){
-        int32_t duration = pulseIn(pulseInputPin, HIGH);    // get pulse duration -- time of flight
-        values[i] = duration;
-        delay(150);     // don't sample too quickly < 7.5Hz
-    }
-    digitalWrite(triggerPin, LOW);      // stop the ranger
+/**
+ * end the session: sync the RTC to Iridium time if anything got through, put the modem to sleep,
+ * and update the send counters (a success if at least one message went)
+ */
+void RemoteLogger::end_session(){
+    modem_stop(sessionErr);
+}
 
-    long minDistance = stats.minimum(values, 10);       // get the minimum of the sampled values
+/**
+ * power up the modem now, at the start of a wake that will send, so the 2 s start up and the network search
+ * happen while the sensors sample rather than after them
+ * the sampling functions (run_jobs and the rest) begin the modem once it is up and ask for its signal quality
+ * between the sensors' steps - the first session then starts straight away, and the signal seen is kept for
+ * the transmission scheduler even if the send doesn't happen
+ * call it before the sampling, e.g. if plan_send says SEND_NOW; sleep_modem if nothing is sent after all
+ */
+void RemoteLogger::warm_modem(){
+    if (modemWarm != MODEM_OFF) return;
+    sessionSignal = -1;
+    modemLogger = this;
+    if (profile.modem_before_mv == 0) profile.modem_before_mv = sample_batt_v() * 1000;     // for the modem's energy cost
+    digitalWrite(IridSlpPin, HIGH);
+    modemWarmMs = now_ms();
+    modemWarm = MODEM_POWERING;
+}
 
-    digitalWrite(powerPin, LOW); delay(50);     // turn off the ranger
-    return String(minDistance);
+/**
+ * put a modem powered by warm_modem back to sleep without a session
+ * the signal quality it saw is kept for the scheduler, but no send is counted
+ */
+void RemoteLogger::sleep_modem(){
+    if (modemWarm == MODEM_OFF) return;
+    add_phase_time(PHASE_MODEM_ON, (now_ms() - modemWarmMs) * 1000UL);
+    modemWarm = MODEM_OFF;
+    profile.modem_after_mv = sample_batt_v() * 1000;
+    digitalWrite(IridSlpPin, LOW);
+    if (sessionSignal >= 0 && load_state()) {
+        state.last_signal = sessionSignal;
+        save_state();
+    }
 }
 
 /**
- * sample temperature and relative humidity from Adafruit SHT31 sensor
- * hook SHT31 up to I2C
- * 
- * sensor: Adafruit_SHT31 object, does not have to be started
- * sensorAddress: address of the SHT31 sensor, factory options 0x44 or 0x45
+ * function the IridiumSBD library calls while it waits on the modem (its ISBDCallback, defined by the library)
+ * keeps a sketch's own callback, e.g. to feed a watchdog - returning false cancels the modem operation
  */
-String RemoteLogger::sample_sht31(Adafruit_SHT31 sensor, int sensorAddress){
-    if (!sensor.begin(sensorAddress)) {
-        return "-9,-9";         // no data - couldn't find the sensor
-    }    
-    sensor.heater(0);
-    float t = sensor.readTemperature();
-    float h = sensor.readHumidity(); 
-    
-    String sample = String(t) + "," + String(h);
-    return sample;
+void RemoteLogger::setModemCallback(bool (*callback)()){
+    modemCallback = callback;
 }
 
 /**
- * sample temperature from DS18B20
- * must be set up on a digital pin as a OneWire device 
- * 
- * sensors: DallasTemperature array of sensors set up on OneWire device
- * sensorIndex: position of sensor to sample in the array of sensors (first is 0, check docs)
+ * called by the IridiumSBD library while it waits on the modem
+ * steps the sensors of a wake that warmed the modem (warm_modem), then the sketch's callback (setModemCallback)
+ * weak, so a sketch with its own ISBDCallback still links - but its callback replaces this one, and the
+ * sensors then wait for the modem instead of running alongside it
  */
-String RemoteLogger::sample_DS18B20(DallasTemperature sensors, int sensorIndex){
-    sensors.requestTemperatures();
-    float temp = sensors.getTempCByIndex(sensorIndex);
-    return String(temp);
+bool __attribute__((weak)) ISBDCallback(){
+    return modemLogger == NULL || modemLogger->modem_callback();
 }
 
 
 
 
-/* PRIVATE HELPERS */
+/* REMOTE CONFIGURATION */
 
 /**
- * helper function 
- * sync RTC to system time from Iridium RockBlock modem
-*/
-void RemoteLogger::sync_clock(){
+ * change settings from a message sent to the logger (e.g. from the RockBLOCK portal), or from the sketch
+ * same layout as PARAM.txt: a line of setting names, then a line of values - "sample_freq_m,irid_freq_h\n15,6"
+ * the lines can also be separated with ; since some portals can't send a new line
+ * any of the settings can be left out, unknown names and values out of range are ignored
+ *   sample_freq_m   minutes between samples, 1-1440 (the sketch reads it with sample_freq_m())
+ *   irid_freq_h     hours between sends, 1-255 (used by plan_send/auto_send as min_rows)
+ * the settings are saved to /PARAM.txt and read back by begin(), so they last through power cycles
+ * 
+ * text: settings to apply
+ * returns true if any setting was changed
+ */
+bool RemoteLogger::apply_params(const char *text){
+    if (!parse_params(text)) return false;
+    write_params();
+    return true;
+}
+
+/**
+ * minutes between samples, from PARAM.txt or apply_params (default 15)
+ */
+int RemoteLogger::sample_freq_m(){
+    return sampleFreqM;
+}
+
+/**
+ * hours between sends, from PARAM.txt or apply_params (default 4)
+ * the same setting as min_rows in setSendBatch
+ */
+int RemoteLogger::irid_freq_h(){
+    return minSendRows;
+}
+
+
+
+
+/* TRANSMISSION SCHEDULER */
+
+/**
+ * decide what to do about sending this wake, from the battery, the send history and how much is waiting
+ *   SEND_DEFER      battery below the critical level (see setSendBattery), or still backing off after
+ *                   failed sends - each failure doubles the wait (1, 2, 4... hours, see setMaxBackoff),
+ *                   and a failure with no signal at all waits twice as long again
+ *   SEND_WAIT       fewer than min_rows hours waiting and nothing in the outbox (see setSendBatch),
+ *                   unless adaptive_sample has just seen an event start
+ *   SEND_LOW_POWER  battery below the low level - send just the most recent sample
+ *   SEND_NOW        send everything waiting
+ * does not use the modem - this is what decides whether it is worth turning it on
+ */
+byte RemoteLogger::plan_send(){
+    float batt = sample_batt_v();
+    if (batt < criticalBattV) return SEND_DEFER;
+
+    if (load_state() && state.next_send != 0) {
+        uint32_t next = state.next_send;
+        if (state.last_signal == 0 && state.failed_sends > 0) {         // no sky view last time - wait twice as long
+            uint32_t hours = state.failed_sends > 16 ? maxBackoffHours : 1UL << (state.failed_sends - 1);
+            if (hours > (uint32_t)maxBackoffHours) hours = maxBackoffHours;
+            next += hours * 3600;
+        }
+        if (rtc.now().unixtime() < next) return SEND_DEFER;
+    }
+
+    int waiting = num_outbox();
+    bool early = load_state() && state.event_send;     // an event has started (adaptive_sample)
+    if (waiting == 0 && num_hours() < minSendRows && !(early && num_hours() > 0)) return SEND_WAIT;
+
+    if (batt < lowBattV) return SEND_LOW_POWER;
+    return SEND_NOW;
+}
+
+/**
+ * decide with plan_send and do it:
+ *   SEND_NOW - queue the hourly store in the outbox and send up to max_frames messages from it
+ *   SEND_LOW_POWER - send only the most recent sample (as low_pwr_prep_msg), the rest is queued in the
+ *                    outbox for when the battery recovers
+ *   SEND_WAIT, SEND_DEFER - nothing, the modem stays off
+ * call once an hour after write_hourly (or every wake after adaptive_sample), in place of the send
+ * logic in the example loop
+ * returns the number of messages sent
+ */
+int RemoteLogger::auto_send(){
+    byte plan = plan_send();
+
+    bool binary = adaptParam >= 0;      // adaptive rows aren't an hour apart - binary messages keep their times
+
+    if (plan == SEND_NOW) {
+        queue_hourly(binary);
+        return send_outbox(maxSendFrames);
+    }
+
+    if (plan == SEND_LOW_POWER) {
+        String msg = low_pwr_prep_msg();
+        queue_hourly(binary);         // keep everything for later
+        if (msg.length() == 0) return 0;
+        return send_msg(msg) == ISBD_SUCCESS ? 1 : 0;
+    }
+
+    return 0;
+}
+
+/**
+ * signal quality (0-5) the modem reported in the last session, -1 if there hasn't been one
+ */
+int RemoteLogger::num_last_signal(){
+    if (!load_state() || state.last_signal == 255) return -1;
+    return state.last_signal;
+}
+
+/**
+ * battery levels for the transmission scheduler
+ * 
+ * low_v: below this only the most recent sample is sent (default 3.6 V)
+ * critical_v: below this the modem is not used at all (default 3.4 V)
+ */
+void RemoteLogger::setSendBattery(float low_v, float critical_v){
+    lowBattV = low_v;
+    criticalBattV = critical_v;
+}
+
+/**
+ * batching for the transmission scheduler
+ * 
+ * min_rows: hours to collect before sending (default 4)
+ * max_frames: most messages to send in one session (default 8)
+ */
+void RemoteLogger::setSendBatch(int min_rows, int max_frames){
+    minSendRows = min_rows;
+    maxSendFrames = max_frames;
+}
+
+/**
+ * longest wait between send attempts after failures, in hours (default 24)
+ */
+void RemoteLogger::setMaxBackoff(int hours){
+    maxBackoffHours = hours;
+}
+
+
+
+
+/* OUTBOX */
+
+/**
+ * move everything in the hourly store into the outbox as ready-to-send messages
+ * the hourly rows are split into as many messages as they need (text as from prep_msg, at most
+ * 18 rows each; binary as from prep_binary_msg), each no longer than every link can take (frame_bytes),
+ * and each message is saved to /OUTBOX.bin before its
+ * rows are removed from the hourly store, so nothing is lost if the power is cut part way
+ * the outbox keeps the newest OUTBOX_SLOTS messages - once full, the oldest unsent one is replaced
+ * 
+ * binary: true to queue binary messages, false (default) for text messages
+ * returns the number of messages added to the outbox
+ */
+int RemoteLogger::queue_hourly(bool binary){
+    PhaseTimer timer(*this, PHASE_PREP);
+    if (!sd_ready()) return 0;
+    if (!load_outbox()) return 0;
+
+    int queued = 0;
+    while (num_hours() > 0) {
+        int rows, len;
+        open_hourly();
+        if (binary) {
+            len = build_binary_msg((uint8_t *)msgBuf, frame_bytes(), &rows);
+        } else {
+            rows = text_rows_fit(frame_bytes());
+            len = build_text_msg(0, rows);
+        }
+        close_hourly();         // add_frame writes the store's header
+        if (!add_frame((const uint8_t *)msgBuf, len, binary, rows)) break;      // rows leave the store with it
+        queued++;
+    }
+
+    return queued;
+}
+
+/**
+ * send messages from the outbox in one session, over the cheapest link that is up (see add_transport)
+ * keeps sending while the link is good enough (for Iridium, OUTBOX_MIN_SIGNAL) and sends succeed, so a
+ * backlog from an outage goes out over this and later sessions; each message is marked sent on the card
+ * as soon as it goes, so a message is never sent twice after a power cut
+ * if a link can't send anything the next one is tried, so Iridium carries on where cell coverage stops
+ * send counters (num_failed_sends etc.) count the session a success if at least one message went
+ * 
+ * max_frames: most messages to send this session (each one uses credits)
+ * newest_first: true to send the most recent messages first, false (default) oldest first
+ * returns the number of messages sent
+ */
+int RemoteLogger::send_outbox(int max_frames, bool newest_first){
+    if (!sd_ready()) return 0;
+    int frames = num_outbox() + num_image_frames();
+    if (frames == 0) return 0;
+
+    byte order[MAX_TRANSPORTS];
+    bool loaded;
+    int tries = rank_transports(frames < max_frames ? frames : max_frames, frame_bytes(), order, &loaded);
+    int sent = 0;
+    sessionSignal = -1;
+    lastLink = "";
+
+    for (int i = 0; i < tries && sent == 0; i++) {
+        Transport *link = links[order[i]];
+        sessionErr = ISBD_NO_NETWORK;
+        int err = link->begin();
+        if (err == ISBD_SUCCESS) sent = send_frames(link, max_frames, newest_first, &err);
+        if (sent > 0) link_receive(link);
+        link->end(sessionErr);
+
+        if (sent > 0) lastLink = link->name;
+        if (!loaded) continue;          // no counters to keep without /STATE.bin
+
+        uint8_t &fails = state.link_fails[order[i]];
+        if (sent > 0) fails = 0;
+        else fails = fails < LINK_MAX_FAILS ? fails + 1 : LINK_MAX_FAILS;      // sits out the next sessions
+    }
+
+    count_session(sessionErr);
+    return sent;
+}
+
+/**
+ * number of messages in the outbox waiting to be sent
+ */
+int RemoteLogger::num_outbox(){
+    if (!load_outbox()) return 0;
+
+    int pending = 0;
+    for (int i = 0; i < OUTBOX_SLOTS; i++) {
+        if (outboxState[i] == OUTBOX_PENDING) pending++;
+    }
+    return pending;
+}
+
+/**
+ * throw away every message in the outbox, sent or not
+ */
+void RemoteLogger::clear_outbox(){
+    SD.remove("/OUTBOX.bin");
+    outboxLoaded = false;
+}
+
+
+
+
+/* TRANSPORTS */
+
+/**
+ * add a link for send_outbox to choose from, e.g. a SerialBridgeTransport to a cellular board
+ * each session goes over the link with the lowest cost for the messages waiting plus the cost of its
+ * latency (setLatencyCost), skipping links that failed their last LINK_MAX_FAILS sessions until they
+ * have sat out LINK_RETRY_SESSIONS; if that link can't send, the next one is tried, Iridium included
+ * outbox messages are cut to the shortest link's MTU (frame_bytes) so any of them can take them
+ * add links in the same order on every wake - their failures are kept with the counters by position
+ * 
+ * link: transport object, kept by the logger (make it a global)
+ * returns false if MAX_TRANSPORTS links have been added
+ */
+bool RemoteLogger::add_transport(Transport &link){
+    if (numLinks >= MAX_TRANSPORTS) return false;
+    links[numLinks++] = &link;
+    return true;
+}
+
+/**
+ * weigh latency against cost when choosing a link: a link's score for a session is the cost of
+ * the waiting messages plus per_hour times its latency in hours
+ * 
+ * per_hour: cost of an hour's delay in the links' cost unit (default 1, about a cent) - 0 to go by cost alone
+ */
+void RemoteLogger::setLatencyCost(float per_hour){
+    latencyCost = per_hour;
+}
+
+/**
+ * longest message every link can take, and so the longest message queue_hourly makes
+ * (OUTBOX_FRAME_BYTES at most)
+ */
+int RemoteLogger::frame_bytes(){
+    int bytes = OUTBOX_FRAME_BYTES;
+    for (int i = 0; i < numLinks; i++) {
+        if (links[i]->mtu < bytes) bytes = links[i]->mtu;
+    }
+    return bytes;
+}
+
+/**
+ * name of the link the last send_outbox session sent over ("iridium", "swarm", "bridge"...),
+ * "" if it sent nothing
+ */
+const char *RemoteLogger::last_transport(){
+    return lastLink;
+}
+
+/**
+ * power up the RockBLOCK and start talking to it, as begin_session
+ * returns ISBD_SUCCESS if it is ready, including if it was already awake
+ */
+int IridiumTransport::begin(){
+    int err = logger.begin_session();
+    return err == ISBD_ALREADY_AWAKE ? ISBD_SUCCESS : err;
+}
+
+/**
+ * ask the modem for its signal quality, noting it for the scheduler
+ * returns true if it is at least OUTBOX_MIN_SIGNAL
+ */
+bool IridiumTransport::link_up(){
+    int quality = 0;
+    if (logger.modem.getSignalQuality(quality) != ISBD_SUCCESS) return false;
+    logger.sessionSignal = quality;
+    return quality >= OUTBOX_MIN_SIGNAL;
+}
+
+/**
+ * one SBD session with the message, picking up a message waiting for the logger if there is one
+ */
+int IridiumTransport::send(const uint8_t *data, int len, bool binary, uint8_t *rx, size_t &rx_len){
+    if (binary) return logger.modem.sendReceiveSBDBinary(data, len, rx, rx_len);
+    return logger.modem.sendReceiveSBDText((const char *)data, rx, rx_len);
+}
+
+/**
+ * check the mailbox if the last session reported messages waiting, so it costs nothing otherwise
+ */
+int IridiumTransport::receive(uint8_t *rx, size_t &rx_len){
+    if (logger.modem.getWaitingMessageCount() <= 0) {
+        rx_len = 0;
+        return ISBD_SUCCESS;
+    }
+    return logger.modem.sendReceiveSBDText(NULL, rx, rx_len);      // mailbox check, nothing sent
+}
+
+/**
+ * sync the clock if the session got through and put the modem to sleep (not the send counters)
+ */
+void IridiumTransport::end(int err){
+    logger.modem_off(err);
+}
+
+
+
+
+/* IMAGE TELEMETRY */
+
+/**
+ * start saving a JPEG to the card for sending, named for its capture time (e.g. /24060112.jpg)
+ * follow with add_image_bytes as the image comes out of the camera, then end_image
+ * the image being sent carries on until end_image, so a capture cut short by the TPL loses nothing
+ * 
+ * time: capture time, sent in every frame header
+ * lines, columns: image resolution, sent in every frame header
+ * returns false if the file couldn't be created
+ */
+bool RemoteLogger::begin_image(DateTime time, uint16_t lines, uint16_t columns){
+    if (imageFile) imageFile.close();
+    if (!sd_ready()) return false;
+
+    snprintf(imageName, sizeof(imageName), "/%02d%02d%02d%02d.jpg", time.year() % 100, time.month(), time.day(), time.hour());
+    if (load_image() && image.total > 0 && strcmp(image.name, imageName) == 0) {
+        image.total = 0;            // replacing the file the unsent image is cut from
+        save_image();
+    }
+    SD.remove(imageName);
+    imageFile = SD.open(imageName, FILE_WRITE);
+    if (!imageFile) return false;
+
+    imageTime = time;
+    imageLines = lines;
+    imageColumns = columns;
+    imageBytes = 0;
+    return true;
+}
+
+/**
+ * add the next len bytes of the JPEG started with begin_image
+ * e.g. each 256 bytes read from the ArduCAM FIFO
+ * returns false if there is no image being saved, or it is too big to send (IMAGE_MAX_BYTES)
+ */
+bool RemoteLogger::add_image_bytes(const uint8_t *data, int len){
+    if (!imageFile) return false;
+    if (imageBytes + len > IMAGE_MAX_BYTES) {
+        imageBytes = IMAGE_MAX_BYTES + 1;           // end_image won't send it
+        return false;
+    }
+    imageFile.write(data, len);
+    imageBytes += len;
+    return true;
+}
+
+/**
+ * finish the JPEG started with begin_image and make it the image to send, replacing any image
+ * still being sent (frames already sent of that image aren't sent again)
+ * the frames go in as many sessions as they need: send_image, or whatever send_outbox (and so
+ * auto_send) has left over after the outbox
+ * returns the number of frames to send, 0 if the image was empty or too big
+ */
+int RemoteLogger::end_image(){
+    if (!imageFile) return 0;
+    imageFile.close();
+    if (imageBytes == 0 || imageBytes > IMAGE_MAX_BYTES) return 0;
+    if (!load_image()) return 0;
+
+    uint8_t id = image.id >= IMAGE_MAX_ID ? 1 : image.id + 1;
+    memcpy(image.name, imageName, sizeof(image.name));         // same size, null terminated
+    image.id = id;
+    image.total = (imageBytes + IMAGE_PAYLOAD_BYTES - 1) / IMAGE_PAYLOAD_BYTES;
+    image.year = imageTime.year() % 100;
+    image.month = imageTime.month();
+    image.day = imageTime.day();
+    image.hour = imageTime.hour();
+    image.lines = imageLines;
+    image.columns = imageColumns;
+    image.image_bytes = imageBytes;
+    memset(image.sent, 0, sizeof(image.sent));
+    save_image();
+    return image.total;
+}
+
+/**
+ * send frames of the image from end_image in one modem session
+ * frames already sent (in this or earlier wakes) are skipped, so calling this each wake finishes the image
+ * 
+ * max_frames: most frames to send in this session
+ * returns the number of frames sent
+ */
+int RemoteLogger::send_image(int max_frames){
+    if (!sd_ready()) return 0;
+    if (num_image_frames() == 0) return 0;
+
+    int err = begin_session();
+    int sent = send_image_frames(&iridium, max_frames, &err);
+    if (sent > 0) session_receive();
+    end_session();
+    return sent;
+}
+
+/**
+ * number of frames of the image still to send, 0 if there is no image
+ */
+int RemoteLogger::num_image_frames(){
+    if (!load_image()) return 0;
+    int left = 0;
+    for (int i = 0; i < image.total; i++) {
+        if (!(image.sent[i / 8] & (1 << (i % 8)))) left++;
+    }
+    return left;
+}
+
+/**
+ * stop sending the current image (the JPEG stays on the card)
+ */
+void RemoteLogger::clear_image(){
+    if (!load_image()) return;
+    image.total = 0;
+    save_image();
+}
+
+
+
+
+/* SAMPLING FUNCTIONS */
+
+/**
+ * sample from Hydros21 sensor
+ * same as the Measurement version below, returned as a String
+ * 
+ * bus: valid SDI12 bus initialized with the data pin attached to Hydros sensor, must have had begin() called already
+ * sensor_address: SDI-12 address of the Hydros sensor, usually assumed to be 0
+*/
+String RemoteLogger::sample_hydros_M(SDI12 &bus, int sensor_address){
+    Measurement msmt;
+    msmt.count = 0;
+    msmt.status = SAMPLE_OK;
+    sample_hydros_M(bus, sensor_address, &msmt);
+    return values_to_string(&msmt);
+}
+
+/**
+ * sample measurements from OTT PLS
+ * returns water level, water temp, ott status
+ * 
+ * bus: SDI12 object, has been started by the user with attached datapin
+ * sensor_address: address of sensor, factory default 0 (see OTT docs to change)
+ */
+String RemoteLogger::sample_ott_M(SDI12 &bus, int sensor_address){
+    Measurement msmt;
+    msmt.count = 0;
+    msmt.status = SAMPLE_OK;
+    sdi12_measure(bus, sensor_address, 'M', 3, &msmt);
+    return values_to_string(&msmt);
+}
+
+/**
+ * sample system test information 
+ * returns relative humidity, dew (?), deg (?) of OTT - see docs
+ * 
+ * bus: SDI12 object, has been started by the user with attached datapin
+ * sensor_address: address of sensor, factory default 0 (see OTT docs to change)
+ */
+String RemoteLogger::sample_ott_V(SDI12 &bus, int sensor_address){
+    Measurement msmt;
+    msmt.count = 0;
+    msmt.status = SAMPLE_OK;
+    sdi12_measure(bus, sensor_address, 'V', 3, &msmt);
+    return values_to_string(&msmt);
+}
+
+/**
+ * sample all 6 parameters from OTT PLS
+ * returns water level, water temp, status, RH, dew, deg 
+ * corresponds to default OTT header (see docs)
+ * 
+ * bus: SDI12 object, has been started by the user with attached datapin
+ * sensor_address: address of sensor, factory default 0 (see OTT docs to change)
+ */
+String RemoteLogger::sample_ott(SDI12 &bus, int sensor_address){
+    String sample;
+    sample.reserve(30);
+    sample = sample_ott_M(bus, sensor_address) + "," + sample_ott_V(bus, sensor_address);
+
+    return sample;
+}
+
+/**
+ * sample turbidity from Analite 195 sensor
+ * same as the Measurement version below, returned as a String
+ */
+String RemoteLogger::sample_analite_195(int analogDataPin, int wiperSetPin, int wiperUnsetPin){
+    Measurement msmt;
+    msmt.count = 0;
+    msmt.status = SAMPLE_OK;
+    sample_analite_195(analogDataPin, wiperSetPin, wiperUnsetPin, &msmt);
+    return String((int)msmt.values[0]);
+}
+
+/**
+ * sample range from MaxBotix MB7369 ultrasonic ranger
+ * same as the Measurement version below, returned as a String
+ * 
+ * TODO: should this be returned as a string for continuity? or left as long for memory efficiency?
+ */
+String RemoteLogger::sample_ultrasonic(int powerPin, int triggerPin, int pulseInputPin){
+    Measurement msmt;
+    msmt.count = 0;
+    msmt.status = SAMPLE_OK;
+    sample_ultrasonic(powerPin, triggerPin, pulseInputPin, &msmt);
+    return String((long)msmt.values[0]);
+}
+
+#ifndef RL_NO_SHT31
+/**
+ * sample temperature and relative humidity from Adafruit SHT31 sensor
+ * same as the Measurement version below, returned as a String
+ */
+String RemoteLogger::sample_sht31(Adafruit_SHT31 sensor, int sensorAddress){
+    Measurement msmt;
+    msmt.count = 0;
+    msmt.status = SAMPLE_OK;
+    if (sample_sht31(sensor, sensorAddress, &msmt) != SAMPLE_OK) {
+        return "-9,-9";         // no data - couldn't find the sensor
+    }
+    String sample = String(msmt.values[0]) + "," + String(msmt.values[1]);
+    return sample;
+}
+#endif
+
+#ifndef RL_NO_DS18B20
+/**
+ * sample temperature from DS18B20
+ * same as the Measurement version below, returned as a String
+ */
+String RemoteLogger::sample_DS18B20(DallasTemperature &sensors, int sensorIndex){
+    Measurement msmt;
+    msmt.count = 0;
+    msmt.status = SAMPLE_OK;
+    if (sample_DS18B20(sensors, sensorIndex, &msmt) != SAMPLE_OK) {
+        return String(DEVICE_DISCONNECTED_C);
+    }
+    return String(msmt.values[0]);
+}
+#endif
+
+
+
+
+/* MEASUREMENTS */
+
+/**
+ * start a new measurement: samples battery voltage and free memory and clears the sampled values
+ * call this first, then each sampling function in the same order as the parameters in the header
+ * 
+ * msmt: Measurement to fill, usually one declared once at the top of the sketch
+ */
+void RemoteLogger::start_measurement(Measurement *msmt){
+    msmt->batt_v = sample_batt_v();
+    msmt->memory = sample_memory();
+    msmt->count = 0;
+    msmt->status = SAMPLE_OK;
+}
+
+/**
+ * add one value to a measurement
+ * sampling functions use this; call it directly for sensors that don't have a library function
+ * returns SAMPLE_FULL if the measurement already holds MAX_PARAMS values
+ */
+byte RemoteLogger::add_value(Measurement *msmt, float value){
+    if (msmt->count >= MAX_PARAMS) {
+        if (msmt->status == SAMPLE_OK) msmt->status = SAMPLE_FULL;
+        return SAMPLE_FULL;
+    }
+    msmt->values[msmt->count++] = value;
+    return SAMPLE_OK;
+}
+
+/**
+ * sample from Hydros21 sensor into a measurement
+ * adds water level, water temp, electrical conductivity (NO_READING for any the sensor didn't return)
+ * 
+ * bus: valid SDI12 bus initialized with the data pin attached to Hydros sensor, must have had begin() called already
+ * sensor_address: SDI-12 address of the Hydros sensor, usually assumed to be 0
+ * msmt: measurement to add the values to
+ */
+byte RemoteLogger::sample_hydros_M(SDI12 &bus, int sensor_address, Measurement *msmt){
+    return sdi12_measure(bus, sensor_address, 'M', 3, msmt);
+}
+
+/**
+ * sample all 6 parameters from OTT PLS into a measurement
+ * adds water level, water temp, status, RH, dew, deg (NO_READING for any the sensor didn't return)
+ * 
+ * bus: SDI12 object, has been started by the user with attached datapin
+ * sensor_address: address of sensor, factory default 0 (see OTT docs to change)
+ * msmt: measurement to add the values to
+ */
+byte RemoteLogger::sample_ott(SDI12 &bus, int sensor_address, Measurement *msmt){
+    byte status = sdi12_measure(bus, sensor_address, 'M', 3, msmt);
+    byte status_v = sdi12_measure(bus, sensor_address, 'V', 3, msmt);
+    return status != SAMPLE_OK ? status : status_v;
+}
+
+/**
+ * sample turbidity from Analite 195 sensor into a measurement
+ * must be attached to two digital outputs (wiper set/unset) and one analog input (data pin)
+ * the analog input pin does not need to be set to input 
+ * 
+ * wiper frequency is tied to hourly writes to the CSV
+ * will run wiper once every four power cycles (once per hour with 15 min TPL)
+ * 
+ * analogDataPin: analog input for data read from Analite 195
+ * wiperSetPin: digital output pin for wiper set on Analite 195 (see Analite docs for setup)
+ * wiperUnsetPin: digital output pin for wiper unset on Analite 195 (see Analite docs for setup)
+ * msmt: measurement to add the turbidity to
+ */
+byte RemoteLogger::sample_analite_195(int analogDataPin, int wiperSetPin, int wiperUnsetPin, Measurement *msmt){
+    PhaseTimer timer(*this, PHASE_ANALITE);
+    SampleJob job;
+    set_analite_job(&job, analogDataPin, wiperSetPin, wiperUnsetPin);
+    return run_job_list(&job, 1, msmt);
+}
+
+/**
+ * how the ultrasonic ranger is sampled (sample_ultrasonic and add_ultrasonic_job)
+ * 
+ * burst: pulses timed per sample, at most ULTRASONIC_MAX_BURST (default 10)
+ * filter: RANGE_MIN, RANGE_MEDIAN or RANGE_TRIMMED_MIN (default RANGE_MIN)
+ */
+void RemoteLogger::setUltrasonic(int burst, byte filter){
+    if (burst < 1) burst = 1;
+    if (burst > ULTRASONIC_MAX_BURST) burst = ULTRASONIC_MAX_BURST;
+    ultrasonicBurst = burst;
+    ultrasonicFilter = filter;
+}
+
+/**
+ * sample range from MaxBotix MB7369 ultrasonic ranger into a measurement
+ * attach to 2 digital outputs and 1 digital input 
+ * use a PWM pin for input (all pins but A1, A5 on Feather M0 Adalogger, see docs for other boards)
+ * adds the minimum of 10 pulses, or as set by setUltrasonic
+ * on the SAMD21 the pulses are timed by pin interrupt while the CPU idles, otherwise with pulseIn
+ * 
+ * powerPin: digital output controlling ranger power, see ranger docs for setup
+ * triggerPin: digital output controlling ranger active time, see ranger docs for setup
+ * pulseInputPin: digital input to collect data, see ranger docs for setup
+ * msmt: measurement to add the range to
+ */
+byte RemoteLogger::sample_ultrasonic(int powerPin, int triggerPin, int pulseInputPin, Measurement *msmt){
+    PhaseTimer timer(*this, PHASE_ULTRASONIC);
+    SampleJob job;
+    set_ultrasonic_job(&job, powerPin, triggerPin, pulseInputPin);
+    return run_job_list(&job, 1, msmt);
+}
+
+#ifndef RL_NO_SHT31
+/**
+ * sample temperature and relative humidity from Adafruit SHT31 sensor into a measurement
+ * hook SHT31 up to I2C
+ * adds temperature, relative humidity (NO_READING for both if the sensor can't be found)
+ * 
+ * sensor: Adafruit_SHT31 object, does not have to be started
+ * sensorAddress: address of the SHT31 sensor, factory options 0x44 or 0x45
+ * msmt: measurement to add the values to
+ */
+byte RemoteLogger::sample_sht31(Adafruit_SHT31 &sensor, int sensorAddress, Measurement *msmt){
+    PhaseTimer timer(*this, PHASE_SHT31);
+    SampleJob job;
+    set_sht31_job(&job, sensor, sensorAddress);
+    return run_job_list(&job, 1, msmt);
+}
+#endif
+
+#ifndef RL_NO_DS18B20
+/**
+ * sample temperature from DS18B20 into a measurement
+ * must be set up on a digital pin as a OneWire device 
+ * adds the temperature (NO_READING if the probe is disconnected)
+ * 
+ * sensors: DallasTemperature array of sensors set up on OneWire device
+ * sensorIndex: position of sensor to sample in the array of sensors (first is 0, check docs)
+ * msmt: measurement to add the temperature to
+ */
+byte RemoteLogger::sample_DS18B20(DallasTemperature &sensors, int sensorIndex, Measurement *msmt){
+    PhaseTimer timer(*this, PHASE_DS18B20);
+    SampleJob job;
+    set_DS18B20_job(&job, sensors, sensorIndex);
+    return run_job_list(&job, 1, msmt);
+}
+#endif
+
+/**
+ * register a measurement on the SDI-12 bus for sample_sdi12_bus
+ * values are added to the Measurement in the order sensors are registered
+ * register once in setup - the list is kept until clear_sdi12_sensors
+ * 
+ * sensor_address: SDI-12 address, 0-9 or a character ('a' to 'z', 'A' to 'Z')
+ * num_values: number of values the measurement returns (3 for Hydros21, 3 for each OTT command)
+ * command: measurement command without the address - default "C" (concurrent), or e.g. "C1", "M", "V"
+ *          register the same address twice for sensors that need two commands (OTT: "C" then "V")
+ * returns false if the list is full or the command is too long
+ */
+bool RemoteLogger::add_sdi12_sensor(int sensor_address, byte num_values, const char *command){
+    if (numSdi12Sensors >= SDI12_MAX_SENSORS || strlen(command) > 2) return false;
+
+    SDI12Entry *entry = &sdi12Sensors[numSdi12Sensors++];
+    entry->address = sensor_address < 10 ? '0' + sensor_address : sensor_address;
+    strcpy(entry->command, command);
+    entry->num_values = num_values;
+    entry->state = SDI12_DONE;
+    return true;
+}
+
+/**
+ * forget every sensor registered with add_sdi12_sensor
+ */
+void RemoteLogger::clear_sdi12_sensors(){
+    numSdi12Sensors = 0;
+}
+
+/**
+ * sample every sensor registered with add_sdi12_sensor into a measurement
+ * concurrent (C) measurements are started on every address at once and each sensor's data is
+ * collected as soon as it is ready, so the bus takes as long as its slowest sensor instead of the sum
+ * M and V measurements need the bus to themselves and are run one at a time afterwards
+ * 
+ * bus: SDI12 bus with all the sensors attached, must have had begin() called already
+ * msmt: measurement to add the values to (NO_READING for any a sensor didn't return)
+ * returns the first status other than SAMPLE_OK from any sensor
+ */
+byte RemoteLogger::sample_sdi12_bus(SDI12 &bus, Measurement *msmt){
+    PhaseTimer timer(*this, PHASE_SDI12);
+    SampleJob job;
+    set_sdi12_job(&job, bus);
+    return run_job_list(&job, 1, msmt);
+}
+
+// measurement commands for each driver, and the values each gives - a generic sensor's count comes from the sensor
+struct SDI12Driver {
+    const char *vendor;         // matched anywhere in the aI! reply
+    const char *model;
+    const char *commands[2];
+    byte num_values[2];
+};
+
+static const SDI12Driver sdi12Drivers[] = {
+    {"", "", {"C", NULL}, {0, 0}},                  // SDI12_GENERIC
+    {"", "", {"M", NULL}, {0, 0}},                  // SDI12_GENERIC_M
+    {"METER", "HYD", {"C", NULL}, {3, 0}},          // SDI12_HYDROS21
+    {"OTT", "PLS", {"C", "V"}, {3, 3}},             // SDI12_OTT_PLS
+};
+
+/**
+ * find every sensor on the SDI-12 bus and register its measurements for sample_sdi12_bus and add_sdi12_job,
+ * in place of any registered with add_sdi12_sensor
+ * every address is asked for an acknowledgement (a!) and an identity (aI!) once, and the sensors found are
+ * saved in /SDI12.bin, so later wakes go straight to measuring - search again after changing the sensors
+ * the commands come from the identity: C on a HYDROS 21, C then V on an OTT PLS, and one C measurement
+ * (M if the sensor can't do C) of as many values as it says for anything else - M in place of C for a
+ * sensor alone on the bus, which is quicker without other sensors to measure alongside
+ * values are in address order (0-9, a-z, A-Z), and a sensor keeps its columns even if it stops answering
+ * 
+ * bus: SDI12 bus with all the sensors attached, must have had begin() called already
+ * search: search the bus even if sensors are saved (takes a few seconds)
+ * returns the number of sensors, 0 if there are none
+ */
+int RemoteLogger::find_sdi12_bus(SDI12 &bus, bool search){
+    bool saved = load_sdi12_map() && sdi12Map.count > 0;
+    if (!saved || search) {
+        PhaseTimer timer(*this, PHASE_SDI12);
+        const char *addresses = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        sdi12Map.count = 0;
+        for (const char *a = addresses; *a && sdi12Map.count < SDI12_MAX_DEVICES; a++) {
+            if (sdi12_identify(bus, *a, &sdi12Map.devices[sdi12Map.count])) sdi12Map.count++;
+        }
+        if (sdi12Map.count > 0 || saved) save_sdi12_map();
+    }
+    register_sdi12_devices();
+    return sdi12Map.count;
+}
+
+/**
+ * identity of a sensor found by find_sdi12_bus, from its aI! reply: SDI-12 version, vendor, model and
+ * sensor version, e.g. "13METER   HYD21 400" - for the sketch to check the sensors or name the columns
+ * 
+ * device: position among the sensors found (from 0)
+ * returns "" if there is no such sensor
+ */
+const char *RemoteLogger::sdi12_identity(int device){
+    if (!load_sdi12_map() || device < 0 || device >= sdi12Map.count) return "";
+    return sdi12Map.devices[device].identity;
+}
+
+/**
+ * give a sensor a new SDI-12 address (aAb!), e.g. to put a second sensor straight from the factory on
+ * the bus - connect them one at a time, changing each before adding the next
+ * the sensors saved by find_sdi12_bus follow the change
+ * 
+ * from_address, to_address: SDI-12 addresses, 0-9 or a character ('a' to 'z', 'A' to 'Z')
+ * returns false if the new address is taken or the sensor didn't confirm it
+ */
+bool RemoteLogger::change_sdi12_address(SDI12 &bus, int from_address, int to_address){
+    char from = from_address < 10 ? '0' + from_address : from_address;
+    char to = to_address < 10 ? '0' + to_address : to_address;
+    char cmd[5] = {to, '!', '\0'};
+    char response[8];
+
+    bus.clearBuffer();
+    if (sdi12_transaction(bus, cmd, response, sizeof(response)) > 0) return false;      // someone already there
+
+    cmd[0] = from;
+    cmd[1] = 'A';
+    cmd[2] = to;
+    cmd[3] = '!';
+    bus.clearBuffer();
+    if (sdi12_transaction(bus, cmd, response, sizeof(response)) == 0 || response[0] != to) return false;
+
+    if (load_sdi12_map()) {
+        for (int i = 0; i < sdi12Map.count; i++) {
+            if (sdi12Map.devices[i].address == from) {
+                sdi12Map.devices[i].address = to;
+                save_sdi12_map();
+                register_sdi12_devices();
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+#ifndef RL_NO_DS18B20
+/**
+ * find the probes on a DS18B20 chain, for sample_DS18B20_chain and add_DS18B20_chain_job
+ * the bus is searched once and the ROM addresses are saved in /DS18B20.bin, so later wakes go straight
+ * to the probes (no bus search, and no sensors.begin() needed) - search again after adding or replacing a probe
+ * probes keep the order they were found in, and so their columns, even if one stops answering
+ * 
+ * sensors: DallasTemperature on the chain's OneWire bus
+ * search: search the bus even if a chain is saved
+ * returns the number of probes, 0 if there are none
+ */
+int RemoteLogger::find_DS18B20_chain(DallasTemperature &sensors, bool search){
+    bool saved = load_probe_chain() && probes.count > 0;
+    if (saved && !search) return probes.count;
+
+    PhaseTimer timer(*this, PHASE_DS18B20);
+    sensors.begin();            // counts the probes
+    int found = sensors.getDeviceCount();
+    probes.count = 0;
+    for (int i = 0; i < found && probes.count < DS18B20_MAX_PROBES; i++) {
+        uint8_t *rom = probes.rom[probes.count];
+        if (!sensors.getAddress(rom, i)) continue;
+        byte bits = sensors.getResolution(rom);
+        probes.bits[probes.count++] = bits >= 9 && bits <= 12 ? bits : 12;
+    }
+    if (probes.count > 0 || saved) save_probe_chain();
+    return probes.count;
+}
+
+/**
+ * set the resolution of probes on the chain: 9 bits (94 ms conversion, 0.5 C) to 12 bits (750 ms, 0.0625 C)
+ * the whole chain converts at once, so it takes as long as its finest probe
+ * a probe keeps its resolution (in its EEPROM), and it is only written when it changes - fine to call every wake
+ * 
+ * sensors: DallasTemperature on the chain's OneWire bus
+ * probe: position in the chain (from 0), or -1 for every probe
+ * bits: 9 to 12
+ * returns false if there is no such probe
+ */
+bool RemoteLogger::setDS18B20Resolution(DallasTemperature &sensors, int probe, byte bits){
+    if (bits < 9 || bits > 12 || probe < -1) return false;
+    if (find_DS18B20_chain(sensors) <= probe) return false;
+
+    bool changed = false;
+    for (int i = 0; i < probes.count; i++) {
+        if ((probe >= 0 && i != probe) || probes.bits[i] == bits) continue;
+        if (!sensors.setResolution(probes.rom[i], bits)) continue;
+        probes.bits[i] = bits;
+        changed = true;
+    }
+    if (changed) save_probe_chain();
+    return true;
+}
+
+/**
+ * sample every probe on a DS18B20 chain into temps, in the order find_DS18B20_chain found them
+ * one conversion is started on every probe at once and slept through, then each probe is read by its
+ * address - three probes take one conversion time instead of three, and no bus search
+ * the chain is found first if it hasn't been
+ * 
+ * sensors: DallasTemperature on the chain's OneWire bus
+ * temps: filled with a temperature per probe, NO_READING for a probe that didn't answer
+ * max: size of temps
+ * returns the number of probes that answered
+ */
+int RemoteLogger::sample_DS18B20_chain(DallasTemperature &sensors, float *temps, int max){
+    PhaseTimer timer(*this, PHASE_DS18B20);
+    SampleJob job;
+    set_DS18B20_chain_job(&job, sensors);
+    Measurement msmt;
+    msmt.count = 0;
+    msmt.status = SAMPLE_OK;
+    run_job_list(&job, 1, &msmt);
+
+    for (int i = 0; i < msmt.count && i < max; i++) temps[i] = msmt.values[i];
+    return job.count;
+}
+
+/**
+ * sample every probe on a DS18B20 chain into a measurement - same as above, a value per probe
+ * returns SAMPLE_NO_RESPONSE if any probe didn't answer (or none were found)
+ */
+byte RemoteLogger::sample_DS18B20_chain(DallasTemperature &sensors, Measurement *msmt){
+    PhaseTimer timer(*this, PHASE_DS18B20);
+    SampleJob job;
+    set_DS18B20_chain_job(&job, sensors);
+    return run_job_list(&job, 1, msmt);
+}
+#endif
+
+
+
+
+/* SAMPLING SCHEDULER */
+
+/**
+ * add a MaxBotix MB7369 ultrasonic ranger to the sampling schedule (same pins as sample_ultrasonic)
+ * returns false if the schedule is full
+ */
+bool RemoteLogger::add_ultrasonic_job(int powerPin, int triggerPin, int pulseInputPin){
+    if (numJobs >= MAX_JOBS) return false;
+    set_ultrasonic_job(&jobs[numJobs++], powerPin, triggerPin, pulseInputPin);
+    return true;
+}
+
+/**
+ * add an Analite 195 turbidity sensor to the sampling schedule (same pins as sample_analite_195)
+ * returns false if the schedule is full
+ */
+bool RemoteLogger::add_analite_job(int analogDataPin, int wiperSetPin, int wiperUnsetPin){
+    if (numJobs >= MAX_JOBS) return false;
+    set_analite_job(&jobs[numJobs++], analogDataPin, wiperSetPin, wiperUnsetPin);
+    return true;
+}
+
+/**
+ * add every sensor registered with add_sdi12_sensor to the sampling schedule
+ * only one SDI-12 job can be scheduled (the registered sensors are shared)
+ * returns false if the schedule is full
+ */
+bool RemoteLogger::add_sdi12_job(SDI12 &bus){
+    if (numJobs >= MAX_JOBS) return false;
+    set_sdi12_job(&jobs[numJobs++], bus);
+    return true;
+}
+
+#ifndef RL_NO_SHT31
+/**
+ * add an Adafruit SHT31 to the sampling schedule (same parameters as sample_sht31)
+ * returns false if the schedule is full
+ */
+bool RemoteLogger::add_sht31_job(Adafruit_SHT31 &sensor, int sensorAddress){
+    if (numJobs >= MAX_JOBS) return false;
+    set_sht31_job(&jobs[numJobs++], sensor, sensorAddress);
+    return true;
+}
+#endif
+
+#ifndef RL_NO_DS18B20
+/**
+ * add a DS18B20 to the sampling schedule (same parameters as sample_DS18B20)
+ * returns false if the schedule is full
+ */
+bool RemoteLogger::add_DS18B20_job(DallasTemperature &sensors, int sensorIndex){
+    if (numJobs >= MAX_JOBS) return false;
+    set_DS18B20_job(&jobs[numJobs++], sensors, sensorIndex);
+    return true;
+}
+
+/**
+ * add every probe of a DS18B20 chain to the sampling schedule, a value each (as sample_DS18B20_chain)
+ * the conversion runs alongside the other sensors
+ * returns false if the schedule is full
+ */
+bool RemoteLogger::add_DS18B20_chain_job(DallasTemperature &sensors){
+    if (numJobs >= MAX_JOBS) return false;
+    set_DS18B20_chain_job(&jobs[numJobs++], sensors);
+    return true;
+}
+#endif
+
+/**
+ * empty the sampling schedule
+ */
+void RemoteLogger::clear_jobs(){
+    numJobs = 0;
+    for (int i = 0; i < MAX_JOBS; i++) taskPeriod[i] = 0;
+}
+
+/**
+ * sample every scheduled sensor into a measurement, all at the same time
+ * each sensor is a small state machine (power on, settle, trigger, collect, power off) and the
+ * waits of one sensor are spent running the others, so the wake takes about as long as the slowest
+ * sensor instead of the sum of them - e.g. the ultrasonic and SDI-12 sensors sample during the Analite wipe
+ * values are added in the order the sensors were scheduled, whatever order they finish in
+ * a sensor given a period with setJobPeriod only samples when it is due, and adds NO_READING otherwise
+ * 
+ * msmt: measurement to add the values to, after start_measurement
+ * returns the first status other than SAMPLE_OK from any sensor
+ */
+byte RemoteLogger::run_jobs(Measurement *msmt){
+    PhaseTimer timer(*this, PHASE_JOBS);
+
+    uint16_t skip = 0;
+    bool taken = false;
+    uint32_t now = 0;
+    for (int i = 0; i < numJobs; i++) {
+        if (taskPeriod[i] == 0) continue;           // every wake
+        if (now == 0) {
+            if (!load_state()) break;               // no card - sample everything
+            now = rtc.now().unixtime();
+        }
+        if (slot_due(i, now, true)) taken = true;
+        else skip |= 1 << i;
+    }
+    if (taken) save_state();            // before sampling, so a reset part way doesn't sample twice
+
+    return run_job_list(jobs, numJobs, msmt, skip);
+}
+
+/**
+ * format a measurement as a line for DATA.csv: timestamp,batt_v,memory,param1,...
+ * written into a buffer inside the logger - the returned pointer is only good until the next call
+ * values are written with up to 3 decimal places, trailing zeroes dropped
+ * 
+ * time: timestamp for the start of the line
+ * msmt: measurement filled by start_measurement and the sampling functions
+ */
+const char *RemoteLogger::format_measurement(DateTime time, Measurement *msmt){
+    int len = snprintf(recordBuf, sizeof(recordBuf), "%04d-%02d-%02dT%02d:%02d:%02d,",
+        time.year(), time.month(), time.day(), time.hour(), time.minute(), time.second());
+    len += format_float(recordBuf + len, msmt->batt_v, 3);
+    recordBuf[len++] = ',';
+    len += format_float(recordBuf + len, msmt->memory, 0);
+
+    for (int i = 0; i < msmt->count; i++) {
+        if (len > (int)sizeof(recordBuf) - 16) break;       // out of room - shouldn't happen with MAX_PARAMS values
+        recordBuf[len++] = ',';
+        len += format_float(recordBuf + len, msmt->values[i], 3);
+    }
+    recordBuf[len] = '\0';
+
+    return recordBuf;
+}
+
+/**
+ * write a measurement to a CSV file, same as write_to_csv without building any Strings
+ * the logger header is written first if the file is new
+ * 
+ * time: timestamp for the start of the line
+ * msmt: measurement filled by start_measurement and the sampling functions
+ * outname: name of the CSV file (e.g. /DATA.csv)
+ */
+void RemoteLogger::write_measurement(DateTime time, Measurement *msmt, const char *outname){
+    const char *line = format_measurement(time, msmt);
+    append_log(outname, mySchema ? NULL : myHeader.c_str(), line);
+}
+
+
+
+/* TASK SCHEDULER */
+
+/**
+ * give a scheduled sensor its own sampling period, so one wake schedule can sample e.g. the level
+ * every 5 minutes and a DS18B20 chain once an hour - wake at the shortest period (arm_wake_timer)
+ * and run_jobs only samples the sensors that are due, adding NO_READING for the others
+ * a sensor samples once in each period, at the first wake in it; when it last sampled is kept
+ * with the counters, so the schedule carries on across power cycles
+ * 
+ * job: the sensor, in the order it was added to the schedule (0 is the first add_*_job)
+ * period_s: sampling period in seconds, 0 to sample on every wake (the default)
+ * phase_s: offset of the periods in seconds, e.g. 1800 with a 3600 s period for half past each hour
+ * returns false if there is no such sensor
+ */
+bool RemoteLogger::setJobPeriod(int job, unsigned long period_s, unsigned long phase_s){
+    if (job < 0 || job >= numJobs) return false;
+    taskPeriod[job] = period_s;
+    taskPhase[job] = phase_s;
+    return true;
+}
+
+/**
+ * add a periodic task for the sketch to check with task_due, e.g. a transmission every 6 hours
+ * tasks are numbered in the order they are added - add them in the same order on every wake
+ * 
+ * period_s: period in seconds
+ * phase_s: offset of the periods in seconds (see setJobPeriod)
+ * returns the task for task_due, -1 if MAX_TASKS have been added or the period is 0
+ */
+int RemoteLogger::add_task(unsigned long period_s, unsigned long phase_s){
+    if (numTasks >= MAX_TASKS || period_s == 0) return -1;
+    taskPeriod[MAX_JOBS + numTasks] = period_s;
+    taskPhase[MAX_JOBS + numTasks] = phase_s;
+    return numTasks++;
+}
+
+/**
+ * check whether a task is due: true the first time it is asked in each of its periods, then false
+ * until the next period starts (the period is marked as done right away)
+ * 
+ * task: from add_task
+ */
+bool RemoteLogger::task_due(int task){
+    if (task < 0 || task >= numTasks || !load_state()) return false;
+    if (!slot_due(MAX_JOBS + task, rtc.now().unixtime(), true)) return false;
+    save_state();
+    return true;
+}
+
+/**
+ * remove every task, including the Analite wipe period
+ */
+void RemoteLogger::clear_tasks(){
+    for (int i = 0; i < MAX_TASKS; i++) taskPeriod[MAX_JOBS + i] = 0;
+    numTasks = 0;
+    wipeTask = -1;
+}
+
+/**
+ * run the Analite wiper on its own period instead of every fourth sample, e.g. every 4 hours
+ * adds a task, so call it in the same place among the add_task calls on every wake
+ * 
+ * period_s: period between wipes in seconds, 0 to go back to every fourth sample
+ * phase_s: offset of the periods in seconds (see setJobPeriod)
+ */
+void RemoteLogger::setWipePeriod(unsigned long period_s, unsigned long phase_s){
+    if (period_s == 0) {
+        wipeTask = -1;
+        return;
+    }
+    wipeTask = add_task(period_s, phase_s);
+}
+
+/**
+ * seconds until the next scheduled sensor or task is due, by the RTC
+ * returns 0 if one is due now, -1 if none has a period
+ */
+long RemoteLogger::secs_to_next_task(){
+    if (!load_state()) return -1;
+    uint32_t now = rtc.now().unixtime();
+
+    long next = -1;
+    for (int i = 0; i < TASK_SLOTS; i++) {
+        unsigned long period = taskPeriod[i];
+        if (period == 0) continue;
+        if (slot_due(i, now, false)) return 0;
+
+        uint32_t phase = taskPhase[i] % period;
+        uint32_t start = phase + ((now - phase) / period + 1) * period;     // start of the next period
+        long wait = (long)(start - now);
+        if (next < 0 || wait < next) next = wait;
+    }
+    return next;
+}
+
+/**
+ * set the PCF8523 countdown timer to wake the logger when the next sensor or task is due
+ * call it just before tpl_done, with the PCF8523 INT pin wired to the TPL5110 DELAY/M_DRV pin
+ * the timer counts whole seconds up to 255 s, then whole minutes, then hours, rounding down -
+ * a wake that comes early finds nothing due and should just arm the timer again
+ * returns false if nothing has a period (the TPL5110's own interval still applies)
+ */
+bool RemoteLogger::arm_wake_timer(){
+    long secs = secs_to_next_task();
+    if (secs < 0) return false;
+    if (secs < 1) secs = 1;
+
+    rtc.deconfigureAllTimers();
+    if (secs <= 255) {
+        rtc.enableCountdownTimer(PCF8523_FrequencySecond, secs);
+    } else if (secs / 60 <= 255) {
+        rtc.enableCountdownTimer(PCF8523_FrequencyMinute, secs / 60);
+    } else {
+        rtc.enableCountdownTimer(PCF8523_FrequencyHour, secs / 3600 > 255 ? 255 : secs / 3600);
+    }
+    return true;
+}
+
+/**
+ * wait in standby until the next scheduled sensor or task is due, for sketches that stay powered
+ * and loop instead of being cut off by the TPL5110 (see setStandbyThreshold)
+ * returns right away if something is due or nothing has a period
+ */
+void RemoteLogger::wait_for_next_task(){
+    long secs = secs_to_next_task();
+    if (secs > 0) idle_wait(secs * 1000UL);
+}
+
+
+
+
+/* PRIVATE HELPERS */
+
+/**
+ * helper function 
+ * sync RTC to system time from Iridium RockBlock modem
+*/
+void RemoteLogger::sync_clock(){
     struct tm t;
     int err_time = modem.getSystemTime(t);
     if (err_time == ISBD_SUCCESS) {
@@ -861,17 +2730,2281 @@ void RemoteLogger::sync_clock(){
 
 /**
  * helper function
- * generate string for argument to CSV parser 
- * format e.g. "sffff" for a string column and four float columns
- * 
- * TODO: could change this so it directly produces a char array rather than a String -- convert it every time anyway
+ * reserve every job's values in the measurement, then step the jobs until all are done
+ * waiting between steps until the next job needs attention
+ * jobs with their bit set in skip keep their NO_READING values and aren't run
+*/
+byte RemoteLogger::run_job_list(SampleJob *list, int n, Measurement *msmt, uint16_t skip){
+    for (int i = 0; i < n; i++) {
+        SampleJob *job = &list[i];
+        job->offset = msmt->count;
+        job->step = (skip >> i) & 1 ? JOB_DONE : 0;
+        job->status = SAMPLE_OK;
+        job->wake_ms = now_ms();
+        job->listening = false;
+        if (job->type == JOB_SDI12) job->num_values = sdi12_reset_entries();     // sensors may have been registered since
+#ifndef RL_NO_DS18B20
+        if (job->type == JOB_DS18B20_CHAIN) job->num_values = find_DS18B20_chain(*(DallasTemperature *)job->device);
+#endif
+        for (int j = 0; j < job->num_values; j++) {
+            if (add_value(msmt, NO_READING) == SAMPLE_FULL) job->status = SAMPLE_FULL;
+        }
+    }
+
+    while (true) {
+        bool running = false;
+        bool listening = false;
+        unsigned long next = 0;
+
+        step_due_jobs(list, n, msmt);
+        for (int i = 0; i < n; i++) {
+            SampleJob *job = &list[i];
+            if (job->step == JOB_DONE) continue;
+
+            if (!running || (long)(job->wake_ms - next) < 0) next = job->wake_ms;
+            running = true;
+            if (job->listening) listening = true;
+        }
+        if (!running) break;
+
+        // a modem warming up (warm_modem) is begun and asked for its signal between the sensors' steps
+        if (modemWarm == MODEM_POWERING || modemWarm == MODEM_READY) {
+            unsigned long due = modem_due_ms();
+            if (modem_warm_due()) {
+                modem_warm_step(list, n, msmt);
+                continue;
+            }
+            if ((long)(due - next) < 0) next = due;
+            if (modemWarm == MODEM_READY) listening = true;     // its serial port is open
+        }
+
+        long wait = (long)(next - now_ms());
+        if (wait > 0) low_power_wait(wait, !listening);       // standby only if no sensor is due to talk
+    }
+
+    byte status = SAMPLE_OK;
+    for (int i = 0; i < n; i++) {
+        if (status == SAMPLE_OK) status = list[i].status;
+    }
+    if (msmt->status == SAMPLE_OK) msmt->status = status;
+    return status;
+}
+
+/**
+ * helper function
+ * step every job that is due - from run_job_list, and from ISBDCallback while a warm modem talks
+*/
+void RemoteLogger::step_due_jobs(SampleJob *list, int n, Measurement *msmt){
+    for (int i = 0; i < n; i++) {
+        SampleJob *job = &list[i];
+        if (job->step != JOB_DONE && (long)(now_ms() - job->wake_ms) >= 0) step_job(job, msmt);
+    }
+}
+
+/**
+ * helper function
+ * run one job until it next has to wait, setting wake_ms for when it wants to run again
+*/
+void RemoteLogger::step_job(SampleJob *job, Measurement *msmt){
+    switch (job->type) {
+        case JOB_ULTRASONIC: step_ultrasonic(job, msmt); break;
+        case JOB_ANALITE: step_analite(job, msmt); break;
+        case JOB_SDI12: step_sdi12(job, msmt); break;
+#ifndef RL_NO_SHT31
+        case JOB_SHT31: step_sht31(job, msmt); break;
+#endif
+#ifndef RL_NO_DS18B20
+        case JOB_DS18B20: step_DS18B20(job, msmt); break;
+        case JOB_DS18B20_CHAIN: step_DS18B20_chain(job, msmt); break;
+#endif
+        default: job->step = JOB_DONE; break;
+    }
+}
+
+/**
+ * helper function
+ * write a job's value into its reserved place in the measurement
+*/
+void RemoteLogger::set_job_value(SampleJob *job, Measurement *msmt, int index, float value){
+    if (job->offset + index < MAX_PARAMS) msmt->values[job->offset + index] = value;
+}
+
+/**
+ * helper functions
+ * fill in a job for each kind of sensor
+*/
+void RemoteLogger::set_ultrasonic_job(SampleJob *job, int powerPin, int triggerPin, int pulseInputPin){
+    job->type = JOB_ULTRASONIC;
+    job->num_values = 1;
+    job->pins[0] = powerPin;
+    job->pins[1] = triggerPin;
+    job->pins[2] = pulseInputPin;
+}
+
+void RemoteLogger::set_analite_job(SampleJob *job, int analogDataPin, int wiperSetPin, int wiperUnsetPin){
+    job->type = JOB_ANALITE;
+    job->num_values = 1;
+    job->pins[0] = analogDataPin;
+    job->pins[1] = wiperSetPin;
+    job->pins[2] = wiperUnsetPin;
+}
+
+void RemoteLogger::set_sdi12_job(SampleJob *job, SDI12 &bus){
+    job->type = JOB_SDI12;
+    job->num_values = 0;
+    for (int i = 0; i < numSdi12Sensors; i++) job->num_values += sdi12Sensors[i].num_values;
+    job->device = &bus;
+}
+
+#ifndef RL_NO_SHT31
+void RemoteLogger::set_sht31_job(SampleJob *job, Adafruit_SHT31 &sensor, int sensorAddress){
+    job->type = JOB_SHT31;
+    job->num_values = 2;
+    job->device = &sensor;
+    job->address = sensorAddress;
+}
+#endif
+
+#ifndef RL_NO_DS18B20
+void RemoteLogger::set_DS18B20_job(SampleJob *job, DallasTemperature &sensors, int sensorIndex){
+    job->type = JOB_DS18B20;
+    job->num_values = 1;
+    job->device = &sensors;
+    job->address = sensorIndex;
+}
+
+void RemoteLogger::set_DS18B20_chain_job(SampleJob *job, DallasTemperature &sensors){
+    job->type = JOB_DS18B20_CHAIN;
+    job->num_values = 0;        // the probes found, worked out when it runs
+    job->device = &sensors;
+    job->count = 0;
+}
+#endif
+
+#ifdef ARDUINO_ARCH_SAMD
+// pulse widths timed by interrupt - one ranger at a time, as the handler has no way to find its job
+static volatile uint16_t rangeWidths[ULTRASONIC_MAX_BURST];
+static volatile byte rangeCount = 0;
+static volatile byte rangeWanted = 0;
+static volatile unsigned long rangeRiseUs = 0;
+static volatile int rangePin = -1;          // pin being timed, -1 if none
+
+static void range_edge(){
+    unsigned long t = micros();
+    if (digitalRead(rangePin) == HIGH) {
+        rangeRiseUs = t;
+        return;
+    }
+    if (rangeRiseUs == 0 || rangeCount >= rangeWanted) return;          // armed partway through a pulse, or done
+    unsigned long width = t - rangeRiseUs;
+    rangeRiseUs = 0;
+    rangeWidths[rangeCount++] = width > 0xFFFF ? 0xFFFF : width;
+}
+#endif
+
+/**
+ * helper function
+ * ultrasonic ranger: power on, settle 500 ms, trigger, time a burst of pulses 150 ms apart, power off
+ * the pulses are timed by pin interrupt with the CPU idle between them; pulseIn if the pin has no
+ * interrupt, another ranger is using it, or the board isn't a SAMD
+*/
+void RemoteLogger::step_ultrasonic(SampleJob *job, Measurement *msmt){
+    int powerPin = job->pins[0], triggerPin = job->pins[1], pulseInputPin = job->pins[2];
+
+    switch (job->step) {
+        case 0:         // turn on the ranger
+            pinMode(powerPin, OUTPUT);
+            digitalWrite(powerPin, HIGH);
+            job->wake_ms = now_ms() + 500;
+            job->step = 1;
+            break;
+        case 1:         // start the ranger
+            pinMode(triggerPin, OUTPUT);
+            pinMode(pulseInputPin, INPUT);
+            digitalWrite(triggerPin, HIGH);
+            job->count = 0;                 // pulses timed
+            job->address = 0;               // pulses tried (pulseIn)
+            job->wake_ms = now_ms() + 30;
+            job->step = 2;
+#ifdef ARDUINO_ARCH_SAMD
+            if (rangePin < 0 && g_APinDescription[pulseInputPin].ulExtInt != NOT_AN_INTERRUPT) {
+                rangeCount = 0;
+                rangeRiseUs = 0;
+                rangeWanted = ultrasonicBurst;
+                rangePin = pulseInputPin;
+                attachInterrupt(digitalPinToInterrupt(pulseInputPin), range_edge, CHANGE);
+                job->listening = true;          // idle, not standby - micros() has to keep counting
+                job->wake_ms = now_ms() + ULTRASONIC_PERIOD_MS;
+                job->step = 3;
+            }
+#endif
+            break;
+        case 2: {       // one pulse duration -- time of flight
+            int32_t duration = pulseIn(pulseInputPin, HIGH);
+            if (duration > 0) job->samples[job->count++] = duration;        // 0 - no pulse before the timeout
+            if (++job->address < ultrasonicBurst) {         // pulses tried so far
+                job->wake_ms = now_ms() + ULTRASONIC_PERIOD_MS;      // don't sample too quickly < 7.5Hz
+                break;
+            }
+            finish_ultrasonic(job, msmt, job->count);
+            break;
+        }
+#ifdef ARDUINO_ARCH_SAMD
+        case 3: {       // pulses being timed by range_edge - check every period, give up after a few extra
+            if (rangeCount < rangeWanted && job->count++ < ultrasonicBurst + 4) {
+                job->wake_ms = now_ms() + ULTRASONIC_PERIOD_MS;
+                break;
+            }
+            detachInterrupt(digitalPinToInterrupt(pulseInputPin));
+            int n = rangeCount;
+            for (int i = 0; i < n; i++) job->samples[i] = rangeWidths[i];
+            rangePin = -1;
+            job->listening = false;
+            finish_ultrasonic(job, msmt, n);
+            break;
+        }
+#endif
+    }
+}
+
+/**
+ * helper function
+ * turn the ranger off and add the range from the first n pulse widths in job->samples (1 us per mm)
+*/
+void RemoteLogger::finish_ultrasonic(SampleJob *job, Measurement *msmt, int n){
+    digitalWrite(job->pins[1], LOW);            // stop the ranger
+    digitalWrite(job->pins[0], LOW);            // turn off the ranger
+    job->step = JOB_DONE;
+
+    if (n == 0) {
+        job->status = SAMPLE_NO_RESPONSE;
+        return;
+    }
+    uint16_t widths[ULTRASONIC_MAX_BURST];
+    for (int i = 0; i < n; i++) widths[i] = job->samples[i];
+    uint16_t median = median_u16(widths, n);        // sorts widths
+
+    uint16_t range = widths[0];
+    if (ultrasonicFilter == RANGE_MEDIAN) range = median;
+    else if (ultrasonicFilter == RANGE_TRIMMED_MIN) range = widths[n / 5];
+    set_job_value(job, msmt, 0, range);
+}
+
+/**
+ * helper function
+ * Analite 195: run the wiper once an hour (every four samples, or when its setWipePeriod task is due)
+ * and wait out the wipe, then 10 readings
+*/
+void RemoteLogger::step_analite(SampleJob *job, Measurement *msmt){
+    int analogDataPin = job->pins[0], wiperSetPin = job->pins[1], wiperUnsetPin = job->pins[2];
+
+    switch (job->step) {
+        case 0:
+            // set up pins in case the user didn't
+            pinMode(wiperSetPin, OUTPUT);
+            pinMode(wiperUnsetPin, OUTPUT);
+
+            if (wipeTask >= 0 ? task_due(wipeTask) : num_samples() == 4) {     // it's been an hour -- time to wipe
+                digitalWrite(wiperSetPin, HIGH); low_power_wait(150, false); 
+                digitalWrite(wiperSetPin, LOW); low_power_wait(50, false);
+                digitalWrite(wiperUnsetPin, HIGH); low_power_wait(50, false);
+                digitalWrite(wiperUnsetPin, LOW); low_power_wait(50, false);
+                job->wake_ms = now_ms() + 14000;        // wait for wipe cycle - 6 seconds ish
+            } else {    // not wiping, just make sure it's off
+                digitalWrite(wiperUnsetPin, HIGH); low_power_wait(20, false);
+                digitalWrite(wiperUnsetPin, LOW); low_power_wait(20, false);
+                job->wake_ms = now_ms();
+            }
+            job->step = 1;
+            break;
+        case 1: {
+            // burst of 10 hardware-averaged readings from the probe
+            float medTurbAlog = read_adc(analogDataPin, 10);       // median 12-bit analog value
+
+            // convert from analog value to NTU with provided calibration coefficients
+            /** TODO: this just reads it straight across - need to add the calibration stuff */
+            float ntuAnalog = medTurbAlog;
+            int ntuInt = round(ntuAnalog);      // round to an integer
+
+            set_job_value(job, msmt, 0, ntuInt);
+            job->step = JOB_DONE;
+            break;
+        }
+    }
+}
+
+/**
+ * helper function
+ * SDI-12 bus: start every concurrent measurement at once and collect each when its sensor is ready,
+ * then run M and V measurements one at a time (they need the bus to themselves)
+*/
+void RemoteLogger::step_sdi12(SampleJob *job, Measurement *msmt){
+    SDI12 &bus = *(SDI12 *)job->device;
+
+    // start any concurrent measurement whose sensor isn't already busy, collect any that are ready
+    bool concurrent = false;
+    for (int i = 0; i < numSdi12Sensors; i++) {
+        SDI12Entry *entry = &sdi12Sensors[i];
+        if (entry->command[0] != 'C') continue;
+        if (entry->state == SDI12_WAITING && !sdi12_address_busy(entry->address)) sdi12_start(bus, entry, job->offset);
+        if (entry->state == SDI12_MEASURING && (long)(now_ms() - entry->ready_ms) >= 0) sdi12_collect(bus, entry, msmt);
+        if (entry->state != SDI12_DONE) concurrent = true;
+    }
+
+    // once those are in, one measurement that can't share the bus at a time
+    SDI12Entry *single = NULL;
+    for (int i = 0; i < numSdi12Sensors && !concurrent; i++) {
+        SDI12Entry *entry = &sdi12Sensors[i];
+        if (entry->state == SDI12_DONE) continue;
+
+        if (entry->state == SDI12_WAITING) sdi12_start(bus, entry, job->offset);
+        if (entry->state == SDI12_MEASURING && sdi12_data_ready(bus, entry)) sdi12_collect(bus, entry, msmt);
+        if (entry->state != SDI12_DONE) {
+            single = entry;
+            break;
+        }
+    }
+
+    // sleep until the next sensor is due - poll for the service request of an M or V measurement
+    bool waiting = false;
+    for (int i = 0; i < numSdi12Sensors; i++) {
+        SDI12Entry *entry = &sdi12Sensors[i];
+        if (entry->state != SDI12_MEASURING) continue;
+        if (!waiting || (long)(entry->ready_ms - job->wake_ms) < 0) job->wake_ms = entry->ready_ms;
+        waiting = true;
+    }
+    if (single != NULL && (long)(job->wake_ms - now_ms()) > SDI12_POLL_MS) job->wake_ms = now_ms() + SDI12_POLL_MS;
+    job->listening = single != NULL;        // service request can arrive any time
+
+    if (!waiting) {
+        job->step = JOB_DONE;
+        for (int i = 0; i < numSdi12Sensors; i++) {
+            if (job->status == SAMPLE_OK) job->status = sdi12Sensors[i].status;
+        }
+    }
+}
+
+#ifndef RL_NO_SHT31
+/**
+ * helper function
+ * SHT31: takes its reading straight away
+*/
+void RemoteLogger::step_sht31(SampleJob *job, Measurement *msmt){
+    Adafruit_SHT31 &sensor = *(Adafruit_SHT31 *)job->device;
+    job->step = JOB_DONE;
+
+    if (!sensor.begin(job->address)) {
+        job->status = SAMPLE_NO_RESPONSE;       // no data - couldn't find the sensor
+        return;
+    }    
+    sensor.heater(0);
+    set_job_value(job, msmt, 0, sensor.readTemperature());
+    set_job_value(job, msmt, 1, sensor.readHumidity());
+}
+#endif
+
+#ifndef RL_NO_DS18B20
+/**
+ * helper function
+ * DS18B20: start the conversion without blocking, read the temperature once it is done
+*/
+void RemoteLogger::step_DS18B20(SampleJob *job, Measurement *msmt){
+    DallasTemperature &sensors = *(DallasTemperature *)job->device;
+
+    switch (job->step) {
+        case 0: {
+            // a saved chain knows the probe's resolution - otherwise begin() reads it (DallasTemperature assumes 9 bits)
+            bool saved = load_probe_chain() && job->address < probes.count;
+            if (!saved) sensors.begin();
+            byte bits = saved ? probes.bits[job->address] : sensors.getResolution();
+            sensors.setWaitForConversion(false);
+            sensors.requestTemperatures();
+            sensors.setWaitForConversion(true);
+            job->wake_ms = now_ms() + sensors.millisToWaitForConversion(bits);
+            job->step = 1;
+            break;
+        }
+        case 1: {
+            // a probe of a saved chain is read by its address, without searching the bus for it
+            bool saved = load_probe_chain() && job->address < probes.count;
+            float temp = saved ? sensors.getTempC(probes.rom[job->address]) : sensors.getTempCByIndex(job->address);
+            if (temp == DEVICE_DISCONNECTED_C) {
+                job->status = SAMPLE_NO_RESPONSE;
+            } else {
+                set_job_value(job, msmt, 0, temp);
+            }
+            job->step = JOB_DONE;
+            break;
+        }
+    }
+}
+
+/**
+ * helper function
+ * DS18B20 chain: one conversion on every probe (finest resolution's time), then read each probe by address
+ * count is the number of probes that answered
+*/
+void RemoteLogger::step_DS18B20_chain(SampleJob *job, Measurement *msmt){
+    DallasTemperature &sensors = *(DallasTemperature *)job->device;
+
+    switch (job->step) {
+        case 0: {
+            job->count = 0;
+            if (job->num_values == 0) {
+                job->status = SAMPLE_NO_RESPONSE;       // no probes found
+                job->step = JOB_DONE;
+                break;
+            }
+            byte bits = 9;
+            for (int i = 0; i < job->num_values; i++) {
+                if (probes.bits[i] > bits) bits = probes.bits[i];
+            }
+            sensors.setWaitForConversion(false);
+            sensors.requestTemperatures();          // skip ROM - every probe at once
+            sensors.setWaitForConversion(true);
+            job->wake_ms = now_ms() + sensors.millisToWaitForConversion(bits);
+            job->step = 1;
+            break;
+        }
+        case 1:
+            for (int i = 0; i < job->num_values; i++) {
+                float temp = sensors.getTempC(probes.rom[i]);
+                if (temp == DEVICE_DISCONNECTED_C) {
+                    job->status = SAMPLE_NO_RESPONSE;
+                    continue;
+                }
+                set_job_value(job, msmt, i, temp);
+                job->count++;
+            }
+            job->step = JOB_DONE;
+            break;
+    }
+}
+
+/**
+ * helper function
+ * read the newest good copy of the DS18B20 chain from /DS18B20.bin (see load_slots), once per power cycle
+ * returns false if the card isn't there - an empty chain (count 0) if nothing is saved
+*/
+bool RemoteLogger::load_probe_chain(){
+    if (probesLoaded) return true;
+
+    memset(&probes, 0, sizeof(ProbeChain));
+    probes.magic = PROBE_MAGIC;
+    probes.size = sizeof(ProbeChain);
+
+    if (!load_slots("/DS18B20.bin", &probes, sizeof(ProbeChain), PROBE_MAGIC, PROBE_SLOTS)) return false;
+    if (probes.count > DS18B20_MAX_PROBES) probes.count = 0;
+    probesLoaded = true;
+    return true;
+}
+
+/**
+ * helper function
+ * write the DS18B20 chain to the slot after the newest one in /DS18B20.bin (see save_slots)
+*/
+void RemoteLogger::save_probe_chain(){
+    save_slots("/DS18B20.bin", &probes, sizeof(ProbeChain), PROBE_SLOTS);
+}
+#endif
+
+/**
+ * helper function
+ * ask an address for an acknowledgement and its identity, and pick the driver for it
+ * a generic sensor is asked to start a measurement to learn how many values it gives (C, or M if it can't)
+ * returns false if nothing answered at the address
+*/
+bool RemoteLogger::sdi12_identify(SDI12 &bus, char address, SDI12Device *device){
+    char cmd[4] = {address, '!', '\0'};
+    char response[48];
+
+    bus.clearBuffer();
+    if (sdi12_transaction(bus, cmd, response, sizeof(response)) == 0 || response[0] != address) return false;
+
+    memset(device, 0, sizeof(SDI12Device));
+    device->address = address;
+    cmd[1] = 'I';
+    cmd[2] = '!';
+    bus.clearBuffer();
+    if (sdi12_transaction(bus, cmd, response, sizeof(response)) > 1 && response[0] == address) {
+        response[SDI12_ID_CHARS] = '\0';           // the serial number after the sensor version isn't kept
+        strcpy(device->identity, response + 1);
+    }
+
+    for (unsigned int i = 0; i < sizeof(sdi12Drivers) / sizeof(SDI12Driver); i++) {
+        if (sdi12Drivers[i].vendor[0] == '\0') continue;       // generic
+        if (strstr(device->identity, sdi12Drivers[i].vendor) != NULL && strstr(device->identity, sdi12Drivers[i].model) != NULL) {
+            device->driver = i;
+            return true;
+        }
+    }
+
+    // generic: the atttn(n) reply says how many values - the measurement is dropped, the sensor powers off with the logger
+    const char *commands = "CM";
+    for (int i = 0; i < 2 && device->num_values == 0; i++) {
+        cmd[1] = commands[i];
+        bus.clearBuffer();
+        if (sdi12_transaction(bus, cmd, response, sizeof(response)) >= 5 && response[0] == address) {
+            device->num_values = atoi(response + 4);
+            device->driver = i == 0 ? SDI12_GENERIC : SDI12_GENERIC_M;
+        }
+    }
+    bus.clearBuffer();
+    return true;
+}
+
+/**
+ * helper function
+ * register the measurements of every sensor found by find_sdi12_bus, as add_sdi12_sensor
+ * a sensor alone on the bus measures with M instead of C: its service request says when the data is ready,
+ * where a concurrent measurement waits out the whole time the sensor gave
+*/
+void RemoteLogger::register_sdi12_devices(){
+    clear_sdi12_sensors();
+    for (int i = 0; i < sdi12Map.count; i++) {
+        SDI12Device *device = &sdi12Map.devices[i];
+        const SDI12Driver *driver = &sdi12Drivers[device->driver < sizeof(sdi12Drivers) / sizeof(SDI12Driver) ? device->driver : SDI12_GENERIC];
+        for (int j = 0; j < 2 && driver->commands[j] != NULL; j++) {
+            byte values = driver->num_values[j] > 0 ? driver->num_values[j] : device->num_values;
+            const char *command = driver->commands[j];
+            if (sdi12Map.count == 1 && strcmp(command, "C") == 0 && values <= 9) command = "M";     // M gives up to 9
+            if (values > 0) add_sdi12_sensor(device->address, values, command);
+        }
+    }
+}
+
+/**
+ * helper function
+ * read the newest good copy of the SDI-12 sensors from /SDI12.bin, once per power cycle
+ * returns false if the card isn't there - no sensors (count 0) if nothing is saved
+*/
+bool RemoteLogger::load_sdi12_map(){
+    if (sdi12MapLoaded) return true;
+
+    memset(&sdi12Map, 0, sizeof(SDI12BusMap));
+    sdi12Map.magic = SDI12_BUS_MAGIC;
+    sdi12Map.size = sizeof(SDI12BusMap);
+
+    if (!load_slots("/SDI12.bin", &sdi12Map, sizeof(SDI12BusMap), SDI12_BUS_MAGIC, SDI12_BUS_SLOTS)) return false;
+    if (sdi12Map.count > SDI12_MAX_DEVICES) sdi12Map.count = 0;
+    sdi12MapLoaded = true;
+    return true;
+}
+
+/**
+ * helper function
+ * write the SDI-12 sensors to the slot after the newest one in /SDI12.bin (see save_slots)
+*/
+void RemoteLogger::save_sdi12_map(){
+    save_slots("/SDI12.bin", &sdi12Map, sizeof(SDI12BusMap), SDI12_BUS_SLOTS);
+}
+
+/**
+ * helper function
+ * send an SDI-12 command and read the reply into response (CR/LF dropped, null terminated)
+ * no Strings - the reply is built in the caller's buffer
+ * returns the number of characters in the reply (0 if the sensor didn't answer)
+*/
+int RemoteLogger::sdi12_transaction(SDI12 &bus, const char *command, char *response, int len){
+    bus.sendCommand(command);
+    return sdi12_read_line(bus, response, len);
+}
+
+/**
+ * helper function
+ * read one SDI-12 reply up to its CR/LF into line (CR/LF dropped, null terminated)
+ * gives up if the sensor doesn't start answering within SDI12_REPLY_MS or stalls part way through
+ * returns the number of characters read (0 if nothing arrived)
+*/
+int RemoteLogger::sdi12_read_line(SDI12 &bus, char *line, int len){
+    int n = 0;
+    unsigned long last = now_ms();
+    unsigned long timeout = SDI12_REPLY_MS;
+
+    while (now_ms() - last < timeout) {
+        if (!bus.available()) {
+            low_power_wait(1, false);
+            continue;
+        }
+        char c = bus.read();
+        last = now_ms();
+        timeout = SDI12_CHAR_MS;        // reply has started - characters come back to back from here
+        if (c == '\n') break;
+        if (c != '\r' && n < len - 1) line[n++] = c;
+    }
+    line[n] = '\0';
+
+    return n;
+}
+
+/**
+ * helper function
+ * check whether a measurement's data is ready: the time the sensor gave in its atttn reply has passed,
+ * or its service request has arrived (concurrent measurements don't send one)
+*/
+bool RemoteLogger::sdi12_data_ready(SDI12 &bus, SDI12Entry *entry){
+    if ((long)(now_ms() - entry->ready_ms) >= 0) return true;
+
+    char line[8];
+    while (entry->command[0] != 'C' && bus.available()) {
+        if (sdi12_read_line(bus, line, sizeof(line)) > 0 && line[0] == entry->address) return true;
+    }
+    return false;
+}
+
+/**
+ * helper function
+ * ready every registered SDI-12 measurement for a new sample, each at its place among the job's values
+ * returns the number of values for all of them
+*/
+byte RemoteLogger::sdi12_reset_entries(){
+    byte offset = 0;
+    for (int i = 0; i < numSdi12Sensors; i++) {
+        SDI12Entry *entry = &sdi12Sensors[i];
+        entry->offset = offset;
+        entry->found = 0;
+        entry->state = SDI12_WAITING;
+        entry->status = SAMPLE_OK;
+        offset += entry->num_values;
+    }
+    return offset;
+}
+
+/**
+ * helper function
+ * read the values out of an SDI-12 data reply in place, e.g. "0+123.4-1.5+45" gives 123.4, -1.5, 45
+ * anything before the first sign (address, stray service request) is skipped
+ * returns the number of values found
+*/
+int RemoteLogger::parse_sdi12_values(const char *response, float *values, int max_values){
+    int n = 0;
+    const char *p = response;
+
+    while (*p && *p != '+' && *p != '-') p++;       // skip the address
+
+    while (*p && n < max_values) {
+        char *end;
+        float v = strtod(p, &end);
+        if (end == p) break;            // not a number - end of the values
+        values[n++] = v;
+        p = end;
+    }
+
+    return n;
+}
+
+/**
+ * helper function
+ * run one SDI-12 measurement (M or V) and add the expected number of values to a measurement
+ * same command sequence and timing as the String sampling functions
+*/
+byte RemoteLogger::sdi12_measure(SDI12 &bus, int sensor_address, char command, int expected, Measurement *msmt){
+    PhaseTimer timer(*this, PHASE_SDI12);
+    SDI12Entry entry;
+    entry.address = sensor_address < 10 ? '0' + sensor_address : sensor_address;
+    entry.command[0] = command;
+    entry.command[1] = '\0';
+    entry.num_values = expected;
+    entry.offset = msmt->count;
+    entry.found = 0;
+    entry.status = SAMPLE_OK;
+    for (int i = 0; i < expected; i++) {
+        if (add_value(msmt, NO_READING) == SAMPLE_FULL) entry.status = SAMPLE_FULL;
+    }
+
+    sdi12_start(bus, &entry, 0);
+    if (entry.state == SDI12_MEASURING) {
+        while (!sdi12_data_ready(bus, &entry)) {
+            // a modem warming up (warm_modem) carries on meanwhile - data ready while it talks is collected after
+            if (modem_warm_due()) modem_warm_step(NULL, 0, msmt);
+            else low_power_wait(1, false);          // returns early on the service request
+        }
+        sdi12_collect(bus, &entry, msmt);
+    }
+
+    if (msmt->status == SAMPLE_OK) msmt->status = entry.status;
+    return entry.status;
+}
+
+/**
+ * helper function
+ * values of a measurement as comma-separated text, for the String sampling functions
+*/
+String RemoteLogger::values_to_string(Measurement *msmt){
+    char buf[16];
+    String sample;
+    sample.reserve(8 * msmt->count);
+
+    for (int i = 0; i < msmt->count; i++) {
+        if (i > 0) sample += ",";
+        format_float(buf, msmt->values[i], 3);
+        sample += buf;
+    }
+    return sample;
+}
+
+/**
+ * helper function
+ * send a registered measurement command and read when the data will be ready from the atttn reply
+ * (ttt is seconds until the data is ready, n is the number of values - nn for concurrent)
+*/
+void RemoteLogger::sdi12_start(SDI12 &bus, SDI12Entry *entry, byte base){
+    char cmd[6] = {entry->address, '\0'};
+    char response[16];
+    entry->offset += base;
+    strcat(cmd, entry->command);
+    strcat(cmd, "!");
+
+    bus.clearBuffer();
+    int len = sdi12_transaction(bus, cmd, response, sizeof(response));
+
+    if (len < 4 || response[0] != entry->address) {     // no answer - nothing to collect
+        entry->state = SDI12_DONE;
+        entry->status = SAMPLE_NO_RESPONSE;
+        return;
+    }
+
+    int seconds = (response[1] - '0') * 100 + (response[2] - '0') * 10 + (response[3] - '0');
+    if (atoi(response + 4) == 0) {      // sensor says it has nothing to measure
+        entry->state = SDI12_DONE;
+        entry->status = SAMPLE_BAD_RESPONSE;
+        return;
+    }
+    entry->ready_ms = now_ms() + (unsigned long)seconds * 1000;
+    entry->state = SDI12_MEASURING;
+}
+
+/**
+ * helper function
+ * read D0! to D9! from a sensor until all its values are in, writing them at the sensor's offset
+*/
+void RemoteLogger::sdi12_collect(SDI12 &bus, SDI12Entry *entry, Measurement *msmt){
+    char cmd[5] = {entry->address, 'D', '0', '!', '\0'};
+    char response[84];          // concurrent data replies can be up to 75 characters
+    int room = MAX_PARAMS - entry->offset;
+    int wanted = entry->num_values < room ? entry->num_values : room;
+
+    for (char d = '0'; d <= '9' && entry->found < wanted; d++) {
+        cmd[2] = d;
+        bus.clearBuffer();
+        if (sdi12_transaction(bus, cmd, response, sizeof(response)) == 0) break;
+
+        int n = parse_sdi12_values(response, msmt->values + entry->offset + entry->found, wanted - entry->found);
+        if (n == 0) break;          // sensor has no more values
+        entry->found += n;
+    }
+    bus.clearBuffer();
+
+    entry->state = SDI12_DONE;
+    if (entry->found < wanted && entry->status == SAMPLE_OK) entry->status = SAMPLE_BAD_RESPONSE;
+}
+
+/**
+ * helper function
+ * check whether a sensor is part way through a measurement (another command would abort it)
+*/
+bool RemoteLogger::sdi12_address_busy(char address){
+    for (int i = 0; i < numSdi12Sensors; i++) {
+        if (sdi12Sensors[i].address == address && sdi12Sensors[i].state == SDI12_MEASURING) return true;
+    }
+    return false;
+}
+
+/**
+ * helper function
+ * add n NO_READING values to a measurement and record why
+*/
+byte RemoteLogger::add_no_reading(Measurement *msmt, int n, byte status){
+    for (int i = 0; i < n; i++) add_value(msmt, NO_READING);
+    if (msmt->status == SAMPLE_OK) msmt->status = status;
+    return status;
+}
+
+/**
+ * helper function
+ * median of n values, sorted in place - the middle two averaged if n is even
+ * insertion sort: for a burst this short it beats anything more general, and needs no float copies
+*/
+uint16_t RemoteLogger::median_u16(uint16_t *values, int n){
+    for (int i = 1; i < n; i++) {
+        uint16_t v = values[i];
+        int j = i;
+        while (j > 0 && values[j - 1] > v) {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = v;
+    }
+    if (n % 2) return values[n / 2];
+    return (values[n / 2 - 1] + values[n / 2] + 1) / 2;
+}
+
+/**
+ * helper function
+ * write a float into out with up to the given decimal places, dropping trailing zeroes
+ * no printf float support needed; returns the number of characters written
+*/
+int RemoteLogger::format_float(char *out, float value, byte decimals){
+    if (value != value) {       // NaN - nothing useful to write
+        return snprintf(out, 16, "%d", NO_READING);
+    }
+
+    long scale = 1;
+    for (int i = 0; i < decimals; i++) scale *= 10;
+
+    bool negative = value < 0;
+    float magnitude = negative ? -value : value;
+    if (magnitude > 2000000000.0 / scale) magnitude = 2000000000.0 / scale;       // keep it in a long
+
+    long scaled = (long)(magnitude * scale + 0.5);
+    long whole = scaled / scale;
+    long fraction = scaled % scale;
+
+    int len = snprintf(out, 16, "%s%ld", (negative && scaled != 0) ? "-" : "", whole);
+    if (fraction != 0) {
+        int digits = decimals;
+        while (fraction % 10 == 0) { fraction /= 10; digits--; }
+        len += snprintf(out + len, 16, ".%0*ld", digits, fraction);
+    }
+    return len;
+}
+
+/**
+ * helper function
+ * whether a scheduled sensor or task (slot) hasn't run yet in the period now falls in
+ * periods are counted from the phase: period k covers phase + k * period_s up to the next one
+ * take: mark the period as run (the caller saves the state)
+*/
+bool RemoteLogger::slot_due(int slot, uint32_t now, bool take){
+    unsigned long period = taskPeriod[slot];
+    uint32_t run = (now - taskPhase[slot] % period) / period + 1;      // + 1 so 0 is never
+    if (state.task_runs[slot] == run) return false;
+    if (take) state.task_runs[slot] = run;
+    return true;
+}
+
+/**
+ * helper function
+ * sleep for ms: standby (RTC wakeup) if allowed and the wait is long enough, otherwise idle
+ * standby stops the serial ports, SDI-12 and millis(), so callers waiting on a sensor reply pass false
+ * standby is taken in pieces no longer than half the watchdog period, feeding it in between
+*/
+void RemoteLogger::low_power_wait(unsigned long ms, bool standby_ok){
+#ifdef ARDUINO_ARCH_SAMD
+    unsigned long start = now_ms();
+    bool watchdog = WDT->CTRL.bit.ENABLE;
+
+    if (standby_ok && standbyThreshold > 0 && ms >= standbyThreshold) {
+        // watchdog period is 8 << PER cycles of the 1.024 kHz clock
+        unsigned long chunk = watchdog ? ((8UL << WDT->CONFIG.bit.PER) * 1000 / 1024) / 2 : ms;
+        if (chunk == 0) chunk = 1;
+
+        while ((long)(now_ms() - start) < (long)ms) {
+            unsigned long remaining = ms - (now_ms() - start);
+            unsigned long step = remaining < chunk ? remaining : chunk;
+            if (watchdog) Watchdog.reset();
+            LowPower.sleep(step);
+            sleptMs += step;
+        }
+        if (watchdog) Watchdog.reset();
+        return;
+    }
+
+    // idle: the CPU stops until the next interrupt - the 1 ms SysTick at the latest
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    PM->SLEEP.reg = PM_SLEEP_IDLE_CPU;
+    while (now_ms() - start < ms) {
+        if (watchdog) Watchdog.reset();
+        __DSB();
+        __WFI();
+    }
+#else
+    (void)standby_ok;
+    delay(ms);
+#endif
+}
+
+/**
+ * helper function
+ * make sure the hourly store header is in memory, creating the ring file if it doesn't exist yet
+ * the header is only read from the card once per power cycle
+ * a ring file written with a different number of parameters is replaced with an empty one
+*/
+bool RemoteLogger::load_hourly(){
+    if (hourlyLoaded) return true;
+    if (journalPending) recover_journal();         // a journaled write that failed earlier this wake - finish it first
+
+    File hourly = SD.open("/HOURLY.bin", FILE_READ);
+    if (hourly) {
+        int got = hourly.read((uint8_t *)&hourlyHeader, sizeof(HourlyHeader));
+        hourly.close();
+        if (got == sizeof(HourlyHeader) && hourlyHeader.magic == HOURLY_MAGIC
+                && hourlyHeader.record_size == hourly_record_size()
+                && hourlyHeader.capacity == HOURLY_CAPACITY) {
+            hourlyLoaded = true;
+            return true;
+        }
+    }
+    return create_hourly();
+}
+
+/**
+ * helper function
+ * write an empty hourly ring file with every record slot preallocated
+ * only happens on first use (or after the parameters change) so writes later never extend the file
+*/
+bool RemoteLogger::create_hourly(){
+    File hourly = SD.open("/HOURLY.bin", FILE_RW | O_TRUNC);
+    if (!hourly) return false;
+
+    hourlyHeader.magic = HOURLY_MAGIC;
+    hourlyHeader.record_size = hourly_record_size();
+    hourlyHeader.capacity = HOURLY_CAPACITY;
+    hourlyHeader.head = 0;
+    hourlyHeader.tail = 0;
+    hourlyHeader.count = 0;
+    hourlyHeader.reserved = 0;
+    hourly.write((const uint8_t *)&hourlyHeader, sizeof(HourlyHeader));
+
+    uint8_t zeros[64];
+    memset(zeros, 0, sizeof(zeros));
+    uint32_t remaining = (uint32_t)hourlyHeader.capacity * hourlyHeader.record_size;
+    while (remaining > 0) {
+        uint16_t n = remaining > sizeof(zeros) ? sizeof(zeros) : remaining;
+        hourly.write(zeros, n);
+        remaining -= n;
+    }
+    hourly.close();
+
+    hourlyLoaded = true;
+    return true;
+}
+
+/**
+ * helper function
+ * write the in-memory hourly header back to the start of the ring file (through the journal)
+*/
+void RemoteLogger::save_hourly_header(){
+    JournalWrite write = {"/HOURLY.bin", 0, &hourlyHeader, sizeof(HourlyHeader)};
+    if (!journal_writes(&write, 1)) hourlyLoaded = false;
+}
+
+/**
+ * helper function
+ * size of one hourly record on the card: timestamp, battery, memory and myParams values
+*/
+uint16_t RemoteLogger::hourly_record_size(){
+    return sizeof(uint32_t) + sizeof(float) * (2 + myParams);
+}
+
+/**
+ * helper function
+ * write value * multiplier rounded to a whole number into out, the way it appears in a message
+ * returns the number of characters written (no null terminator counted)
+*/
+int RemoteLogger::format_msg_value(char *out, float value, float multiplier){
+    return rl_codec::format_value(out, rl_codec::scale_value(value, multiplier));
+}
+
+/**
+ * helper function
+ * value * multiplier rounded to a whole number - what gets sent for each value in a message
+*/
+long RemoteLogger::scale_msg_value(float value, float multiplier){
+    return rl_codec::scale_value(value, multiplier);
+}
+
+/**
+ * helper function
+ * wake the modem, send a text or binary message and put it back to sleep, updating the send counters
+ * (text is sent if it isn't NULL, otherwise the binary data)
+*/
+int RemoteLogger::modem_send(const char *text, const uint8_t *data, int len){
+    begin_session();
+
+    int err = text != NULL ? session_send(text) : session_send(data, len);    // try to send the message
+    note_signal();
+
+    // if unsuccessful try again - but only if there is a signal and the battery can take it
+    if (err != ISBD_SUCCESS && sessionSignal >= OUTBOX_MIN_SIGNAL && sample_batt_v() >= lowBattV) {
+        err = modem.begin();        // make sure the modem is still up - a modem that won't start isn't sent to
+        if (err == ISBD_SUCCESS || err == ISBD_ALREADY_AWAKE) {
+            err = text != NULL ? session_send(text) : session_send(data, len);
+        } else {
+            session_result(err, NULL, 0);       // counted as the session's failure
+        }
+    }
+
+    if (err == ISBD_SUCCESS) session_receive();
+    end_session();
+    return err; 
+}
+
+/**
+ * helper function
+ * power up the modem and start talking to it
+ * returns the error from modem.begin()
+*/
+int RemoteLogger::modem_start(){
+    PhaseTimer timer(*this, PHASE_MODEM_ON);
+    modemLogger = this;
+    if (modemWarm != MODEM_OFF) {
+        // powered since warm_modem, while the sensors sampled
+        add_phase_time(PHASE_MODEM_ON, (now_ms() - modemWarmMs) * 1000UL);
+        byte warm = modemWarm;
+        modemWarm = MODEM_OFF;
+        if (warm == MODEM_READY) return ISBD_SUCCESS;       // already begun, signal already asked
+        unsigned long on = now_ms() - modemWarmMs;
+        if (on < MODEM_POWER_MS) idle_wait(MODEM_POWER_MS - on);
+    } else {
+        sessionSignal = -1;
+        if (profile.modem_before_mv == 0) profile.modem_before_mv = sample_batt_v() * 1000;     // for the modem's energy cost
+        digitalWrite(IridSlpPin, HIGH);     // wake up the modem
+        idle_wait(MODEM_POWER_MS);      // wait for RockBlock to power on
+    }
+
+    IridiumSerial.begin(19200);     // Iridium serial at 19200 baud
+    modem.setPowerProfile(IridiumSBD::USB_POWER_PROFILE);
+
+    int err = modem.begin();        // start up the modem
+    if (err == ISBD_IS_ASLEEP){
+        err = modem.begin();    // try to start up again
+    }
+    return err;
+}
+
+/**
+ * helper function
+ * end a modem session: sync the clock now and then, put the modem to sleep, update the send counters
+ * 
+ * err: result of the session (ISBD_SUCCESS if the message went)
+*/
+void RemoteLogger::modem_stop(int err){
+    modem_off(err);
+    count_session(err);
+}
+
+/**
+ * helper function
+ * sync the clock if the modem reached the network, then put the modem to sleep
+*/
+void RemoteLogger::modem_off(int err){
+    // calibrate the RTC time whenever the modem reached the network - costs no credits
+    /** TODO: do we need the pre/post time strings? */
+    if (err == ISBD_SUCCESS) {
+        sync_clock();
+    }
+
+    profile.modem_after_mv = sample_batt_v() * 1000;       // still under load
+    digitalWrite(IridSlpPin, LOW);      // put the modem back to sleep
+    modemWarm = MODEM_OFF;
+}
+
+/**
+ * helper function
+ * one step of a modem warmed by warm_modem: begin it once it has powered up, then ask for its signal now and then
+ * the due sensors are stepped from ISBDCallback while it talks, so they stay on time
+*/
+void RemoteLogger::modem_warm_step(SampleJob *list, int n, Measurement *msmt){
+    callbackJobs = list;
+    callbackCount = n;
+    callbackMsmt = msmt;
+    if (modemWarm == MODEM_POWERING) {
+        IridiumSerial.begin(19200);
+        modem.setPowerProfile(IridiumSBD::USB_POWER_PROFILE);
+        int err = modem.begin();
+        if (err == ISBD_IS_ASLEEP) err = modem.begin();
+        modemWarm = err == ISBD_SUCCESS || err == ISBD_ALREADY_AWAKE ? MODEM_READY : MODEM_FAILED;
+        modemPollMs = now_ms() - MODEM_POLL_MS;        // ask for the signal straight away
+    } else {
+        note_signal();
+        modemPollMs = now_ms();
+    }
+    callbackJobs = NULL;
+}
+
+/**
+ * helper function
+ * when the warm modem next needs attention: begun once powered up, then asked for its signal every MODEM_POLL_MS
+*/
+unsigned long RemoteLogger::modem_due_ms(){
+    if (modemWarm == MODEM_POWERING) return modemWarmMs + MODEM_POWER_MS;
+    return modemPollMs + MODEM_POLL_MS;
+}
+
+/**
+ * helper function
+ * true if a modem warmed by warm_modem needs to be begun or asked for its signal now
+*/
+bool RemoteLogger::modem_warm_due(){
+    if (modemWarm != MODEM_POWERING && modemWarm != MODEM_READY) return false;
+    return (long)(now_ms() - modem_due_ms()) >= 0;
+}
+
+/**
+ * helper function
+ * called from ISBDCallback while the modem waits: step the sensors due, then the sketch's callback
+ * returns false to cancel the modem operation
+*/
+bool RemoteLogger::modem_callback(){
+    if (callbackJobs != NULL) {
+        SampleJob *list = callbackJobs;
+        callbackJobs = NULL;        // a sensor's step can't start another
+        step_due_jobs(list, callbackCount, callbackMsmt);
+        callbackJobs = list;
+    }
+    return modemCallback == NULL || modemCallback();
+}
+
+/**
+ * helper function
+ * keep the send counters up to date after a session on any link: reset on success, back off on failure
+*/
+void RemoteLogger::count_session(int err){
+    if (load_state()) {
+        if (err == ISBD_SUCCESS) {
+            state.hours_since_send = 0;
+            state.failed_sends = 0;
+            state.next_send = 0;
+            state.event_send = 0;
+        } else {
+            state.failed_sends++;
+
+            // back off: wait 1, 2, 4, 8... hours before the next attempt, up to maxBackoffHours
+            uint32_t hours = state.failed_sends > 16 ? maxBackoffHours : 1UL << (state.failed_sends - 1);
+            if (hours > (uint32_t)maxBackoffHours) hours = maxBackoffHours;
+            state.next_send = rtc.now().unixtime() + hours * 3600 - 300;     // a few minutes early so the wake on the hour counts
+        }
+        if (sessionSignal >= 0) state.last_signal = sessionSignal;
+        save_state();
+    }
+}
+
+/**
+ * helper function
+ * note the result of one SBD session and act on any message that came down with it
+ * configuration messages (see apply_params) are applied straight away
+*/
+void RemoteLogger::session_result(int err, uint8_t *rx, size_t rx_len){
+    if (err != ISBD_SUCCESS) {
+        if (sessionErr != ISBD_SUCCESS) sessionErr = err;
+        return;
+    }
+    sessionErr = ISBD_SUCCESS;
+
+    if (rx_len == 0) return;        // nothing waiting
+    rx[rx_len] = '\0';
+    apply_params((const char *)rx);
+}
+
+/**
+ * helper function
+ * list the links to try this session in order of score (see add_transport), returning how many
+ * links sitting out after failures are left off and counted as having sat out this session
+ * 
+ * frames: messages to send
+ * len: typical message length
+ * loaded is set to whether the failure counters could be read - if not, every link is tried
+*/
+int RemoteLogger::rank_transports(int frames, int len, byte *order, bool *loaded){
+    *loaded = load_state();
+    float score[MAX_TRANSPORTS];
+    int n = 0;
+
+    for (int i = 0; i < numLinks; i++) {
+        uint8_t &fails = state.link_fails[i];
+        if (i > 0 && *loaded && fails >= LINK_MAX_FAILS && fails < LINK_MAX_FAILS + LINK_RETRY_SESSIONS) {
+            fails++;            // Iridium (0) is the fallback and never sits out
+            continue;
+        }
+        float s = frames * links[i]->cost(len) + latencyCost * links[i]->latency_s / 3600.0;
+        int j = n++;
+        while (j > 0 && score[j - 1] > s) {
+            score[j] = score[j - 1];
+            order[j] = order[j - 1];
+            j--;
+        }
+        score[j] = s;
+        order[j] = i;
+    }
+    return n;
+}
+
+/**
+ * helper function
+ * send up to max_frames messages from the outbox over a link that has begun its session, then any
+ * frames of the image being sent; stops at a message the link can't take (cut before it was added)
+ * err is set to the last link error; returns the number of messages sent
+*/
+int RemoteLogger::send_frames(Transport *link, int max_frames, bool newest_first, int *err){
+    int sent = 0;
+    bool empty = false;
+    OutboxSlot slot;
+
+    while (sent < max_frames) {
+        int index = next_frame(newest_first, &slot);
+        if (index < 0) {            // outbox empty
+            empty = true;
+            break;
+        }
+        if (!link->link_up()) {
+            *err = ISBD_NO_NETWORK;     // link too poor - try again next session
+            break;
+        }
+        if (slot.len > link->mtu) {
+            *err = ISBD_MSG_TOO_LONG;   // left for a link that takes it
+            break;
+        }
+
+        if (!read_frame(index, &slot, (uint8_t *)msgBuf)) {
+            set_frame_state(index, OUTBOX_EMPTY);       // damaged - drop it
+            continue;
+        }
+        msgBuf[slot.len] = '\0';          // text goes as a string
+        *err = link_send(link, (const uint8_t *)msgBuf, slot.len, slot.binary);
+        if (*err != ISBD_SUCCESS) break;         // try again next session
+
+        set_frame_state(index, OUTBOX_SENT);
+        sent++;
+    }
+
+    // any frames left over go to the image being sent (begin_image)
+    if (empty && sent < max_frames) sent += send_image_frames(link, max_frames - sent, err);
+    return sent;
+}
+
+/**
+ * helper function
+ * send one message over a link in its session and act on anything that comes back with it
+ * returns the error from the link, ISBD_SUCCESS if the message went
+*/
+int RemoteLogger::link_send(Transport *link, const uint8_t *data, int len, bool binary){
+    PhaseTimer timer(*this, PHASE_MODEM_SEND);
+    uint8_t rx[SBD_MT_BYTES + 1];
+    size_t rx_len = SBD_MT_BYTES;
+    int err = link->send(data, len, binary, rx, rx_len);
+    session_result(err, rx, rx_len);
+    return err;
+}
+
+/**
+ * helper function
+ * pick up messages waiting for the logger on a link, up to MT_MAX_PER_SESSION
+ * returns the number of messages received
+*/
+int RemoteLogger::link_receive(Transport *link){
+    PhaseTimer timer(*this, PHASE_MODEM_SEND);
+    int received = 0;
+    while (received < MT_MAX_PER_SESSION) {
+        uint8_t rx[SBD_MT_BYTES + 1];
+        size_t rx_len = SBD_MT_BYTES;
+        int err = link->receive(rx, rx_len);
+        if (err == ISBD_SUCCESS && rx_len == 0) break;      // nothing waiting
+        session_result(err, rx, rx_len);
+        if (err != ISBD_SUCCESS) break;
+        received++;
+    }
+    return received;
+}
+
+/**
+ * helper function
+ * ask the modem for its signal quality and remember it for the transmission scheduler
+*/
+void RemoteLogger::note_signal(){
+    int quality = -1;
+    if (modem.getSignalQuality(quality) == ISBD_SUCCESS) sessionSignal = quality;
+}
+
+/**
+ * helper function
+ * build a text message in msgBuf from rows first .. first+rows-1 of the hourly store
+ * battery and memory come from the last of those rows
+ * returns the message length
+*/
+int RemoteLogger::build_text_msg(int first, int rows){
+    HourlyRecord record;
+    int len;
+
+    // battery voltage and memory come from the most recent record in the message
+    read_hourly(first + rows - 1, &record);
+    float last_batt = record.batt_v;
+    float last_memory = record.memory;
+
+    // letters, datetime of the first measurement, battery voltage and free memory (most recent)
+    char letters[MAX_PARAMS];
+    int num_letters = param_letters(letters);
+    read_hourly(first, &record);
+    len = rl_codec::put_text_header(msgBuf, letters, num_letters, record.timestamp,
+        scale_msg_value(last_batt, BATT_MULT), scale_msg_value(last_memory, MEM_MULT));
+
+    //sampled data
+    long values[MAX_PARAMS];
+    for (int row = first; row < first + rows; row++) {        // for each record in the message
+        if (row != first) read_hourly(row, &record);          // first record is already loaded
+        int n = sent_values(&record, values);
+        len += rl_codec::put_text_row(msgBuf + len, sizeof(msgBuf) - len, values, n);      // values past the end are dropped
+    }
+
+    // summary of the last wake's profile, if asked for (setProfiling) - room is kept by text_fixed_size
+    char summary[44];
+    int summary_len = profile_summary(summary);
+    if (summary_len > 0 && len + summary_len < (int)sizeof(msgBuf)) {
+        memcpy(msgBuf + len, summary, summary_len);
+        len += summary_len;
+    }
+    msgBuf[len] = '\0';
+
+    return len;
+}
+
+/**
+ * helper function
+ * characters in a text message before the rows, with battery and memory from record
+*/
+int RemoteLogger::text_fixed_size(HourlyRecord *record){
+    char value[16];
+    int fixed = param_letters(NULL) + 1 + 8 + 1;
+    fixed += format_msg_value(value, record->batt_v, BATT_MULT) + 1;
+    fixed += format_msg_value(value, record->memory, MEM_MULT) + 1;
+    if (profileInMsg) fixed += 44;          // most a profile summary can take
+    return fixed;
+}
+
+/**
+ * helper function
+ * multiplier for parameter i, 0 if it isn't sent
+*/
+float RemoteLogger::param_multiplier(int i){
+    return mySchema ? mySchema[i].multiplier : myMultipliers[i];
+}
+
+/**
+ * helper function
+ * write the message letters to out (not null terminated, out can be NULL to count them)
+ * returns the number of letters, at most MAX_PARAMS
+*/
+int RemoteLogger::param_letters(char *out){
+    int n = 0;
+    if (mySchema) {
+        for (int i = 0; i < myParams; i++) {
+            if (mySchema[i].letter == '\0') continue;      // not sent
+            if (out) out[n] = mySchema[i].letter;
+            n++;
+        }
+        return n;
+    }
+    n = myLetters.length() < MAX_PARAMS ? myLetters.length() : MAX_PARAMS;
+    if (out) memcpy(out, myLetters.c_str(), n);
+    return n;
+}
+
+/**
+ * helper function
+ * CSV header line from the compile-time schema: datetime,batt_v,memory then the column names
+ * returns the length
+*/
+int RemoteLogger::schema_header(char *out, int size){
+    int len = snprintf(out, size, "datetime,batt_v,memory");
+    for (int i = 0; i < myParams && len < size - 1; i++) {
+        len += snprintf(out + len, size - len, ",%s", mySchema[i].name);
+    }
+    return len < size ? len : size - 1;
+}
+
+/**
+ * helper function
+ * how many of the oldest hourly rows fit in one text message of len bytes (at least 1, at most 18)
+*/
+int RemoteLogger::text_rows_fit(int len){
+    int maxInMsg = 18;
+    int num_rows = num_hours();
+    HourlyRecord record;
+    char value[16];
+
+    int rows = 0;
+    int used = 0;           // characters for the rows so far
+    uint32_t prev_time = 0;
+    while (rows < num_rows && rows < maxInMsg) {
+        read_hourly(rows, &record);
+        // the text format only has the first row's hour - stop where the rows stop being an hour apart
+        if (rows > 0 && (record.timestamp - prev_time < 3000 || record.timestamp - prev_time > 4200)) break;
+        prev_time = record.timestamp;
+        int row = 0;
+        for (int i = 0; i < myParams; i++) {
+            if (param_multiplier(i) != 0) row += format_msg_value(value, record.values[i], param_multiplier(i)) + 1;
+        }
+        if (text_fixed_size(&record) + used + row > len - 1) break;      // battery/memory come from the last row
+        used += row;
+        rows++;
+    }
+    return rows > 0 ? rows : 1;
+}
+
+/**
+ * helper function
+ * build a binary message in buf from the oldest hourly rows that fit in len bytes, at least 1 and at
+ * most 255 (see prep_binary_msg) - each row is read once and encoded as it is read
+ * rows: set to the number of rows in the message
+ * returns the message length
+*/
+int RemoteLogger::build_binary_msg(uint8_t *buf, int len, int *rows){
+    int num_rows = num_hours();
+    HourlyRecord record, next;
+
+    read_hourly(0, &record);
+    uint32_t first_time = record.timestamp;
+
+    // the rows go in from the start of buf, and move up once the header's size is known
+    // (battery and memory come from the last row)
+    int used = binary_row(buf, &record, NULL);         // first row is stored whole
+    int n = 1;
+    while (n < num_rows && n < 255) {
+        if (!read_hourly(n, &next)) break;
+        int change = binary_row(NULL, &next, &record);
+        if (binary_fixed_size(&next) + used + change > len) break;
+        used += binary_row(buf + used, &next, &record);
+        record = next;
+        n++;
+    }
+    *rows = n;
+
+    int fixed = binary_fixed_size(&record);
+    memmove(buf + fixed, buf, used);
+    rl_codec::put_binary_header(buf, binary_schema_id(), first_time, n, scale_msg_value(record.batt_v, BATT_MULT),
+        scale_msg_value(record.memory, MEM_MULT));
+    return fixed + used;
+}
+
+/**
+ * helper function
+ * bytes in a binary message before the rows, with battery and memory from record
+*/
+int RemoteLogger::binary_fixed_size(HourlyRecord *record){
+    return rl_codec::put_binary_header(NULL, 0, 0, 0, scale_msg_value(record->batt_v, BATT_MULT),
+        scale_msg_value(record->memory, MEM_MULT));
+}
+
+/**
+ * helper function
+ * remove the oldest n rows from the in-memory hourly header (they have been queued in the outbox)
+ * the caller writes the header - add_frame, in the same journal entry as the message
+*/
+void RemoteLogger::drop_hourly(int n){
+    if (n > hourlyHeader.count) n = hourlyHeader.count;
+
+    hourlyHeader.tail = (hourlyHeader.tail + n) % hourlyHeader.capacity;
+    hourlyHeader.count -= n;
+}
+
+/**
+ * helper function
+ * make sure the outbox header and the state of every slot are in memory, creating /OUTBOX.bin with
+ * every slot empty if needed - the slots are read in the same open, and kept up to date by add_frame
+ * and set_frame_state, so finding a message to send doesn't go back to the card
+*/
+bool RemoteLogger::load_outbox(){
+    if (outboxLoaded) return true;
+    if (journalPending) recover_journal();         // a journaled write that failed earlier this wake - finish it first
+
+    File outbox = SD.open("/OUTBOX.bin", FILE_READ);
+    if (outbox) {
+        int got = outbox.read((uint8_t *)&outboxHeader, sizeof(OutboxHeader));
+        bool good = got == sizeof(OutboxHeader) && outboxHeader.magic == OUTBOX_MAGIC
+            && outboxHeader.slots == OUTBOX_SLOTS && outboxHeader.frame_bytes == OUTBOX_FRAME_BYTES;
+        OutboxSlot slot;
+        for (int i = 0; i < OUTBOX_SLOTS && good; i++) {
+            outbox.seek(outbox_offset(i));
+            good = outbox.read((uint8_t *)&slot, sizeof(OutboxSlot)) == sizeof(OutboxSlot);
+            outboxState[i] = slot.state;
+            outboxSeq[i] = slot.seq;
+        }
+        outbox.close();
+        if (good) {
+            outboxLoaded = true;
+            return true;
+        }
+    }
+
+    // preallocate the whole file so later writes never extend it
+    outbox = SD.open("/OUTBOX.bin", FILE_RW | O_TRUNC);
+    if (!outbox) return false;
+
+    outboxHeader.magic = OUTBOX_MAGIC;
+    outboxHeader.slots = OUTBOX_SLOTS;
+    outboxHeader.frame_bytes = OUTBOX_FRAME_BYTES;
+    outboxHeader.next_seq = 0;
+    outboxHeader.reserved = 0;
+    outbox.write((const uint8_t *)&outboxHeader, sizeof(OutboxHeader));
+
+    uint8_t zeros[64];
+    memset(zeros, 0, sizeof(zeros));        // all zero is an empty slot
+    uint32_t remaining = (uint32_t)OUTBOX_SLOTS * (sizeof(OutboxSlot) + OUTBOX_FRAME_BYTES);
+    while (remaining > 0) {
+        uint16_t n = remaining > sizeof(zeros) ? sizeof(zeros) : remaining;
+        outbox.write(zeros, n);
+        remaining -= n;
+    }
+    outbox.close();
+
+    memset(outboxState, OUTBOX_EMPTY, sizeof(outboxState));
+    memset(outboxSeq, 0, sizeof(outboxSeq));
+    outboxLoaded = true;
+    return true;
+}
+
+/**
+ * helper function
+ * save a message in the next outbox slot (replacing whatever was there) and advance the sequence number
+ * drop: oldest rows to remove from the hourly store in the same journal entry - the rows in the message,
+ * so after a power cut they are either still in the store or in the outbox, never both or neither
+*/
+bool RemoteLogger::add_frame(const uint8_t *data, int len, bool binary, int drop){
+    if (!load_outbox() || len > OUTBOX_FRAME_BYTES) return false;
+    if (drop > 0 && !load_hourly()) return false;
+
+    OutboxSlot slot;
+    slot.seq = outboxHeader.next_seq;
+    slot.state = OUTBOX_PENDING;
+    slot.binary = binary;
+    slot.len = len;
+    slot.crc = crc16(data, len);
+    slot.created = rtc.now().unixtime();
+
+    outboxHeader.next_seq++;
+    if (drop > 0) drop_hourly(drop);
+
+    uint32_t offset = outbox_offset(slot.seq % OUTBOX_SLOTS);
+    JournalWrite writes[4] = {
+        {"/OUTBOX.bin", offset, &slot, sizeof(OutboxSlot)},
+        {"/OUTBOX.bin", (uint32_t)(offset + sizeof(OutboxSlot)), data, (uint16_t)len},
+        {"/OUTBOX.bin", 0, &outboxHeader, sizeof(OutboxHeader)},
+        {"/HOURLY.bin", 0, &hourlyHeader, sizeof(HourlyHeader)},
+    };
+    if (!journal_writes(writes, drop > 0 ? 4 : 3)) {
+        outboxLoaded = false;           // read the headers again, whatever made it to the card
+        hourlyLoaded = false;
+        return false;
+    }
+    outboxState[slot.seq % OUTBOX_SLOTS] = OUTBOX_PENDING;
+    outboxSeq[slot.seq % OUTBOX_SLOTS] = slot.seq;
+    return true;
+}
+
+/**
+ * helper function
+ * find the oldest (or newest) message waiting to be sent; returns its slot index or -1 if none
+*/
+int RemoteLogger::next_frame(bool newest_first, OutboxSlot *slot){
+    if (!load_outbox()) return -1;
+    int best = -1;
+    uint16_t bestAge = 0;
+
+    for (int i = 0; i < OUTBOX_SLOTS; i++) {      // from the slots kept by load_outbox
+        if (outboxState[i] != OUTBOX_PENDING) continue;
+        uint16_t age = outboxHeader.next_seq - outboxSeq[i];        // 1 is the newest
+        if (best < 0 || (newest_first ? age < bestAge : age > bestAge)) {
+            best = i;
+            bestAge = age;
+        }
+    }
+    if (best >= 0 && !read_slot(best, slot)) return -1;
+    return best;
+}
+
+/**
+ * helper function
+ * read just the state of a slot (no message data)
+*/
+bool RemoteLogger::read_slot(int index, OutboxSlot *slot){
+    File outbox = SD.open("/OUTBOX.bin", FILE_READ);
+    if (!outbox) return false;
+    outbox.seek(outbox_offset(index));
+    int got = outbox.read((uint8_t *)slot, sizeof(OutboxSlot));
+    outbox.close();
+    return got == sizeof(OutboxSlot);
+}
+
+/**
+ * helper function
+ * read a slot and its message into data (OUTBOX_FRAME_BYTES + 1 long); false if the message is damaged
+*/
+bool RemoteLogger::read_frame(int index, OutboxSlot *slot, uint8_t *data){
+    File outbox = SD.open("/OUTBOX.bin", FILE_READ);
+    if (!outbox) return false;
+    outbox.seek(outbox_offset(index));
+    int got = outbox.read((uint8_t *)slot, sizeof(OutboxSlot));
+    bool good = got == sizeof(OutboxSlot) && slot->len <= OUTBOX_FRAME_BYTES
+        && outbox.read(data, slot->len) == slot->len;
+    outbox.close();
+    return good && crc16(data, slot->len) == slot->crc;
+}
+
+/**
+ * helper function
+ * mark a slot sent (or empty) - rewrites only the slot's state byte
+*/
+void RemoteLogger::set_frame_state(int index, uint8_t state){
+    File outbox = SD.open("/OUTBOX.bin", FILE_RW);
+    if (!outbox) return;
+    outbox.seek(outbox_offset(index) + offsetof(OutboxSlot, state));
+    if (outbox.write(&state, 1) == 1) outboxState[index] = state;
+    outbox.close();
+}
+
+/**
+ * helper function
+ * position of a slot in /OUTBOX.bin
+*/
+uint32_t RemoteLogger::outbox_offset(int index){
+    return sizeof(OutboxHeader) + (uint32_t)index * (sizeof(OutboxSlot) + OUTBOX_FRAME_BYTES);
+}
+
+/**
+ * helper function
+ * identifier for the message layout: CRC-16 of the letters and multipliers
+ * changes whenever the parameters being sent change, so the decoder can tell layouts apart
+*/
+uint16_t RemoteLogger::binary_schema_id(){
+    char letters[MAX_PARAMS + 1];
+    letters[param_letters(letters)] = '\0';
+    float multipliers[MAX_PARAMS];         // myParams is at most MAX_PARAMS (constructor)
+    for (int i = 0; i < myParams; i++) multipliers[i] = param_multiplier(i);
+    rl_codec::Schema schema = {letters, myParams, multipliers};
+    return rl_codec::schema_id(schema);
+}
+
+/**
+ * helper function
+ * write a signed value as a zig-zag varint (7 bits per byte, small magnitudes take one byte)
+ * out can be NULL to just count the bytes; returns the number of bytes
+*/
+int RemoteLogger::put_varint(uint8_t *out, long value){
+    return rl_codec::put_varint(out, value);
+}
+
+/**
+ * helper function
+ * bytes for one row of a binary message: time and values as changes from the previous row,
+ * or from zero for the first row (prev NULL)
+*/
+int RemoteLogger::binary_row(uint8_t *out, HourlyRecord *record, HourlyRecord *prev){
+    long values[MAX_PARAMS], prev_values[MAX_PARAMS];
+    int n = sent_values(record, values);
+    if (prev) sent_values(prev, prev_values);
+    return rl_codec::put_binary_row(out, prev ? record->timestamp - prev->timestamp : 0, values, prev ? prev_values : NULL, n);
+}
+
+/**
+ * helper function
+ * the values of record that go in a message (value * multiplier, rounded), in order, returns how many
+ * out holds MAX_PARAMS values - myParams is never more (see the constructor)
+*/
+int RemoteLogger::sent_values(HourlyRecord *record, long *out){
+    int n = 0;
+    for (int i = 0; i < myParams; i++) {
+        if (param_multiplier(i) != 0) out[n++] = scale_msg_value(record->values[i], param_multiplier(i));     // 0 = not sent
+    }
+    return n;
+}
+
+/**
+ * helper function
+ * make sure the counters are in memory, reading the newest good slot from /STATE.bin
+ * the file is only read once per power cycle; if there is no valid slot the counters start at zero
+*/
+bool RemoteLogger::load_state(){
+    if (stateLoaded) return true;
+
+    memset(&state, 0, sizeof(LoggerState));
+    state.magic = STATE_MAGIC;
+    state.size = sizeof(LoggerState);
+    state.last_signal = 255;        // no modem session yet
+
+    if (!load_slots("/STATE.bin", &state, sizeof(LoggerState), STATE_MAGIC, STATE_SLOTS)) return false;
+    stateLoaded = true;
+    return true;
+}
+
+/**
+ * helper function
+ * write the counters to the slot after the newest one in /STATE.bin (see save_slots)
+*/
+void RemoteLogger::save_state(){
+    save_slots("/STATE.bin", &state, sizeof(LoggerState), STATE_SLOTS);
+}
+
+/**
+ * helper function
+ * make writes that belong together through the write-ahead journal (/JOURNAL.bin):
+ * copy them there, make them in their own files, then mark the entry done
+ * if the power is cut before the copy is complete nothing has changed; after that, begin() makes them
+ * (again) from the copy, so each file ends up with all of the writes or none
+ * an entry left pending by a failed write is made first, as begin() would - until it is, nothing new is
+ * journaled, since the new entry would overwrite its copy
+ * returns false if the writes couldn't all be made (a complete copy is left for begin)
+*/
+bool RemoteLogger::journal_writes(const JournalWrite *writes, int n){
+    if (!sd_ready() || n > JOURNAL_WRITES) return false;
+    if (journalPending) recover_journal();
+    if (journalPending) return false;
+
+    JournalHeader header;
+    header.magic = JOURNAL_MAGIC;
+    header.state = JOURNAL_PENDING;
+    header.reserved = 0;
+    header.seq = ++journalSeq;
+    header.size = 0;
+    header.count = n;
+    header.reserved2 = 0;
+    int data = 0;
+    for (int i = 0; i < n; i++) {
+        header.size += sizeof(JournalExtent) + writes[i].len;
+        data += writes[i].len;
+    }
+    if (data > JOURNAL_DATA_BYTES) return false;
+
+    // the copy: writes first, header last
+    File journal = SD.open("/JOURNAL.bin", FILE_RW);
+    if (!journal) return false;
+    if (journal.size() < JOURNAL_BYTES) {          // first use - preallocate so entries never extend the file
+        uint8_t zeros[64];
+        memset(zeros, 0, sizeof(zeros));
+        journal.seek(journal.size());
+        for (uint32_t left = JOURNAL_BYTES - journal.size(); left > 0; ) {
+            uint16_t k = left > sizeof(zeros) ? sizeof(zeros) : left;
+            journal.write(zeros, k);
+            left -= k;
+        }
+    }
+    header.crc = crc16((const uint8_t *)&header.seq, sizeof(JournalHeader) - offsetof(JournalHeader, seq));
+    journal.seek(sizeof(JournalHeader));
+    for (int i = 0; i < n; i++) {
+        JournalExtent extent;
+        memset(&extent, 0, sizeof(JournalExtent));
+        strncpy(extent.name, writes[i].name, sizeof(extent.name) - 1);
+        extent.offset = writes[i].offset;
+        extent.len = writes[i].len;
+        journal.write((const uint8_t *)&extent, sizeof(JournalExtent));
+        journal.write((const uint8_t *)writes[i].data, writes[i].len);
+        header.crc = crc16((const uint8_t *)&extent, sizeof(JournalExtent), header.crc);
+        header.crc = crc16((const uint8_t *)writes[i].data, writes[i].len, header.crc);
+    }
+    journal.seek(0);
+    journal.write((const uint8_t *)&header, sizeof(JournalHeader));
+    journal.close();            // on the card from here
+    journalPending = true;
+
+    // the writes themselves, one open per file
+    bool good = true;
+    for (int i = 0; i < n && good; i++) {
+        File file = SD.open(writes[i].name, FILE_RW);
+        if (!file) {
+            good = false;
+            break;
+        }
+        for (; i < n; i++) {
+            good = good && file.seek(writes[i].offset) && file.write((const uint8_t *)writes[i].data, writes[i].len) == writes[i].len;
+            if (i + 1 < n && strcmp(writes[i + 1].name, writes[i].name) != 0) break;
+        }
+        file.close();
+    }
+    if (!good) return false;
+
+    journal = SD.open("/JOURNAL.bin", FILE_RW);
+    if (!journal) return false;
+    uint8_t done = JOURNAL_DONE;
+    journal.seek(offsetof(JournalHeader, state));
+    journalPending = journal.write(&done, 1) != 1;
+    journal.close();
+    return true;
+}
+
+/**
+ * helper function
+ * finish the last journal entry if the power was cut before all of its writes were made
+ * reads only /JOURNAL.bin (at most JOURNAL_BYTES), so startup takes the same time however much data
+ * the logger holds; an entry that was never completely copied is dropped - its files weren't touched
+*/
+void RemoteLogger::recover_journal(){
+    File journal = SD.open("/JOURNAL.bin", FILE_READ);
+    if (!journal) return;           // nothing journaled yet
+
+    JournalHeader header;
+    bool found = journal.read((uint8_t *)&header, sizeof(JournalHeader)) == sizeof(JournalHeader)
+        && header.magic == JOURNAL_MAGIC;
+    if (!found || header.state != JOURNAL_PENDING) {
+        if (found) journalSeq = header.seq;
+        journalPending = false;
+        journal.close();
+        return;
+    }
+    journalSeq = header.seq;
+    journalPending = true;
+
+    bool complete = header.count <= JOURNAL_WRITES && header.size <= JOURNAL_BYTES - sizeof(JournalHeader)
+        && copy_journal(journal, &header, false);
+    bool made = complete && copy_journal(journal, &header, true);
+    journal.close();
+    if (complete && !made) return;          // couldn't open a file - try again later
+
+    // made now, or torn before the copy was complete (nothing to make) - the entry is finished
+    journal = SD.open("/JOURNAL.bin", FILE_RW);
+    if (!journal) return;
+    uint8_t done = JOURNAL_DONE;
+    journal.seek(offsetof(JournalHeader, state));
+    journalPending = journal.write(&done, 1) != 1;
+    journal.close();
+}
+
+/**
+ * helper function
+ * go through the writes of a journal entry: check them against the entry's checksum (apply false),
+ * or make them in their files (apply true); returns false if the entry is damaged or a file can't be opened
+*/
+bool RemoteLogger::copy_journal(File &journal, JournalHeader *header, bool apply){
+    uint16_t crc = crc16((const uint8_t *)&header->seq, sizeof(JournalHeader) - offsetof(JournalHeader, seq));
+    uint8_t chunk[64];
+
+    journal.seek(sizeof(JournalHeader));
+    uint32_t left = header->size;
+    for (int i = 0; i < header->count; i++) {
+        JournalExtent extent;
+        if (left < sizeof(JournalExtent) || journal.read((uint8_t *)&extent, sizeof(JournalExtent)) != sizeof(JournalExtent)) return false;
+        left -= sizeof(JournalExtent);
+        if (extent.len > left) return false;
+        left -= extent.len;
+        crc = crc16((const uint8_t *)&extent, sizeof(JournalExtent), crc);
+        extent.name[sizeof(extent.name) - 1] = '\0';
+
+        File file;
+        if (apply) {
+            file = SD.open(extent.name, FILE_RW);
+            if (!file) return false;
+            if (!file.seek(extent.offset)) {            // the file lost what came before - nothing to put this after
+                file.close();
+                journal.seek(journal.position() + extent.len);
+                continue;
+            }
+        }
+        for (int done = 0; done < extent.len; ) {
+            int k = extent.len - done > (int)sizeof(chunk) ? (int)sizeof(chunk) : extent.len - done;
+            if (journal.read(chunk, k) != k) {
+                if (apply) file.close();
+                return false;
+            }
+            if (apply) file.write(chunk, k);
+            else crc = crc16(chunk, k, crc);
+            done += k;
+        }
+        if (apply) file.close();
+    }
+    return apply || crc == header->crc;
+}
+
+/**
+ * helper function
+ * read the newest good slot of /IMAGE.bin into image, only once per power cycle
+ * returns false if the card can't be used
+*/
+bool RemoteLogger::load_image(){
+    if (imageLoaded) return true;
+
+    memset(&image, 0, sizeof(ImageState));
+    image.magic = IMAGE_MAGIC;
+    image.size = sizeof(ImageState);
+
+    if (!load_slots("/IMAGE.bin", &image, sizeof(ImageState), IMAGE_MAGIC, IMAGE_SLOTS)) return false;
+    imageLoaded = true;
+    return true;
+}
+
+/**
+ * helper function
+ * write image to the next slot of /IMAGE.bin
+*/
+void RemoteLogger::save_image(){
+    save_slots("/IMAGE.bin", &image, sizeof(ImageState), IMAGE_SLOTS);
+}
+
+/**
+ * helper function
+ * build frame seq (1 to image.total) of the image in buf, cut straight from the JPEG
+ * header: seq, total, size (2 bytes), lines and columns (3 bytes, 12 bits each), year, month, day,
+ * hour, id, CRC-16 of the payload (2 bytes) - seq, total, id and the time are where the
+ * JPEGTimelapse prototype put them
+ * returns the frame length, 0 if the JPEG can't be read
+*/
+int RemoteLogger::image_frame(int seq, uint8_t *buf){
+    File jpeg = SD.open(image.name, FILE_READ);
+    if (!jpeg) return 0;
+    uint32_t offset = (uint32_t)(seq - 1) * IMAGE_PAYLOAD_BYTES;
+    int len = image.image_bytes - offset < IMAGE_PAYLOAD_BYTES ? image.image_bytes - offset : IMAGE_PAYLOAD_BYTES;
+    bool ok = jpeg.seek(offset) && jpeg.read(buf + IMAGE_HEADER_BYTES, len) == len;
+    jpeg.close();
+    if (!ok) return 0;
+
+    uint16_t crc = crc16(buf + IMAGE_HEADER_BYTES, len);
+    buf[0] = seq;
+    buf[1] = image.total;
+    buf[2] = image.image_bytes >> 8;
+    buf[3] = image.image_bytes & 0xFF;
+    buf[4] = (image.lines & 0x0FF0) >> 4;
+    buf[5] = ((image.lines & 0x000F) << 4) | ((image.columns & 0x0F00) >> 8);
+    buf[6] = image.columns & 0x00FF;
+    buf[7] = image.year;
+    buf[8] = image.month;
+    buf[9] = image.day;
+    buf[10] = image.hour;
+    buf[11] = image.id;
+    buf[12] = crc >> 8;
+    buf[13] = crc & 0xFF;
+    return IMAGE_HEADER_BYTES + len;
+}
+
+/**
+ * helper function
+ * send up to max_frames unsent frames of the image in the open session, marking each on the card as it goes
+ * frames are cut for Iridium, so links that take shorter messages leave the image for a later session
+ * err is set to the last link error; returns the number of frames sent
+*/
+int RemoteLogger::send_image_frames(Transport *link, int max_frames, int *err){
+    if (!load_image()) return 0;
+    if (link->mtu < IMAGE_HEADER_BYTES + IMAGE_PAYLOAD_BYTES) return 0;
+
+    int sent = 0;
+    for (int seq = 1; seq <= image.total && sent < max_frames; seq++) {
+        int i = seq - 1;
+        if (image.sent[i / 8] & (1 << (i % 8))) continue;
+
+        if (!link->link_up()) {
+            *err = ISBD_NO_NETWORK;     // link too poor - try again next session
+            break;
+        }
+
+        int len = image_frame(seq, (uint8_t *)msgBuf);
+        if (len == 0) {             // JPEG gone or damaged - nothing more to send of it
+            image.total = 0;
+            save_image();
+            break;
+        }
+        *err = link_send(link, (const uint8_t *)msgBuf, len, true);
+        if (*err != ISBD_SUCCESS) break;        // try again next session
+
+        image.sent[i / 8] |= 1 << (i % 8);
+        save_image();
+        sent++;
+    }
+    return sent;
+}
+
+/**
+ * helper function
+ * CRC-16/CCITT over len bytes, pass the previous result as crc to continue a checksum
+*/
+uint16_t RemoteLogger::crc16(const uint8_t *data, uint32_t len, uint16_t crc){
+    return rl_codec::crc16(data, len, crc);
+}
+
+/**
+ * helper function
+ * read the newest good record of a slot file (/STATE.bin and the like) into buf - slots records of size
+ * bytes, each starting with a SlotHeader; a slot is good if its magic and size match and the CRC-16
+ * from seq to the end of the record is right (checked a chunk at a time, then only the newest is read)
+ * buf keeps the caller's defaults if no slot is good, or if the file hasn't been written yet
+ * returns false if the card or the file can't be read
+*/
+bool RemoteLogger::load_slots(const char *path, void *buf, uint16_t size, uint32_t magic, int slots){
+    if (!sd_ready()) return false;
+    File file = SD.open(path, FILE_READ);
+    if (!file) return !SD.exists(path);         // nothing saved yet
+
+    int best = -1;
+    uint32_t bestSeq = 0;
+    uint8_t chunk[32];
+    for (int i = 0; i < slots; i++) {
+        SlotHeader header;
+        file.seek((uint32_t)i * size);
+        if (file.read((uint8_t *)&header, sizeof(SlotHeader)) != sizeof(SlotHeader)) break;
+        if (header.magic != magic || header.size != size) continue;
+
+        uint16_t crc = crc16((const uint8_t *)&header.seq, sizeof(header.seq));
+        int left = size - sizeof(SlotHeader);
+        while (left > 0) {
+            int k = left < (int)sizeof(chunk) ? left : sizeof(chunk);
+            if (file.read(chunk, k) != k) break;
+            crc = crc16(chunk, k, crc);
+            left -= k;
+        }
+        if (left > 0 || crc != header.crc) continue;        // torn or corrupted write
+        if (best < 0 || header.seq > bestSeq) {
+            best = i;
+            bestSeq = header.seq;
+        }
+    }
+
+    bool good = best < 0 || (file.seek((uint32_t)best * size) && file.read((uint8_t *)buf, size) == size);
+    file.close();
+    return good;
+}
+
+/**
+ * helper function
+ * write buf (a record read by load_slots) to the slot after the newest, advancing its seq and setting
+ * its CRC - a single small in-place write, so the older slots stay intact if power is cut during it
+ * the first save fills every slot, so later ones never grow the file
+*/
+void RemoteLogger::save_slots(const char *path, void *buf, uint16_t size, int slots){
+    uint8_t *record = (uint8_t *)buf;
+    uint32_t seq;
+    memcpy(&seq, record + offsetof(SlotHeader, seq), sizeof(seq));
+    seq++;
+    memcpy(record + offsetof(SlotHeader, seq), &seq, sizeof(seq));
+    uint16_t crc = crc16(record + offsetof(SlotHeader, seq), size - offsetof(SlotHeader, seq));
+    memcpy(record + offsetof(SlotHeader, crc), &crc, sizeof(crc));
+
+    File file = SD.open(path, FILE_RW);
+    if (!file) return;
+    if (file.size() < (uint32_t)slots * size) {
+        for (int i = 0; i < slots; i++) file.write(record, size);
+    } else {
+        file.seek((uint32_t)(seq % slots) * size);
+        file.write(record, size);
+    }
+    file.close();
+}
+
+
+
+
+/**
+ * helper function
+ * start the SD card the first time it is needed after power up - SD.begin only needs to run once
+*/
+bool RemoteLogger::sd_ready(){
+    if (!sdStarted) sdStarted = SD.begin(chipSelect);
+    return sdStarted;
+}
+
+/**
+ * helper function
+ * add a line (and the header if the file is new) to the RAM buffer for outname
+ * header NULL for the one built from the compile-time schema
+ * the file is only opened once per wake to find its size, then again each time a block is written;
+ * blocks end on the card's 512 byte boundaries so the card never has to read back and merge a
+ * partly written block
+*/
+void RemoteLogger::append_log(const char *outname, const char *header, const char *line){
+    PhaseTimer timer(*this, PHASE_SD);
+
+    // find the buffer for this file, or a free one
+    LogSink *sink = NULL;
+    for (int i = 0; i < LOG_SINKS && sink == NULL; i++) {
+        if (strncmp(logSinks[i].name, outname, sizeof(logSinks[i].name)) == 0) sink = &logSinks[i];
+    }
+    if (sink == NULL) {
+        for (int i = 0; i < LOG_SINKS && sink == NULL; i++) {
+            if (logSinks[i].name[0] == '\0') sink = &logSinks[i];
+        }
+        if (sink == NULL) {         // all in use - make room
+            sink = &logSinks[0];
+            if (sink->len > 0) write_log_block(sink, sink->len);
+        }
+        if (!sd_ready()) return;
+        File logFile = SD.open(outname, FILE_WRITE);
+        if (!logFile) return;
+        strncpy(sink->name, outname, sizeof(sink->name) - 1);
+        sink->name[sizeof(sink->name) - 1] = '\0';
+        sink->size = logFile.size();
+        sink->len = 0;
+        if (sink->size > 0 && logFile.seek(sink->size - 1) && logFile.read() != '\n') {
+            // a row torn by a power cut - end it, so the next row starts on its own line
+            memcpy(sink->buf, "\r\n", 2);
+            sink->len = 2;
+        }
+        logFile.close();
+
+        if (sink->size == 0) {          // new file - header first
+            if (header != NULL) {
+                append_log(outname, "", header);
+            } else {
+                char schema_line[RECORD_CHARS];
+                schema_header(schema_line, sizeof(schema_line));
+                append_log(outname, "", schema_line);
+            }
+        }
+    }
+
+    // add the line, writing out each block as it fills
+    const char *parts[2] = {line, "\r\n"};
+    for (int p = 0; p < 2; p++) {
+        const char *c = parts[p];
+        while (*c) {
+            sink->buf[sink->len++] = *c++;
+            int room = LOG_BLOCK - sink->size % LOG_BLOCK;         // bytes left in the card's current block
+            if (sink->len >= room) write_log_block(sink, room);
+        }
+    }
+}
+
+/**
+ * helper function
+ * write the first len buffered bytes of a CSV file and keep the rest
+*/
+void RemoteLogger::write_log_block(LogSink *sink, int len){
+    // an append - not journaled: a cut leaves at most a torn last row, and the rows before it are whole
+    File logFile = SD.open(sink->name, FILE_WRITE);
+    if (!logFile) return;           // kept in RAM to try again
+    logFile.write((const uint8_t *)sink->buf, len);
+    logFile.close();
+
+    sink->size += len;
+    sink->len -= len;
+    memmove(sink->buf, sink->buf + len, sink->len);
+}
+
+/**
+ * helper function
+ * read the /PROFILE.bin header, false if the file isn't a profile ring for this version
+*/
+bool RemoteLogger::load_profile_header(File &file, ProfileHeader *header){
+    file.seek(0);
+    if (file.read((uint8_t *)header, sizeof(ProfileHeader)) != sizeof(ProfileHeader)) return false;
+    return header->magic == PROFILE_MAGIC && header->record_size == sizeof(ProfileRecord)
+        && header->capacity == PROFILE_CAPACITY && header->head < PROFILE_CAPACITY;
+}
+
+/**
+ * helper function
+ * finish this wake's profile and write it to the next slot of /PROFILE.bin (created at full size on first use)
+*/
+void RemoteLogger::write_profile(){
+    if (!sd_ready()) return;
+    profile.timestamp = rtc.now().unixtime();
+    profile.awake_ms = now_ms();
+    profile.batt_mv = sample_batt_v() * 1000;
+    MemoryStats memory;
+    memory_stats(&memory);
+    profile.free_fragments = memory.free_fragments;
+    profile.largest_block = memory.largest_block;
+    profile.stack_used = memory.stack_used;
+    profile.stack_margin = memory.stack_margin;
+    profile.allocs = memory.allocs > 0xFFFF ? 0xFFFF : memory.allocs;
+
+    File profileFile = SD.open("/PROFILE.bin", FILE_RW);
+    if (!profileFile) return;
+
+    ProfileHeader header;
+    if (!load_profile_header(profileFile, &header)) {
+        // first use (or a different version) - preallocate every slot
+        header.magic = PROFILE_MAGIC;
+        header.record_size = sizeof(ProfileRecord);
+        header.capacity = PROFILE_CAPACITY;
+        header.head = 0;
+        header.count = 0;
+        profileFile.seek(0);
+        profileFile.write((const uint8_t *)&header, sizeof(ProfileHeader));
+        ProfileRecord empty;
+        memset(&empty, 0, sizeof(ProfileRecord));
+        for (int i = 0; i < PROFILE_CAPACITY; i++) {
+            profileFile.write((const uint8_t *)&empty, sizeof(ProfileRecord));
+        }
+    }
+
+    profileFile.seek(sizeof(ProfileHeader) + (uint32_t)header.head * sizeof(ProfileRecord));
+    profileFile.write((const uint8_t *)&profile, sizeof(ProfileRecord));
+    header.head = (header.head + 1) % header.capacity;
+    if (header.count < header.capacity) header.count++;
+    profileFile.seek(0);
+    profileFile.write((const uint8_t *)&header, sizeof(ProfileHeader));
+    profileFile.close();
+}
+
+/**
+ * helper function
+ * summary of the last wake for the end of a text message: "P<awake ms>,<sensor ms>,<modem ms>,<modem drop mV>:"
+ * writes nothing (returns 0) if profiling isn't in messages or there is no profile yet
+*/
+int RemoteLogger::profile_summary(char *out){
+    ProfileRecord last;
+    if (!profileInMsg || !read_profile(num_profiles() - 1, &last)) return 0;
+
+    unsigned long sensors = 0;
+    for (int i = PHASE_SDI12; i <= PHASE_JOBS; i++) sensors += last.phase_us[i];
+    unsigned long modem = last.phase_us[PHASE_MODEM_ON] + last.phase_us[PHASE_MODEM_SEND];
+    int drop = last.modem_before_mv > last.modem_after_mv ? last.modem_before_mv - last.modem_after_mv : 0;
+
+    return snprintf(out, 44, "P%lu,%lu,%lu,%d:", (unsigned long)last.awake_ms, sensors / 1000, modem / 1000, drop);
+}
+
+/**
+ * helper function
+ * update the settings from PARAM.txt style text (see apply_params), returns true if any changed
 */
-String RemoteLogger::produce_csv_setting(){
-    String setting = "s";
-    for (int i = 1; i < myParams+3; i++){
-        setting += "f";
+bool RemoteLogger::parse_params(const char *text){
+    char buf[PARAM_CHARS + 1];
+    strncpy(buf, text, PARAM_CHARS);
+    buf[PARAM_CHARS] = '\0';
+
+    // split into the names line and the values line
+    char *values = strpbrk(buf, "\n;");
+    if (values == NULL) return false;
+    if (values > buf && values[-1] == '\r') values[-1] = '\0';
+    *values++ = '\0';
+
+    bool changed = false;
+    char *name_end;
+    char *value_end;
+    char *name = strtok_r(buf, ",", &name_end);
+    char *value = strtok_r(values, ",\r\n", &value_end);
+    while (name != NULL && value != NULL) {
+        while (*name == ' ') name++;
+        long n = strtol(value, NULL, 10);
+
+        if (strcmp(name, "sample_freq_m") == 0 && n >= 1 && n <= 1440) {
+            changed |= sampleFreqM != n;
+            sampleFreqM = n;
+        } else if (strcmp(name, "irid_freq_h") == 0 && n >= 1 && n <= 255) {
+            changed |= minSendRows != n;
+            minSendRows = n;
+        }
+
+        name = strtok_r(NULL, ",", &name_end);
+        value = strtok_r(NULL, ",\r\n", &value_end);
     }
-    return setting;
+    return changed;
+}
+
+/**
+ * helper function
+ * read the settings from /PARAM.txt if there is one - a damaged file leaves the defaults in place
+*/
+void RemoteLogger::read_params(){
+    File paramFile = SD.open("/PARAM.txt", FILE_READ);
+    if (!paramFile) return;
+
+    char buf[PARAM_CHARS + 1];
+    int len = paramFile.read((uint8_t *)buf, PARAM_CHARS);
+    paramFile.close();
+    if (len <= 0) return;
+    buf[len] = '\0';
+
+    parse_params(buf);
+}
+
+/**
+ * helper function
+ * save the settings to /PARAM.txt, in the same layout as the old PARAM.txt files
+*/
+void RemoteLogger::write_params(){
+    SD.remove("/PARAM.txt");
+    File paramFile = SD.open("/PARAM.txt", FILE_WRITE);
+    if (!paramFile) return;
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "sample_freq_m,irid_freq_h\n%d,%d\n", sampleFreqM, minSendRows);
+    paramFile.print(buf);
+    paramFile.close();
 }
 
 
@@ -10,6 +10,7 @@
 
 #include <Arduino.h>
 #include <time.h>
+#include <stddef.h>             // offsetof, for checksummed structs
 #include <SPI.h>                // for SD communcation protocol
 #include <SD.h>                 // for working with SD card
 #include <IridiumSBD.h>         // for working with Iridium RockBlock modem
@@ -18,15 +19,587 @@
 #include <SDI12.h>              // for SDI-12 sensors
 #include <QuickStats.h>         // statistics - used for ultrasonic
 #include <MemoryFree.h>         // free memory - deprecate eventually?
+#include <Wire.h>               // I2C - RTC and SHT31
+#ifndef RL_NO_SHT31             // build with -DRL_NO_SHT31 to leave out the SHT31 driver and its library
 #include <Adafruit_SHT31.h>     // for temp/RH SHT31 sensor
-#include <Wire.h>               // for temp/RH SHT31 sensor - I2C
+#endif
+#ifndef RL_NO_DS18B20           // build with -DRL_NO_DS18B20 to leave out the DS18B20 driver and its libraries
 #include <OneWire.h>            // for DS18B20 - I2C
 #include <DallasTemperature.h>  // for DS18B20
+#endif
+#ifdef ARDUINO_ARCH_SAMD
+#include <ArduinoLowPower.h>    // standby with RTC wakeup - for idle_wait
+#include <Adafruit_SleepyDog.h> // keep the watchdog fed while asleep
+#endif
+#include "RemoteLoggerCodec.h"     // message encoding, shared with the tools that decode them
+#include "RemoteLoggerTransport.h"     // links the outbox can be sent over
 
 #define IridiumSerial Serial1       // define port for Iridium serial communication
 // #define TOTAL_KEYS 6                // number of entries in dictionary
 //IridiumSBD modem(IridiumSerial);
 
+#define FILE_RW (O_READ | O_WRITE | O_CREAT)     // open for overwriting in place (FILE_WRITE always appends)
+
+#define MAX_PARAMS 16               // most sampled parameters a logger can store (excluding batt_v and memory)
+#define HOURLY_CAPACITY 240         // hourly records kept in the ring file (10 days at one per hour)
+#define HOURLY_MAGIC 0x31484C52     // "RLH1" - marks a valid hourly ring file
+
+static_assert(CODEC_MAX_VALUES >= MAX_PARAMS, "the codec has to hold a row of every parameter");
+
+#define OUTBOX_SLOTS 32             // messages kept in /OUTBOX.bin
+#define OUTBOX_FRAME_BYTES 340      // largest message (SBD limit)
+#define OUTBOX_MAGIC 0x314F4C52     // "RLO1" - marks a valid outbox file
+#define OUTBOX_MIN_SIGNAL 1         // signal quality (0-5) needed to keep sending from the outbox
+#define MAX_TRANSPORTS 4            // links for the outbox, Iridium included (add_transport)
+#define LINK_MAX_FAILS 3            // failed sessions in a row before a link is only tried now and then
+#define LINK_RETRY_SESSIONS 8       // sessions a failing link sits out between tries
+
+/* state of an outbox slot */
+#define OUTBOX_EMPTY 0
+#define OUTBOX_PENDING 1
+#define OUTBOX_SENT 2
+
+/* modem warmed up while the sensors sample (warm_modem) */
+#define MODEM_POWER_MS 2000         // RockBLOCK power up before it answers
+#define MODEM_POLL_MS 5000          // signal quality asked this often while the sensors sample
+#define MODEM_OFF 0
+#define MODEM_POWERING 1            // powered, not yet begun
+#define MODEM_READY 2               // begun - the session starts straight away
+#define MODEM_FAILED 3              // begin failed - the session tries again
+
+/* modem sessions and remote configuration */
+#define SBD_MT_BYTES 270            // longest message the RockBLOCK can receive
+#define MT_MAX_PER_SESSION 4        // most waiting messages to pick up in one session
+#define PARAM_CHARS 128             // longest PARAM.txt or configuration message
+
+/* decisions from plan_send */
+#define SEND_NOW 0                  // send everything waiting
+#define SEND_LOW_POWER 1            // battery low - send only the most recent sample, leave the rest queued
+#define SEND_WAIT 2                 // not enough data yet - batch more rows first
+#define SEND_DEFER 3                // backing off after failures, or battery too low for the modem
+
+/* adaptive sampling (adaptive_sample) */
+#define ADAPT_WINDOW 4              // recent samples of the event parameter kept to work out its rate of change
+#define ADAPT_HOLD 4                // samples an event carries on for after the last trigger
+#define ADAPT_SKIP 0                // sample not written to the hourly store
+#define ADAPT_HOURLY 1              // written to the hourly store on the usual schedule
+#define ADAPT_EVENT 2               // written to the hourly store because of an event
+
+/* what goes in the hourly store for each parameter (setAggregates) */
+#define STAT_LAST 0                 // the sample at the time of the write (the only choice without setAggregates)
+#define STAT_MEAN 1
+#define STAT_MIN 2
+#define STAT_MAX 3
+#define STAT_STDDEV 4               // sample standard deviation, 0 with fewer than two samples
+
+#define STATE_SLOTS 8               // copies of the counter block in /STATE.bin, written in turn
+#define STATE_MAGIC 0x31534C52      // "RLS1" - marks a valid counter slot
+#define TASK_SLOTS 16               // scheduled sensors and tasks whose last run is kept with the counters
+
+/**
+ * running statistics of one parameter since the last hourly write (Welford's method)
+ * a constant amount of work and memory per sample, nothing reread from DATA.csv
+ */
+struct RunningStats {
+    uint16_t n;                 // samples with a reading
+    uint16_t reserved;
+    float mean;
+    float m2;                   // sum of squared differences from the mean
+    float min;
+    float max;
+};
+
+/**
+ * start of every record kept in a slot file (/STATE.bin, /IMAGE.bin, /SDI12.bin, /DS18B20.bin): each
+ * save goes to the next slot, and the slot with the highest seq and a good CRC-16 of everything from
+ * seq on wins, so a brownout mid-write loses only that save (load_slots, save_slots)
+ */
+struct SlotHeader {
+    uint32_t magic;
+    uint16_t size;              // size of the record when it was written
+    uint16_t crc;
+    uint32_t seq;               // save counter - newest slot has the highest
+};
+
+/**
+ * counters that have to survive the TPL cutting power between samples
+ * kept on the SD card in /STATE.bin: each save goes to the next of STATE_SLOTS slots and the
+ * slot with the highest seq and a good checksum wins, so a brownout mid-write loses only that save
+ * (the PCF8523 has no spare user RAM and the SAMD21 has no backup RAM, so the card is the only place)
+ */
+struct LoggerState {
+    uint32_t magic;
+    uint16_t size;                      // sizeof(LoggerState) when it was written
+    uint16_t crc;                       // CRC-16 of everything after this field
+    uint32_t seq;                       // save counter - newest slot has the highest
+    uint16_t samples_since_hourly;      // samples taken since the last write to the hourly store
+    uint16_t hours_since_send;          // hourly samples written since the last successful send
+    uint16_t failed_sends;              // send attempts failed in a row
+    uint8_t last_signal;                // signal quality (0-5) at the last modem session, 255 if not known
+    uint8_t reserved;
+    uint32_t next_send;                 // earliest time for the next send attempt (backoff), seconds since 1970
+    float recent[ADAPT_WINDOW];         // event parameter at the last few samples, oldest first (adaptive_sample)
+    uint32_t recent_time[ADAPT_WINDOW]; // times of those samples, seconds since 1970
+    uint8_t recent_count;
+    uint8_t event_hold;                 // samples left before the current event ends, 0 if there isn't one
+    uint8_t event_send;                 // 1 if an event is waiting for an early send
+    uint8_t reserved2;
+    RunningStats stats[MAX_PARAMS];     // per parameter since the last hourly write (setAggregates)
+    uint32_t task_runs[TASK_SLOTS];     // period each sensor with a period, then each task, last ran in (+1, 0 = never)
+    uint8_t link_fails[MAX_TRANSPORTS]; // failed sessions in a row per link, counting those it sat out
+};
+static_assert(offsetof(LoggerState, seq) == offsetof(SlotHeader, seq), "LoggerState starts like a SlotHeader");
+
+/**
+ * header at the start of /HOURLY.bin
+ * head is the next slot to write, tail is the oldest unsent record
+ */
+struct HourlyHeader {
+    uint32_t magic;
+    uint16_t record_size;       // bytes per record on the card: timestamp + batt + memory + params
+    uint16_t capacity;          // number of record slots preallocated after the header
+    uint16_t head;
+    uint16_t tail;
+    uint16_t count;             // records waiting between tail and head
+    uint16_t reserved;
+};
+
+/**
+ * one hourly sample as stored in the ring file
+ * only the first myParams values are written to the card
+ */
+struct HourlyRecord {
+    uint32_t timestamp;         // seconds since 1970 (DateTime::unixtime)
+    float batt_v;
+    float memory;
+    float values[MAX_PARAMS];
+};
+
+/* archive - every measurement as a binary record in daily segments, /LOG/YYMM/DD.bin */
+#define ARCHIVE_MAGIC 0x31414C52    // "RLA1" - marks an archive segment
+#define ARCHIVE_INDEX "/LOG/INDEX.bin"
+
+/**
+ * header at the start of each archive segment, followed by records in the hourly store layout
+ * (HourlyRecord, record_size bytes each) in the order they were written
+ */
+struct ArchiveHeader {
+    uint32_t magic;
+    uint16_t record_size;
+    uint16_t reserved;
+};
+
+/**
+ * one day of the archive in /LOG/INDEX.bin - an entry is added just before each day's segment is started
+ */
+struct ArchiveEntry {
+    uint32_t day;               // midnight at the start of the day, seconds since 1970
+    uint16_t record_size;
+    uint16_t reserved;
+};
+
+/**
+ * header at the start of /OUTBOX.bin
+ */
+struct OutboxHeader {
+    uint32_t magic;
+    uint16_t slots;
+    uint16_t frame_bytes;
+    uint16_t next_seq;          // sequence number for the next message queued
+    uint16_t reserved;
+};
+
+/**
+ * one outbox slot as stored on the card, followed by OUTBOX_FRAME_BYTES of message
+ * message n goes in slot n % OUTBOX_SLOTS
+ */
+struct OutboxSlot {
+    uint16_t seq;
+    uint8_t state;              // OUTBOX_EMPTY, OUTBOX_PENDING or OUTBOX_SENT
+    uint8_t binary;             // 1 for a binary message, 0 for text
+    uint16_t len;
+    uint16_t crc;               // CRC-16 of the message
+    uint32_t created;           // time queued, seconds since 1970
+};
+
+/* image telemetry - a JPEG sent as SBD frames of a 14 byte header and up to 326 bytes of image */
+#define IMAGE_HEADER_BYTES 14
+#define IMAGE_PAYLOAD_BYTES 326
+#define IMAGE_MAX_BYTES 65535       // largest JPEG (the header has two bytes for the size)
+#define IMAGE_MAX_FRAMES 202        // frames for the largest JPEG
+#define IMAGE_MAX_ID 99             // image ids run 1-99 and start again
+#define IMAGE_SLOTS 2               // copies of the image state in /IMAGE.bin, written in turn
+#define IMAGE_MAGIC 0x31494C52      // "RLI1" - marks a valid image state slot
+
+/**
+ * the image being sent and which of its frames have gone, kept in /IMAGE.bin
+ * frames are cut from the JPEG on the card when they are sent - only this is written per frame
+ */
+struct ImageState {
+    uint32_t magic;
+    uint16_t size;              // sizeof(ImageState) when it was written
+    uint16_t crc;               // CRC-16 of everything after this field
+    uint32_t seq;               // save counter - the newest slot has the highest
+    char name[20];              // JPEG on the card, e.g. /24060112.jpg
+    uint8_t id;                 // image id carried in every frame, 0 before the first image
+    uint8_t total;              // frames in the image, 0 if there is no image to send
+    uint8_t year;               // capture time, years since 2000
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint16_t lines;             // image resolution, for the frame header
+    uint16_t columns;
+    uint32_t image_bytes;
+    uint8_t sent[(IMAGE_MAX_FRAMES + 7) / 8];      // bit n set once frame n+1 has been sent
+};
+static_assert(offsetof(ImageState, seq) == offsetof(SlotHeader, seq), "ImageState starts like a SlotHeader");
+
+/* write-ahead journal - multi-part writes are copied to /JOURNAL.bin first so begin() can finish them */
+#define JOURNAL_WRITES 4            // most writes in one journal entry
+#define JOURNAL_DATA_BYTES 512      // most bytes in one entry's writes
+#define JOURNAL_MAGIC 0x314A4C52    // "RLJ1" - marks a journal entry
+#define JOURNAL_PENDING 1           // copied to the journal, not every write made yet
+#define JOURNAL_DONE 2              // every write made
+
+/**
+ * header at the start of /JOURNAL.bin, followed by count writes (JournalExtent and its bytes)
+ * the writes go to the journal before the header, and the header before the writes are made in their
+ * own files, so a good checksum means a complete copy - one that begin() can always finish
+ */
+struct JournalHeader {
+    uint32_t magic;
+    uint8_t state;              // JOURNAL_PENDING or JOURNAL_DONE - rewritten on its own once the writes are made
+    uint8_t reserved;
+    uint16_t crc;               // CRC-16 of everything after this field and the writes
+    uint32_t seq;               // entry counter
+    uint16_t size;              // bytes of writes after the header
+    uint8_t count;              // writes in the entry
+    uint8_t reserved2;
+};
+
+/**
+ * one write in a journal entry as stored on the card, followed by len bytes
+ */
+struct JournalExtent {
+    char name[24];              // file to write
+    uint32_t offset;            // where in the file
+    uint16_t len;
+    uint16_t reserved;
+};
+
+/**
+ * one write to make through the journal (journal_writes)
+ */
+struct JournalWrite {
+    const char *name;
+    uint32_t offset;
+    const void *data;
+    uint16_t len;
+};
+
+#define JOURNAL_BYTES (sizeof(JournalHeader) + JOURNAL_WRITES * sizeof(JournalExtent) + JOURNAL_DATA_BYTES)
+
+#define LOG_SINKS 2                 // CSV files buffered in RAM at once (DATA.csv and one more)
+#define LOG_BLOCK 512               // SD card block size - buffered lines are written in whole blocks
+
+/**
+ * lines waiting to be appended to one CSV file (write_to_csv, write_measurement)
+ * written when a block fills, or by flush_logs (called by tpl_done)
+ */
+struct LogSink {
+    char name[24];              // file name, empty if the sink is free
+    uint32_t size;              // file size on the card, so blocks end on the card's block boundaries
+    uint16_t len;               // bytes waiting in buf
+    char buf[LOG_BLOCK];
+};
+
+/* phases of a wake timed for /PROFILE.bin (PhaseTimer) */
+#define PHASE_BEGIN 0               // begin()
+#define PHASE_SD 1                  // CSV writes (write_to_csv, write_measurement, flush_logs)
+#define PHASE_SDI12 2               // SDI-12 sensors (sample_hydros_M, sample_ott, sample_sdi12_bus)
+#define PHASE_ANALITE 3
+#define PHASE_ULTRASONIC 4
+#define PHASE_SHT31 5
+#define PHASE_DS18B20 6
+#define PHASE_JOBS 7                // run_jobs (every sensor at once)
+#define PHASE_PREP 8                // building messages (prep_msg, prep_binary_msg, queue_hourly)
+#define PHASE_MODEM_ON 9            // modem power up and begin
+#define PHASE_MODEM_SEND 10         // SBD sessions
+#define PHASE_USER 11               // free for the sketch
+#define PROFILE_PHASES 12
+
+#define PROFILE_CAPACITY 96         // wakes kept in /PROFILE.bin (a day at one per 15 minutes)
+#define PROFILE_MAGIC 0x31504C52    // "RLP1" - marks a valid profile ring file
+
+#define STACK_PAINT 0xC5C5C5C5      // written over the free RAM by paint_stack, to find how deep the stack went
+#define STACK_PAINT_GUARD 64        // bytes below the stack pointer left alone when painting
+
+/* what sample_memory reports (setMemoryReport) - the memory field of DATA.csv and the messages */
+#define MEM_FREE 0                  // RAM between the heap and the stack (freeMemory)
+#define MEM_LARGEST_BLOCK 1         // largest allocation that would succeed
+#define MEM_STACK_MARGIN 2          // least RAM there has been between the deepest stack and the heap
+
+/**
+ * state of the RAM at one moment (memory_stats)
+ * heap figures need newlib-nano's malloc (SAMD boards), stack figures need paint_stack (done by begin)
+ */
+struct MemoryStats {
+    uint32_t free_bytes;                // between the top of the heap and the stack
+    uint32_t heap_free;                 // in freed blocks inside the heap
+    uint32_t largest_block;             // largest allocation that would succeed, the gap above the heap included
+    uint32_t free_fragments;            // freed blocks inside the heap - many small ones is fragmentation
+    uint32_t allocs;                    // malloc/realloc calls since begin (build with RL_COUNT_ALLOCS)
+    uint32_t stack_used;                // deepest the stack has been since paint_stack, in bytes
+    uint32_t stack_margin;              // least room there has been between the stack and the heap
+};
+
+/**
+ * where the time went in one wake, as kept in /PROFILE.bin
+ */
+struct ProfileRecord {
+    uint32_t timestamp;                 // seconds since 1970, at the end of the wake
+    uint32_t awake_ms;                  // power up to tpl_done
+    uint32_t phase_us[PROFILE_PHASES];  // time in each phase (a phase inside another counts in both)
+    uint16_t batt_mv;                   // battery at the end of the wake
+    uint16_t modem_before_mv;           // battery before the modem was powered up, 0 if it wasn't
+    uint16_t modem_after_mv;            // battery with the modem still on, at the end of the session
+    uint16_t free_fragments;            // memory at the end of the wake (see MemoryStats)
+    uint32_t largest_block;
+    uint32_t stack_used;
+    uint32_t stack_margin;
+    uint16_t allocs;
+    uint16_t reserved;
+};
+
+/**
+ * header at the start of /PROFILE.bin, head is the next slot to write
+ */
+struct ProfileHeader {
+    uint32_t magic;
+    uint16_t record_size;
+    uint16_t capacity;
+    uint16_t head;
+    uint16_t count;
+};
+
+/* analog bursts (read_adc) - 12 bit results, each the hardware average of ADC_AVERAGE conversions */
+#define ADC_BURST 10                // results in a burst unless asked for another number
+#define ADC_MAX_BURST 16            // most results in one burst
+#define ADC_AVERAGE 8               // conversions the SAMD21 accumulates into each result (AVGCTRL)
+#define ADC_DMA_CHANNEL 0           // DMA channel used for bursts when no other library has the DMA controller
+#define ADC_TIMEOUT_US 5000         // longest a burst can take before it is abandoned
+
+#define NO_READING -9               // value written for a parameter the sensor didn't return
+#define RECORD_CHARS 256            // longest formatted DATA.csv line (timestamp + all parameters)
+
+/* status codes returned by the sampling functions that fill a Measurement */
+#define SAMPLE_OK 0
+#define SAMPLE_NO_RESPONSE 1        // sensor did not answer
+#define SAMPLE_BAD_RESPONSE 2       // sensor answered but returned fewer values than expected
+#define SAMPLE_FULL 3               // more values than MAX_PARAMS - extra values dropped
+
+/**
+ * one sample of every parameter, filled in place by the sampling functions
+ * start with start_measurement, then each sampling function adds its values in the order called
+ */
+struct Measurement {
+    float batt_v;
+    float memory;
+    float values[MAX_PARAMS];
+    byte count;                 // values added so far
+    byte status;                // first status other than SAMPLE_OK from any sampling function
+};
+
+/**
+ * one sampled parameter of a compile-time schema (RemoteLogger(columns)), made with sent_column or logged_column
+ * declare the array constexpr so it stays in flash: the header, letters and multipliers then take no RAM
+ */
+struct Column {
+    const char *name;           // CSV header for the parameter
+    char letter;                // message letter, '\0' if the parameter isn't sent
+    float multiplier;           // scale before sending, 0 if the parameter isn't sent
+};
+
+/** parameter written to the CSV files and sent in messages */
+constexpr Column sent_column(const char *name, char letter, float multiplier){
+    return Column{name, letter, multiplier};
+}
+
+/** parameter written to the CSV files only */
+constexpr Column logged_column(const char *name){
+    return Column{name, '\0', 0};
+}
+
+/** helper to columns_valid - characters in a column name */
+constexpr int column_chars(const char *name){
+    return *name ? 1 + column_chars(name + 1) : 0;
+}
+
+/** helper to columns_valid - true if no column in c[0..n-1] is sent with letter */
+constexpr bool letter_unused(const Column *c, int n, char letter){
+    return n == 0 || (c[0].letter != letter && letter_unused(c + 1, n - 1, letter));
+}
+
+/** helper to columns_valid - true if c[0..n-1] are sent with a unique letter and a multiplier, or not sent at all */
+constexpr bool columns_sendable(const Column *c, int n){
+    return n == 0 || ((c[0].letter == '\0' ? c[0].multiplier == 0 :
+        c[0].letter > ' ' && c[0].letter != ':' && c[0].letter != ',' && c[0].multiplier != 0 &&
+        letter_unused(c + 1, n - 1, c[0].letter)) && columns_sendable(c + 1, n - 1));
+}
+
+/** helper to columns_valid - length of the CSV header after "datetime,batt_v,memory" */
+constexpr int columns_header_chars(const Column *c, int n){
+    return n == 0 ? 0 : 1 + column_chars(c[0].name) + columns_header_chars(c + 1, n - 1);
+}
+
+/**
+ * true if columns make a schema the logger can store and send, for a static_assert in the sketch
+ * e.g. static_assert(columns_valid(columns), "bad schema");
+*/
+template <size_t N> constexpr bool columns_valid(const Column (&columns)[N]){
+    return N >= 1 && N <= MAX_PARAMS && columns_sendable(columns, N) &&
+        22 + columns_header_chars(columns, N) < RECORD_CHARS;
+}
+
+#define SDI12_MAX_SENSORS 8         // measurements that can be registered on the SDI-12 bus
+#define SDI12_REPLY_MS 50           // time for a sensor to start answering a command (spec is 15 ms after the command)
+#define SDI12_CHAR_MS 20            // longest gap between characters once a reply has started (1 char ~ 8.3 ms)
+
+/* progress of one registered SDI-12 measurement through sample_sdi12_bus */
+#define SDI12_WAITING 0
+#define SDI12_MEASURING 1
+#define SDI12_DONE 2
+
+/**
+ * one measurement registered on the SDI-12 bus with add_sdi12_sensor
+ */
+struct SDI12Entry {
+    char address;
+    char command[3];            // measurement command without address, e.g. "C", "C1", "M", "V"
+    byte num_values;            // values expected back
+    byte offset;                // position of the first value in the Measurement
+    byte found;                 // values collected so far
+    byte state;
+    byte status;
+    unsigned long ready_ms;     // millis() when the sensor said its data would be ready
+};
+
+/* SDI-12 bus discovery (find_sdi12_bus) */
+#define SDI12_MAX_DEVICES 8         // sensors kept in /SDI12.bin
+#define SDI12_BUS_SLOTS 2           // copies of the bus in /SDI12.bin - the newest good one is used
+#define SDI12_BUS_MAGIC 0x31424C52  // "RLB1" - marks a valid bus in /SDI12.bin
+#define SDI12_ID_CHARS 20           // aI! reply kept: SDI-12 version, vendor, model and sensor version
+
+/**
+ * one sensor found on the SDI-12 bus, with the driver picked from its identity
+ */
+struct SDI12Device {
+    char address;
+    uint8_t driver;                     // SDI12_GENERIC, SDI12_HYDROS21...
+    uint8_t num_values;                 // values of a generic sensor's measurement
+    uint8_t reserved;
+    char identity[SDI12_ID_CHARS];      // e.g. "13METER   HYD21 400"
+};
+
+/**
+ * every sensor on the SDI-12 bus, found once by find_sdi12_bus and kept in /SDI12.bin
+ */
+struct SDI12BusMap {
+    uint32_t magic;
+    uint16_t size;
+    uint16_t crc;                       // CRC-16 of everything after this field
+    uint32_t seq;                       // save counter - newest slot has the highest
+    uint8_t count;
+    uint8_t reserved[3];
+    SDI12Device devices[SDI12_MAX_DEVICES];
+};
+static_assert(offsetof(SDI12BusMap, seq) == offsetof(SlotHeader, seq), "SDI12BusMap starts like a SlotHeader");
+
+/* drivers find_sdi12_bus picks from a sensor's identity */
+#define SDI12_GENERIC 0             // one concurrent measurement, as many values as the sensor says
+#define SDI12_GENERIC_M 1           // the same with M, for a sensor that can't do C
+#define SDI12_HYDROS21 2            // METER HYDROS 21: C - level, temperature, EC
+#define SDI12_OTT_PLS 3             // OTT PLS: C - level, temperature, status, then V - RH, dew, deg
+
+/* DS18B20 chains (find_DS18B20_chain, sample_DS18B20_chain) */
+#define DS18B20_MAX_PROBES 8        // probes on one chain
+#define PROBE_SLOTS 2               // copies of the chain in /DS18B20.bin - the newest good one is used
+#define PROBE_MAGIC 0x31444C52      // "RLD1" - marks a valid chain in /DS18B20.bin
+
+/**
+ * ROM addresses and resolutions of the probes on a DS18B20 chain, found once and kept in /DS18B20.bin
+ * probes stay in the order they were found, so each keeps its column if another stops answering
+ */
+struct ProbeChain {
+    uint32_t magic;
+    uint16_t size;
+    uint16_t crc;                       // CRC-16 of everything after this field
+    uint32_t seq;                       // save counter - newest slot has the highest
+    uint8_t count;
+    uint8_t reserved[3];
+    uint8_t bits[DS18B20_MAX_PROBES];   // resolution of each probe, 9-12 bits
+    uint8_t rom[DS18B20_MAX_PROBES][8];
+};
+static_assert(offsetof(ProbeChain, seq) == offsetof(SlotHeader, seq), "ProbeChain starts like a SlotHeader");
+
+/* ultrasonic ranging (setUltrasonic) */
+#define ULTRASONIC_MAX_BURST 10     // most pulses timed per sample
+#define ULTRASONIC_PERIOD_MS 150    // MB7369 free-runs at ~6.7 Hz with the trigger held high
+#define RANGE_MIN 0                 // shortest pulse - nearest target (the default)
+#define RANGE_MEDIAN 1
+#define RANGE_TRIMMED_MIN 2         // shortest after dropping the lowest fifth as stray echoes
+
+#define MAX_JOBS 8                  // sensors that can be added to the sampling schedule
+#define SDI12_POLL_MS 10            // how often the scheduler checks for an SDI-12 service request
+#define MAX_TASKS 8                 // periodic tasks besides the scheduled sensors (add_task)
+
+static_assert(MAX_JOBS + MAX_TASKS <= TASK_SLOTS, "every scheduled sensor and task needs a slot in LoggerState");
+
+/* kinds of sensor in the sampling schedule */
+#define JOB_ULTRASONIC 1
+#define JOB_ANALITE 2
+#define JOB_SDI12 3
+#define JOB_SHT31 4
+#define JOB_DS18B20 5
+#define JOB_DS18B20_CHAIN 6
+
+#define JOB_DONE 255                // step of a job that has finished
+
+/**
+ * one sensor in the sampling schedule, run a step at a time by run_jobs
+ */
+struct SampleJob {
+    byte type;
+    byte step;                  // where the sensor is in its sequence (power on, settle, trigger, collect...)
+    byte num_values;
+    byte offset;                // position of the first value in the Measurement
+    byte status;
+    byte count;                 // samples taken so far in this step
+    bool listening;             // waiting for the sensor to talk - no standby
+    int pins[3];
+    int address;                // sensor address or index
+    void *device;               // SDI12, Adafruit_SHT31 or DallasTemperature object
+    unsigned long wake_ms;      // millis() when the job next needs to run
+    float samples[10];          // raw samples before taking the median/minimum
+};
+
+class RemoteLogger;
+
+/**
+ * times the enclosing block and adds it to a phase of the wake's profile
+ * e.g. { PhaseTimer timer(logger, PHASE_USER); ... }
+ */
+class PhaseTimer
+{
+    public:
+        PhaseTimer(RemoteLogger &logger, byte phase);
+        ~PhaseTimer();
+    private:
+        RemoteLogger &myLogger;
+        byte myPhase;
+        unsigned long startUs;
+};
+
 class RemoteLogger
 {
     public:
@@ -34,6 +607,11 @@ class RemoteLogger
         RemoteLogger();
         RemoteLogger(String header);
         RemoteLogger(String header, byte num_params, float *multipliers, String letters);
+        template <size_t N> RemoteLogger(const Column (&columns)[N]){
+            static_assert(N >= 1 && N <= MAX_PARAMS, "a schema has 1 to MAX_PARAMS columns");
+            mySchema = columns;
+            myParams = N;
+        }
         void begin();      // call after changing any pins you want to change
 
         /* BASIC UNIT FUNCTIONS */
@@ -41,31 +619,176 @@ class RemoteLogger
         void write_to_csv(String header, String datastring_for_csv, String outname);
         float sample_batt_v();
         int sample_memory();
-        void tpl_done();
+        uint16_t read_adc(int pin, int samples = ADC_BURST);      // median of a burst, 0-4095
+        int adc_burst(int pin, uint16_t *out, int n);
+        void tpl_done();                    // also flushes the buffered CSV lines
+        void flush_logs();                  // write every buffered CSV line to the card
         void wipe_files();      // wipe tracking, hourly, and data files from SD card
 
+        /* LOW POWER */
+        void idle_wait(unsigned long ms);       // delay() in low power
+        unsigned long now_ms();                 // millis() including time spent in standby
+        void setStandbyThreshold(unsigned long ms);     // waits this long or longer use standby (0 = never)
+
+        /* PROFILING - where the time goes in each wake */
+        void setProfiling(bool on, bool in_msg = false);       // keep /PROFILE.bin, add a summary to text messages
+        void add_phase_time(byte phase, unsigned long us);      // used by PhaseTimer
+        unsigned long now_us();             // micros() including time spent in standby
+        int num_profiles();
+        bool read_profile(int index, ProfileRecord *record);   // index 0 is the oldest wake kept
+        void memory_stats(MemoryStats *stats);      // heap fragmentation and stack depth, cheap enough for every wake
+        void paint_stack();                 // start measuring stack depth from here - begin does this
+        void setMemoryReport(byte what);    // MEM_FREE (default) etc. for sample_memory
+
         /* TRACKING */
         void increment_samples();
+        void increment_samples(Measurement *msmt);      // also adds the sample to the hourly statistics
         int num_samples();
         int num_hours();
-        void reset_sample_counter();        // wipe tracker file
-        void reset_hourly();                // wipe hourly file
+        void reset_sample_counter();        // set samples since hourly back to zero
+        void reset_hourly();                // empty the hourly store
+        int num_hours_since_send();         // hourly samples written since the last successful send
+        int num_failed_sends();             // send attempts failed in a row
+        void reset_failed_sends();
+
+        /* HOURLY STORE */
+        void write_hourly(DateTime time, String sample);       // sample is "batt_v,memory,param1,..." as for DATA.csv
+        void write_hourly(DateTime time, Measurement *msmt);
+        bool read_hourly(int index, HourlyRecord *record);     // index 0 is the oldest waiting record
+        void setAggregates(const byte *aggregates);     // STAT_MEAN etc. per parameter, for write_hourly(Measurement)
+
+        /* ARCHIVE - every measurement in daily binary segments, read back by time */
+        void write_archive(DateTime time, Measurement *msmt);
+        int read_archive(uint32_t from, uint32_t to, HourlyRecord *records, int max, uint32_t *next = NULL);
+        int num_archive_days();
+
+        /* ADAPTIVE SAMPLING - more hourly rows during events, fewer at base flow */
+        byte adaptive_sample(DateTime time, Measurement *msmt);        // call every wake, returns ADAPT_SKIP etc.
+        bool in_event();
+        void setAdaptive(int param, float rate_per_h, float level = NAN);     // param -1 turns it off
+        void setBaseHours(int hours);       // hours between hourly rows when the parameter is flat
 
         /* TELEMETRY */
         int send_msg(String myMsg);    // send message over Iridium
         void irid_test(String msg);               // test Iridium modem (sends message)
         String prep_msg();
         String low_pwr_prep_msg();              // prep message with just the most recent hourly sample
+        int prep_binary_msg(uint8_t *buf, int len);     // compact binary message, returns bytes written
+        int send_binary_msg(const uint8_t *msg, int len);
+
+        /* MODEM SESSION - several messages per modem power-up, picking up messages sent to the logger */
+        int begin_session();                // power up the modem, returns the error from modem.begin()
+        int session_send(const char *text);
+        int session_send(const uint8_t *data, int len);
+        int session_receive();              // pick up waiting messages, returns number received
+        void end_session();                 // sync the clock, put the modem to sleep, update the send counters
+        void warm_modem();                  // power up the modem now, so it finds the network while the sensors sample
+        void sleep_modem();                 // put a warmed modem back to sleep without a session
+        void setModemCallback(bool (*callback)());      // called while the modem waits, false cancels
+
+        /* REMOTE CONFIGURATION - PARAM.txt on the SD card, updated by messages sent to the logger */
+        bool apply_params(const char *text);        // "sample_freq_m,irid_freq_h\n15,6" - saved to PARAM.txt
+        int sample_freq_m();                // minutes between samples
+        int irid_freq_h();                  // hours between sends (same as min_rows in setSendBatch)
+
+        /* TRANSMISSION SCHEDULER */
+        byte plan_send();                   // decide whether to send this wake (SEND_NOW etc.)
+        int auto_send();                    // plan_send and act on it, returns messages sent
+        int num_last_signal();              // signal quality at the last modem session, -1 if not known
+        void setSendBattery(float low_v, float critical_v);
+        void setSendBatch(int min_rows, int max_frames);
+        void setMaxBackoff(int hours);
+
+        /* OUTBOX - messages kept on the SD card until they are sent */
+        int queue_hourly(bool binary = false);          // split the hourly store into messages, returns number queued
+        int send_outbox(int max_frames = OUTBOX_SLOTS, bool newest_first = false);     // returns number sent
+        int num_outbox();
+        void clear_outbox();
+
+        /* TRANSPORTS - the outbox goes over the cheapest link that is up, Iridium as the fallback */
+        bool add_transport(Transport &link);
+        void setLatencyCost(float per_hour);        // what an hour's delay is worth against the link costs
+        int frame_bytes();                  // largest message every link can take - outbox messages are cut to it
+        const char *last_transport();       // link the last outbox session went over, "" if none
+
+        /* IMAGE TELEMETRY - a JPEG saved once, sent as frames over as many sessions as it takes */
+        bool begin_image(DateTime time, uint16_t lines, uint16_t columns);      // start saving a JPEG
+        bool add_image_bytes(const uint8_t *data, int len);
+        int end_image();                    // returns frames to send, 0 if the image can't be sent
+        int send_image(int max_frames = IMAGE_MAX_FRAMES);      // returns number sent
+        int num_image_frames();             // frames of the image still to send
+        void clear_image();
 
         /* SAMPLING FUNCTIONS */
-        String sample_hydros_M(SDI12 bus, int sensor_address);
-        // String sample_ott_M(SDI12 bus, int sensor_address);
-        // String sample_ott_V(SDI12 bus, int sensor_address);
-        String sample_ott(SDI12 bus, int sensor_address);     // could make two constituent functions private
+        String sample_hydros_M(SDI12 &bus, int sensor_address);
+        // String sample_ott_M(SDI12 &bus, int sensor_address);
+        // String sample_ott_V(SDI12 &bus, int sensor_address);
+        String sample_ott(SDI12 &bus, int sensor_address);     // could make two constituent functions private
         String sample_analite_195(int analogDataPin, int wiperSetPin, int wiperUnsetPin);
         String sample_ultrasonic(int powerPin, int triggerPin, int pulseInputPin);
+        void setUltrasonic(int burst, byte filter = RANGE_MIN);        // pulses per sample and how they are combined
+#ifndef RL_NO_SHT31
         String sample_sht31(Adafruit_SHT31 sensor, int sensorAddress);
-        String sample_DS18B20(DallasTemperature sensors, int sensorIndex);
+#endif
+#ifndef RL_NO_DS18B20
+        String sample_DS18B20(DallasTemperature &sensors, int sensorIndex);
+#endif
+
+        /* MEASUREMENTS - sampling without String */
+        void start_measurement(Measurement *msmt);        // sample battery and memory, clear values
+        byte sample_hydros_M(SDI12 &bus, int sensor_address, Measurement *msmt);
+        byte sample_ott(SDI12 &bus, int sensor_address, Measurement *msmt);
+        byte sample_analite_195(int analogDataPin, int wiperSetPin, int wiperUnsetPin, Measurement *msmt);
+        byte sample_ultrasonic(int powerPin, int triggerPin, int pulseInputPin, Measurement *msmt);
+#ifndef RL_NO_SHT31
+        byte sample_sht31(Adafruit_SHT31 &sensor, int sensorAddress, Measurement *msmt);
+#endif
+#ifndef RL_NO_DS18B20
+        byte sample_DS18B20(DallasTemperature &sensors, int sensorIndex, Measurement *msmt);
+#endif
+        byte add_value(Measurement *msmt, float value);       // for sensors without a library sampling function
+        const char *format_measurement(DateTime time, Measurement *msmt);     // CSV line in a static buffer
+        void write_measurement(DateTime time, Measurement *msmt, const char *outname);
+
+        /* SDI-12 BUS - concurrent measurement of every registered sensor */
+        bool add_sdi12_sensor(int sensor_address, byte num_values, const char *command = "C");
+        void clear_sdi12_sensors();
+        byte sample_sdi12_bus(SDI12 &bus, Measurement *msmt);
+        int find_sdi12_bus(SDI12 &bus, bool search = false);      // register every sensor on the bus, returns how many
+        const char *sdi12_identity(int device);     // aI! reply of a sensor found, "" if there is no such sensor
+        bool change_sdi12_address(SDI12 &bus, int from_address, int to_address);
+
+#ifndef RL_NO_DS18B20
+        /* DS18B20 CHAIN - every probe on a OneWire bus from one conversion */
+        int find_DS18B20_chain(DallasTemperature &sensors, bool search = false);      // returns the number of probes
+        bool setDS18B20Resolution(DallasTemperature &sensors, int probe, byte bits);  // probe -1 for all of them
+        int sample_DS18B20_chain(DallasTemperature &sensors, float *temps, int max);  // returns probes that answered
+        byte sample_DS18B20_chain(DallasTemperature &sensors, Measurement *msmt);
+#endif
+
+        /* SAMPLING SCHEDULER - sample every sensor at the same time */
+        bool add_ultrasonic_job(int powerPin, int triggerPin, int pulseInputPin);
+        bool add_analite_job(int analogDataPin, int wiperSetPin, int wiperUnsetPin);
+        bool add_sdi12_job(SDI12 &bus);         // every sensor registered with add_sdi12_sensor
+#ifndef RL_NO_SHT31
+        bool add_sht31_job(Adafruit_SHT31 &sensor, int sensorAddress);
+#endif
+#ifndef RL_NO_DS18B20
+        bool add_DS18B20_job(DallasTemperature &sensors, int sensorIndex);
+        bool add_DS18B20_chain_job(DallasTemperature &sensors);     // every probe found by find_DS18B20_chain
+#endif
+        void clear_jobs();
+        byte run_jobs(Measurement *msmt);
+
+        /* TASK SCHEDULER - each sensor and task on its own period, woken by the RTC */
+        bool setJobPeriod(int job, unsigned long period_s, unsigned long phase_s = 0);    // job: order it was added, from 0
+        int add_task(unsigned long period_s, unsigned long phase_s = 0);        // returns the task, -1 if full
+        bool task_due(int task);            // true once in each period
+        void clear_tasks();
+        void setWipePeriod(unsigned long period_s, unsigned long phase_s = 0);    // Analite wipe, 0 = every 4th sample
+        long secs_to_next_task();           // 0 if something is due, -1 if nothing has a period
+        bool arm_wake_timer();              // PCF8523 countdown to the next task, before tpl_done
+        void wait_for_next_task();          // standby until the next task, for sketches that stay powered
 
         /* PIN ASSIGNMENT SETTERS */
         void setLedPin(byte pin);
@@ -76,27 +799,219 @@ class RemoteLogger
         //void setDataPin(byte pin);
 
         RTC_PCF8523 rtc;
+        IridiumTransport iridium{*this};    // the RockBLOCK as a transport - set its costs here
     
     private:
+        friend class IridiumTransport;
+        friend bool ISBDCallback();
 
         void sync_clock();      // sync RTC to Iridium time - helper to send_msg and test_irid
+        bool sd_ready();                    // start the SD card once per power cycle
+        void write_profile();               // add this wake to /PROFILE.bin - helper to tpl_done
+        bool load_profile_header(File &file, ProfileHeader *header);
+        int profile_summary(char *out);     // "P..." field for text messages
+        void append_log(const char *outname, const char *header, const char *line);    // helper to write_to_csv, write_measurement
+        void write_log_block(LogSink *sink, int len);
+        bool load_hourly();                 // read or create the ring file header - helper to hourly store
+        bool create_hourly();               // preallocate an empty ring file
+        void save_hourly_header();
+        uint16_t hourly_record_size();
+        void open_hourly();                 // keep /HOURLY.bin open for the reads of one message build
+        void close_hourly();
+        int format_msg_value(char *out, float value, float multiplier);    // helper to message prep
+        long scale_msg_value(float value, float multiplier);
+        int modem_send(const char *text, const uint8_t *data, int len);      // helper to send_msg, send_binary_msg
+        int modem_start();              // helpers to modem sessions
+        void modem_warm_step(SampleJob *list, int n, Measurement *msmt);     // helpers to warm_modem
+        unsigned long modem_due_ms();
+        bool modem_warm_due();
+        bool modem_callback();
+        void step_due_jobs(SampleJob *list, int n, Measurement *msmt);
+        void modem_stop(int err);
+        void modem_off(int err);
+        void count_session(int err);    // update the send counters after a session on any link
+        void note_signal();             // record the modem's signal quality for the scheduler
+        void session_result(int err, uint8_t *rx, size_t rx_len);       // helper to session_send, session_receive
+        bool parse_params(const char *text);        // update settings from PARAM.txt style text
+        void read_params();
+        void write_params();
+        int build_text_msg(int first, int rows);        // helpers to message prep and the outbox
+        int text_fixed_size(HourlyRecord *record);
+        float param_multiplier(int i);          // helpers to the schema (constructor arguments or columns)
+        int param_letters(char *out);
+        int schema_header(char *out, int size);
+        int text_rows_fit(int len);
+        int build_binary_msg(uint8_t *buf, int len, int *rows);
+        int binary_fixed_size(HourlyRecord *record);
+        void drop_hourly(int n);
+        bool load_outbox();             // helpers to the outbox
+        bool add_frame(const uint8_t *data, int len, bool binary, int drop = 0);
+        int rank_transports(int frames, int bytes, byte *order, bool *loaded);      // helpers to the transports
+        int send_frames(Transport *link, int max_frames, bool newest_first, int *err);
+        int link_send(Transport *link, const uint8_t *data, int len, bool binary);
+        int link_receive(Transport *link);
+        int next_frame(bool newest_first, OutboxSlot *slot);
+        bool read_slot(int index, OutboxSlot *slot);
+        bool read_frame(int index, OutboxSlot *slot, uint8_t *data);
+        void set_frame_state(int index, uint8_t state);
+        bool load_image();              // helpers to image telemetry
+        void save_image();
+        int image_frame(int seq, uint8_t *buf);
+        int send_image_frames(Transport *link, int max_frames, int *err);
+        uint32_t outbox_offset(int index);
+        uint16_t binary_schema_id();            // helpers to prep_binary_msg
+        int put_varint(uint8_t *out, long value);
+        int binary_row(uint8_t *out, HourlyRecord *record, HourlyRecord *prev);
+        int sent_values(HourlyRecord *record, long *out);
         //int count_params();            // count parameters in comma-separated header - helper to prep_msg
-        String produce_csv_setting();          // generate argument for CSV parsing - helper to prep_msg
+        bool load_state();                  // read the newest counter slot - helper to tracking
+        void save_state();                  // write counters to the next slot
+        bool journal_writes(const JournalWrite *writes, int n);     // write-ahead journal
+        void recover_journal();
+        bool copy_journal(File &journal, JournalHeader *header, bool apply);
+        uint16_t crc16(const uint8_t *data, uint32_t len, uint16_t crc = 0xFFFF);
+        bool load_slots(const char *path, void *buf, uint16_t size, uint32_t magic, int slots);     // helpers to the slot files
+        void save_slots(const char *path, void *buf, uint16_t size, int slots);
+        void low_power_wait(unsigned long ms, bool standby_ok);        // helper to idle_wait
+        bool slot_due(int slot, uint32_t now, bool take);         // helper to the task scheduler
+        void append_hourly(HourlyRecord *record);          // helper to write_hourly
+        void archive_path(uint32_t day, char *out);         // helpers to the archive
+        void add_archive_day(uint32_t day, uint16_t record_size);
+        int read_archive_day(ArchiveEntry *entry, uint32_t from, uint32_t to, HourlyRecord *records, int max);
+        void wipe_archive();
+        void add_to_stats(Measurement *msmt);               // helper to increment_samples, adaptive_sample
+        float stat_value(int param, Measurement *msmt);     // value of the chosen aggregate - helper to write_hourly
+        int sdi12_transaction(SDI12 &bus, const char *command, char *response, int len);      // helpers to SDI-12 sampling
+        int sdi12_read_line(SDI12 &bus, char *line, int len);
+        int parse_sdi12_values(const char *response, float *values, int max_values);
+        byte sdi12_measure(SDI12 &bus, int sensor_address, char command, int expected, Measurement *msmt);
+        byte add_no_reading(Measurement *msmt, int n, byte status);
+        String values_to_string(Measurement *msmt);          // helper to String sampling functions
+        byte run_job_list(SampleJob *list, int n, Measurement *msmt, uint16_t skip = 0);        // helpers to the sampling scheduler
+        void step_job(SampleJob *job, Measurement *msmt);
+        void set_job_value(SampleJob *job, Measurement *msmt, int index, float value);
+        void set_ultrasonic_job(SampleJob *job, int powerPin, int triggerPin, int pulseInputPin);
+        void set_analite_job(SampleJob *job, int analogDataPin, int wiperSetPin, int wiperUnsetPin);
+        void set_sdi12_job(SampleJob *job, SDI12 &bus);
+#ifndef RL_NO_SHT31
+        void set_sht31_job(SampleJob *job, Adafruit_SHT31 &sensor, int sensorAddress);
+#endif
+#ifndef RL_NO_DS18B20
+        void set_DS18B20_job(SampleJob *job, DallasTemperature &sensors, int sensorIndex);
+        void set_DS18B20_chain_job(SampleJob *job, DallasTemperature &sensors);
+#endif
+        void step_ultrasonic(SampleJob *job, Measurement *msmt);
+        void finish_ultrasonic(SampleJob *job, Measurement *msmt, int n);
+        void step_analite(SampleJob *job, Measurement *msmt);
+        void step_sdi12(SampleJob *job, Measurement *msmt);
+#ifndef RL_NO_SHT31
+        void step_sht31(SampleJob *job, Measurement *msmt);
+#endif
+#ifndef RL_NO_DS18B20
+        void step_DS18B20(SampleJob *job, Measurement *msmt);
+        void step_DS18B20_chain(SampleJob *job, Measurement *msmt);
+        bool load_probe_chain();            // helpers to the DS18B20 chain
+        void save_probe_chain();
+#endif
+        void sdi12_start(SDI12 &bus, SDI12Entry *entry, byte base);          // helpers to sample_sdi12_bus
+        bool sdi12_data_ready(SDI12 &bus, SDI12Entry *entry);
+        byte sdi12_reset_entries();
+        void sdi12_collect(SDI12 &bus, SDI12Entry *entry, Measurement *msmt);
+        bool sdi12_address_busy(char address);
+        bool sdi12_identify(SDI12 &bus, char address, SDI12Device *device);     // helpers to find_sdi12_bus
+        void register_sdi12_devices();
+        bool load_sdi12_map();
+        void save_sdi12_map();
+        int format_float(char *out, float value, byte decimals);       // helper to format_measurement
+        uint16_t median_u16(uint16_t *values, int n);       // helper to read_adc
         // void populate_header_index(int **headerIndex, int num_params);             // determine where each header lives in dictionary - helper to prep_msg
         // int find_key(String *key);                   // find index of column name in dictionary
-        String sample_ott_M(SDI12 bus, int sensor_address);
-        String sample_ott_V(SDI12 bus, int sensor_address);
+        String sample_ott_M(SDI12 &bus, int sensor_address);
+        String sample_ott_V(SDI12 &bus, int sensor_address);
 
         String myHeader;
-        float *myMultipliers;
+        float *myMultipliers = NULL;
         byte myParams;
         String myLetters;
+        const Column *mySchema = NULL;          // compile-time schema in flash, NULL when the Strings above are used
+        const byte *myAggregates = NULL;        // STAT_* per parameter, NULL for the sample itself
 
-        String myCommand;
-        String sdiResponse;
         File dataFile;
         QuickStats stats;       
 
+        LoggerState state;
+        bool stateLoaded = false;
+        HourlyHeader hourlyHeader;
+        bool hourlyLoaded = false;
+        File hourlyFile;                    // open while a message is built (open_hourly), read by read_hourly
+        uint32_t journalSeq = 0;            // seq of the last journal entry (read by recover_journal)
+        bool journalPending = false;        // the last entry's writes aren't all made - replay before the next
+        OutboxHeader outboxHeader;
+        uint8_t outboxState[OUTBOX_SLOTS];      // each slot's state and seq, read with the header (load_outbox)
+        uint16_t outboxSeq[OUTBOX_SLOTS];
+        int sessionSignal = -1;             // signal quality seen in the current modem session
+        int sessionErr = ISBD_NO_NETWORK;   // ISBD_SUCCESS once anything in the session got through
+        byte modemWarm = MODEM_OFF;         // warm_modem state
+        unsigned long modemWarmMs = 0;      // when warm_modem powered the modem up
+        unsigned long modemPollMs = 0;      // when the warm modem was last asked for its signal
+        SampleJob *callbackJobs = NULL;     // jobs stepped from ISBDCallback while a warm modem talks
+        int callbackCount = 0;
+        Measurement *callbackMsmt = NULL;
+        bool (*modemCallback)() = NULL;     // the sketch's own callback (setModemCallback)
+        int sampleFreqM = 15;               // remote configuration (PARAM.txt)
+
+        int adaptParam = -1;                // adaptive sampling settings, -1 = off
+        float adaptRate = 0;
+        float adaptLevel = NAN;
+        int baseHours = 1;
+
+        int ultrasonicBurst = 10;           // ultrasonic ranging settings
+        byte ultrasonicFilter = RANGE_MIN;
+
+        float lowBattV = 3.6;               // transmission scheduler settings
+        float criticalBattV = 3.4;
+        int minSendRows = 4;
+        int maxSendFrames = 8;
+        int maxBackoffHours = 24;
+        Transport *links[MAX_TRANSPORTS] = {&iridium};
+        byte numLinks = 1;
+        float latencyCost = 1;              // cost of an hour's delay (setLatencyCost)
+        const char *lastLink = "";
+        bool outboxLoaded = false;
+        ImageState image;
+        bool imageLoaded = false;
+        File imageFile;                     // JPEG being saved (begin_image .. end_image)
+        char imageName[20] = "";
+        DateTime imageTime;
+        uint16_t imageLines = 0;
+        uint16_t imageColumns = 0;
+        uint32_t imageBytes = 0;
+        char msgBuf[341];           // message being prepared (SBD limit is 340 bytes)
+        char recordBuf[RECORD_CHARS];       // line being formatted for DATA.csv
+        LogSink logSinks[LOG_SINKS] = {};   // CSV lines waiting to be written
+        ProfileRecord profile = {};         // this wake so far
+        bool profiling = false;
+        bool profileInMsg = false;
+        bool sdStarted = false;
+        SDI12Entry sdi12Sensors[SDI12_MAX_SENSORS];
+        byte numSdi12Sensors = 0;
+        SDI12BusMap sdi12Map = {};          // SDI-12 sensors, from /SDI12.bin or find_sdi12_bus
+        bool sdi12MapLoaded = false;
+#ifndef RL_NO_DS18B20
+        ProbeChain probes = {};             // DS18B20 chain, from /DS18B20.bin or find_DS18B20_chain
+        bool probesLoaded = false;
+#endif
+        SampleJob jobs[MAX_JOBS];
+        byte numJobs = 0;
+        unsigned long taskPeriod[TASK_SLOTS] = {};      // scheduled sensors first (MAX_JOBS), then tasks; 0 = every wake
+        unsigned long taskPhase[TASK_SLOTS] = {};
+        byte numTasks = 0;
+        int wipeTask = -1;                  // task for the Analite wipe (setWipePeriod)
+        byte memoryReport = MEM_FREE;
+        uint32_t *stackPaintStart = NULL;   // lowest painted word (paint_stack)
+        unsigned long sleptMs = 0;          // time spent in standby, when millis() doesn't count
+        unsigned long standbyThreshold = 0;
+
         // IridiumSBD modem{IridiumSerial};
 
         byte ledPin = 8;        // built-in green LED pin on Feather M0 Adalogger - can modify for other boards
@@ -0,0 +1,512 @@
+/**
+ * encoder and decoder for RemoteLogger messages, shared by the library and the tools that receive them
+ * header only and plain C++11 (no Arduino or heap), so the same code builds on the logger and on a desktop
+ *
+ * text:   <letters>:<YYMMDDHH>:<batt x100>:<memory x0.01>:<row>:<row>:...[P<profile>:]
+ *         each row is the sent values (value * multiplier, rounded) separated by commas, an hour apart
+ * binary: see prep_binary_msg in RemoteLogger.cpp - header, battery and memory, then rows as changes
+ *
+ * both are built from a Schema: the letters of the sent parameters and every parameter's multiplier
+ * (0 = not sent), the same as the RemoteLogger constructor arguments
+*/
+
+#ifndef RemoteLoggerCodec_h
+#define RemoteLoggerCodec_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define BINARY_MSG_VERSION 0xB1     // first byte of a binary message from prep_binary_msg
+#define BINARY_HEADER_BYTES 8       // version, schema id, first timestamp, row count
+#define BINARY_MAX_ROWS 255         // rows in one binary message (one byte count)
+#define CODEC_MAX_VALUES 16         // sent values per row the decoder keeps (MAX_PARAMS on the logger)
+#define CODEC_MAX_SCHEMAS 32        // schemas one decode_dump call can tell apart
+
+namespace rl_codec {
+
+/**
+ * what a logger sends: letters of the sent parameters, in order, and the multiplier of every parameter
+*/
+struct Schema {
+    const char *letters;
+    int num_params;
+    const float *multipliers;       // num_params of them, 0 for a parameter that isn't sent
+};
+
+/**
+ * one decoded row - values are as sent (value * multiplier), see real_value
+*/
+struct Row {
+    uint32_t time;                  // seconds since 1970
+    int count;                      // values in this row (a text row can be cut short by the message size)
+    int32_t values[CODEC_MAX_VALUES];
+};
+
+/**
+ * everything in a message but the rows
+*/
+struct Message {
+    bool binary;
+    uint16_t schema;                // schema id - from the message if binary, from the matching schema if text
+    char letters[CODEC_MAX_VALUES + 1];     // letters of the values (from the message if text)
+    int num_values;                 // values per row
+    uint32_t first_time;            // time of the first row
+    int32_t batt;                   // battery voltage x 100 (most recent row)
+    int32_t memory;                 // free memory x 0.01 (most recent row)
+    int rows;
+    const Schema *match;            // schema the message was decoded with, NULL for text from an unknown schema
+};
+
+
+
+/* PRIMITIVES */
+
+/**
+ * value * multiplier rounded to a whole number - what gets sent for each value in a message
+*/
+inline long scale_value(float value, float multiplier){
+    float scaled = value * multiplier;
+    return scaled >= 0 ? (long)(scaled + 0.5) : (long)(scaled - 0.5);
+}
+
+/**
+ * write value in decimal into out (and a null terminator), returns the number of characters
+*/
+inline int format_value(char *out, long value){
+    char digits[20];
+    int n = 0;
+    unsigned long v = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+
+    int len = 0;
+    if (value < 0) out[len++] = '-';
+    while (n) out[len++] = digits[--n];
+    out[len] = '\0';
+    return len;
+}
+
+/**
+ * CRC-16/CCITT-FALSE over len bytes, pass the previous result as crc to continue a checksum
+*/
+inline uint16_t crc16(const uint8_t *data, uint32_t len, uint16_t crc = 0xFFFF){
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+/**
+ * write a signed value as a zig-zag varint (7 bits per byte, small magnitudes take one byte)
+ * out can be NULL to just count the bytes; returns the number of bytes
+*/
+inline int put_varint(uint8_t *out, long value){
+    uint32_t zz = ((uint32_t)value << 1) ^ (uint32_t)((int32_t)value >> 31);
+    int n = 0;
+    do {
+        uint8_t b = zz & 0x7F;
+        zz >>= 7;
+        if (zz) b |= 0x80;
+        if (out) out[n] = b;
+        n++;
+    } while (zz);
+    return n;
+}
+
+/**
+ * read a zig-zag varint from in (not past end) into value
+ * returns the number of bytes, 0 if it runs past end or is longer than 5 bytes
+*/
+inline int get_varint(const uint8_t *in, const uint8_t *end, int32_t *value){
+    uint32_t zz = 0;
+    for (int n = 0; n < 5 && in + n < end; n++) {
+        zz |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+        if ((in[n] & 0x80) == 0) {
+            *value = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * seconds since 1970 for an hour of a day (UTC)
+*/
+inline uint32_t unix_time(int year, int month, int day, int hour){
+    year -= month <= 2;
+    int era = year / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long days = (long)era * 146097 + doe - 719468;
+    return (uint32_t)(days * 86400 + hour * 3600L);
+}
+
+/**
+ * split seconds since 1970 into year, month, day and hour (UTC)
+*/
+inline void civil_time(uint32_t time, int *year, int *month, int *day, int *hour){
+    long days = time / 86400 + 719468;
+    *hour = (time % 86400) / 3600;
+    int era = days / 146097;
+    int doe = days - (long)era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = yoe + era * 400 + (*month <= 2);
+}
+
+
+
+/* SCHEMAS */
+
+/**
+ * number of sent parameters (letters) in a schema, at most CODEC_MAX_VALUES
+*/
+inline int schema_values(const Schema &schema){
+    int n = 0;
+    while (n < CODEC_MAX_VALUES && schema.letters[n] != '\0') n++;
+    return n;
+}
+
+/**
+ * identifier for the message layout: CRC-16 of the letters, the number of parameters and the multipliers
+ * (as 4 byte floats) - the schema id in a binary message
+*/
+inline uint16_t schema_id(const Schema &schema){
+    uint16_t crc = crc16((const uint8_t *)schema.letters, schema_values(schema));
+    uint8_t params = schema.num_params;
+    crc = crc16(&params, 1, crc);
+    for (int i = 0; i < schema.num_params; i++) {
+        crc = crc16((const uint8_t *)&schema.multipliers[i], sizeof(float), crc);
+    }
+    return crc;
+}
+
+/**
+ * multiplier of the i-th sent value, 0 if there isn't one
+*/
+inline float sent_multiplier(const Schema &schema, int i){
+    for (int p = 0; p < schema.num_params; p++) {
+        if (schema.multipliers[p] != 0 && i-- == 0) return schema.multipliers[p];
+    }
+    return 0;
+}
+
+/**
+ * a sent value back in its own units (value / multiplier)
+*/
+inline float real_value(const Schema &schema, int i, int32_t value){
+    float multiplier = sent_multiplier(schema, i);
+    return multiplier != 0 ? value / multiplier : 0;
+}
+
+/**
+ * fill out with the sent values of one row of all num_params parameters, returns how many
+*/
+inline int sent_values(const Schema &schema, const float *params, long *out){
+    int n = 0;
+    for (int p = 0; p < schema.num_params; p++) {
+        if (schema.multipliers[p] != 0) out[n++] = scale_value(params[p], schema.multipliers[p]);
+    }
+    return n;
+}
+
+
+
+/* ENCODING */
+
+/**
+ * start a text message in out: letters, date and hour of the first row, battery and memory
+ * returns the length (out needs room for num_letters + 36)
+*/
+inline int put_text_header(char *out, const char *letters, int num_letters, uint32_t first_time, long batt, long memory){
+    int year, month, day, hour;
+    civil_time(first_time, &year, &month, &day, &hour);
+
+    int len = 0;
+    memcpy(out, letters, num_letters);
+    len += num_letters;
+    out[len++] = ':';
+    int fields[4] = {year % 100, month, day, hour};
+    for (int i = 0; i < 4; i++) {
+        out[len++] = '0' + fields[i] / 10;
+        out[len++] = '0' + fields[i] % 10;
+    }
+    out[len++] = ':';
+    len += format_value(out + len, batt);
+    out[len++] = ':';
+    len += format_value(out + len, memory);
+    out[len++] = ':';
+    return len;
+}
+
+/**
+ * add one row of n values to a text message - values that would take the message past room - 16
+ * characters are left off, so a row can come out short
+ * returns the characters written (room is what's left in the buffer at out)
+*/
+inline int put_text_row(char *out, int room, const long *values, int n){
+    int len = 0;
+    for (int i = 0; i < n && len < room - 16; i++) {
+        len += format_value(out + len, values[i]);
+        out[len++] = ',';
+    }
+    if (len > 0) out[len - 1] = ':';
+    return len;
+}
+
+/**
+ * characters for one row of a text message (values and separators)
+*/
+inline int text_row_size(const long *values, int n){
+    char value[24];
+    int len = 0;
+    for (int i = 0; i < n; i++) len += format_value(value, values[i]) + 1;
+    return len;
+}
+
+/**
+ * start a binary message in out: version, schema id, first row time, row count, battery and memory
+ * out can be NULL to count; returns the number of bytes
+*/
+inline int put_binary_header(uint8_t *out, uint16_t schema, uint32_t first_time, int rows, long batt, long memory){
+    if (out) {
+        out[0] = BINARY_MSG_VERSION;
+        out[1] = schema & 0xFF;
+        out[2] = schema >> 8;
+        out[3] = first_time & 0xFF;
+        out[4] = (first_time >> 8) & 0xFF;
+        out[5] = (first_time >> 16) & 0xFF;
+        out[6] = first_time >> 24;
+        out[7] = rows;
+    }
+    int n = BINARY_HEADER_BYTES;
+    n += put_varint(out ? out + n : NULL, batt);
+    n += put_varint(out ? out + n : NULL, memory);
+    return n;
+}
+
+/**
+ * add one row of n values to a binary message: seconds since the previous row and each value as the
+ * change from prev, or whole for the first row (prev NULL, dt 0)
+ * out can be NULL to count; returns the number of bytes
+*/
+inline int put_binary_row(uint8_t *out, uint32_t dt, const long *values, const long *prev, int n){
+    int len = put_varint(out, (long)dt);
+    for (int i = 0; i < n; i++) {
+        len += put_varint(out ? out + len : NULL, prev ? values[i] - prev[i] : values[i]);
+    }
+    return len;
+}
+
+
+
+/* DECODING */
+
+/**
+ * decode a binary message with num_values values per row into msg and up to max_rows rows
+ * returns the number of rows, -1 if it isn't a binary message or is cut short
+*/
+inline int decode_binary(const uint8_t *data, int len, int num_values, Message *msg, Row *rows, int max_rows){
+    if (len < BINARY_HEADER_BYTES + 2 || data[0] != BINARY_MSG_VERSION) return -1;
+    if (num_values > CODEC_MAX_VALUES) return -1;
+    const uint8_t *end = data + len;
+
+    msg->binary = true;
+    msg->schema = data[1] | (uint16_t)data[2] << 8;
+    msg->first_time = data[3] | (uint32_t)data[4] << 8 | (uint32_t)data[5] << 16 | (uint32_t)data[6] << 24;
+    msg->rows = data[7];
+    msg->num_values = num_values;
+
+    const uint8_t *p = data + BINARY_HEADER_BYTES;
+    int n;
+    if ((n = get_varint(p, end, &msg->batt)) == 0) return -1;
+    p += n;
+    if ((n = get_varint(p, end, &msg->memory)) == 0) return -1;
+    p += n;
+
+    uint32_t time = msg->first_time;
+    int32_t values[CODEC_MAX_VALUES] = {0};
+    int count = msg->rows < max_rows ? msg->rows : max_rows;
+    for (int r = 0; r < msg->rows; r++) {
+        int32_t dt;
+        if ((n = get_varint(p, end, &dt)) == 0) return -1;
+        p += n;
+        time += dt;
+        for (int i = 0; i < num_values; i++) {
+            int32_t change;
+            if ((n = get_varint(p, end, &change)) == 0) return -1;
+            p += n;
+            values[i] += change;
+        }
+        if (r < count) {
+            rows[r].time = time;
+            rows[r].count = num_values;
+            memcpy(rows[r].values, values, num_values * sizeof(int32_t));
+        }
+    }
+    return count;
+}
+
+/**
+ * helper function
+ * read a signed decimal number from text, stopping at end; returns the characters used, 0 if none
+*/
+inline int get_number(const char *text, const char *end, int32_t *value){
+    const char *p = text;
+    bool negative = p < end && *p == '-';
+    if (negative) p++;
+    if (p >= end || *p < '0' || *p > '9') return 0;
+    uint32_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+    *value = negative ? -(int32_t)v : (int32_t)v;
+    return p - text;
+}
+
+/**
+ * decode a text message (from prep_msg or the outbox) of len characters into msg and up to max_rows rows
+ * rows are an hour apart from the first; a profile summary (P...) at the end is skipped
+ * returns the number of rows, -1 if it isn't a text message
+*/
+inline int decode_text(const char *text, int len, Message *msg, Row *rows, int max_rows){
+    const char *p = text;
+    const char *end = text + len;
+
+    msg->binary = false;
+    int n = 0;
+    while (p < end && *p != ':') {
+        if (n == CODEC_MAX_VALUES || *p < 'A' || *p > 'z') return -1;
+        msg->letters[n++] = *p++;
+    }
+    msg->letters[n] = '\0';
+    msg->num_values = n;
+    if (end - p < 10 || p[9] != ':') return -1;
+
+    int fields[4];
+    for (int i = 0; i < 4; i++) {
+        char hi = p[1 + 2 * i], lo = p[2 + 2 * i];
+        if (hi < '0' || hi > '9' || lo < '0' || lo > '9') return -1;
+        fields[i] = (hi - '0') * 10 + lo - '0';
+    }
+    if (fields[1] < 1 || fields[1] > 12 || fields[2] < 1 || fields[2] > 31 || fields[3] > 23) return -1;
+    msg->first_time = unix_time(2000 + fields[0], fields[1], fields[2], fields[3]);
+    p += 10;
+
+    int used;
+    if ((used = get_number(p, end, &msg->batt)) == 0 || p + used >= end || p[used] != ':') return -1;
+    p += used + 1;
+    if ((used = get_number(p, end, &msg->memory)) == 0 || p + used >= end || p[used] != ':') return -1;
+    p += used + 1;
+
+    msg->rows = 0;
+    while (p < end && *p != 'P' && *p != '\0') {
+        Row scratch;
+        Row *row = msg->rows < max_rows ? &rows[msg->rows] : &scratch;
+        row->time = msg->first_time + 3600UL * msg->rows;
+        row->count = 0;
+        while (true) {
+            int32_t value;
+            if ((used = get_number(p, end, &value)) == 0) return -1;
+            p += used;
+            if (row->count < msg->num_values) row->values[row->count++] = value;      // extras are dropped
+            if (p >= end) return -1;
+            if (*p++ == ':') break;
+        }
+        msg->rows++;
+    }
+    return msg->rows < max_rows ? msg->rows : max_rows;
+}
+
+/**
+ * helper function
+ * decode with the schema ids already worked out - see decode
+*/
+inline int decode_with(const uint8_t *data, int len, const Schema *schemas, const uint16_t *ids, int num_schemas,
+        Message *msg, Row *rows, int max_rows){
+    if (len > 0 && data[0] == BINARY_MSG_VERSION) {
+        if (len < 3) return -1;
+        uint16_t id = data[1] | (uint16_t)data[2] << 8;
+        for (int s = 0; s < num_schemas; s++) {
+            if (ids[s] != id) continue;
+            msg->match = &schemas[s];
+            int n = decode_binary(data, len, schema_values(schemas[s]), msg, rows, max_rows);
+            memcpy(msg->letters, schemas[s].letters, msg->num_values);
+            msg->letters[msg->num_values] = '\0';
+            return n;
+        }
+        return -1;          // values can't be split up without the schema
+    }
+
+    int n = decode_text((const char *)data, len, msg, rows, max_rows);
+    msg->match = NULL;
+    if (n < 0) return n;
+    for (int s = 0; s < num_schemas; s++) {
+        if (schema_values(schemas[s]) == msg->num_values && memcmp(schemas[s].letters, msg->letters, msg->num_values) == 0) {
+            msg->match = &schemas[s];
+            msg->schema = ids[s];
+            break;
+        }
+    }
+    if (msg->match == NULL) msg->schema = 0;
+    return n;
+}
+
+/**
+ * decode a text or binary message, telling them apart by the first byte
+ * binary messages are decoded with the schema whose id they carry; text messages carry their letters and
+ * are matched to a schema by them (msg->match NULL if none has them)
+ * returns the number of rows, -1 if the message can't be decoded
+*/
+inline int decode(const uint8_t *data, int len, const Schema *schemas, int num_schemas, Message *msg, Row *rows, int max_rows){
+    uint16_t ids[CODEC_MAX_SCHEMAS];
+    if (num_schemas > CODEC_MAX_SCHEMAS) num_schemas = CODEC_MAX_SCHEMAS;
+    for (int s = 0; s < num_schemas; s++) ids[s] = schema_id(schemas[s]);
+    return decode_with(data, len, schemas, ids, num_schemas, msg, rows, max_rows);
+}
+
+/**
+ * decode every message in an archive dump: each message as its length (2 bytes, little endian) and then
+ * its bytes, text or binary - the way a receiving endpoint appends the SBD payloads it gets
+ * sink(const Message &msg, const Row *rows) is called for each message that decodes, in order
+ * bad, if not NULL, is set to the number of messages that didn't decode
+ * returns the number of messages decoded
+*/
+template <class Sink> long decode_dump(const uint8_t *dump, size_t len, const Schema *schemas, int num_schemas, Sink sink, long *bad = NULL){
+    uint16_t ids[CODEC_MAX_SCHEMAS];
+    if (num_schemas > CODEC_MAX_SCHEMAS) num_schemas = CODEC_MAX_SCHEMAS;
+    for (int s = 0; s < num_schemas; s++) ids[s] = schema_id(schemas[s]);
+
+    Row rows[BINARY_MAX_ROWS];
+    Message msg;
+    long good = 0, failed = 0;
+    size_t pos = 0;
+    while (pos + 2 <= len) {
+        size_t size = dump[pos] | (size_t)dump[pos + 1] << 8;
+        pos += 2;
+        if (pos + size > len) {         // cut off at the end of the dump
+            failed++;
+            break;
+        }
+        if (decode_with(dump + pos, size, schemas, ids, num_schemas, &msg, rows, BINARY_MAX_ROWS) >= 0) {
+            sink((const Message &)msg, (const Row *)rows);
+            good++;
+        }
+        else failed++;
+        pos += size;
+    }
+    if (bad) *bad = failed;
+    return good;
+}
+
+}
+
+#endif
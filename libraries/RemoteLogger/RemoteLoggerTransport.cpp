@@ -0,0 +1,198 @@
+/**
+ * telemetry links for the RemoteLogger outbox - see RemoteLoggerTransport.h
+ * IridiumTransport is in RemoteLogger.cpp, next to the modem it drives
+*/
+
+#include "RemoteLoggerTransport.h"
+
+
+
+
+/* TRANSPORT */
+
+/**
+ * cost of one message of len bytes: the message cost plus the bytes, rounded up to whole blocks
+ */
+float Transport::cost(int len){
+    int block = billed_bytes > 0 ? billed_bytes : 1;
+    int blocks = (len + block - 1) / block;
+    return msg_cost + byte_cost * blocks * block;
+}
+
+/**
+ * read one line from a serial link into line (without the line ending), skipping empty ones
+ * returns its length, -1 if no whole line came within ms
+ */
+int Transport::read_line(Stream &serial, char *line, int size, unsigned long ms){
+    unsigned long start = millis();
+    int len = 0;
+    while (millis() - start < ms) {
+        if (serial.available() <= 0) {
+            delay(1);
+            continue;
+        }
+        char c = serial.read();
+        if (c == '\r' || c == '\n') {
+            if (len == 0) continue;
+            line[len] = '\0';
+            return len;
+        }
+        if (len < size - 1) line[len++] = c;        // the rest of a long line is dropped
+    }
+    return -1;
+}
+
+/**
+ * write data as hex digits
+ * returns check XORed with every character written, for NMEA-style checksums
+ */
+uint8_t Transport::write_hex(Stream &serial, const uint8_t *data, int len, uint8_t check){
+    const char *digits = "0123456789ABCDEF";
+    for (int i = 0; i < len; i++) {
+        char high = digits[data[i] >> 4], low = digits[data[i] & 0x0F];
+        serial.write((uint8_t)high);
+        serial.write((uint8_t)low);
+        check ^= high ^ low;
+    }
+    return check;
+}
+
+/**
+ * read hex digits into out, stopping at the first character that isn't one
+ * returns the number of bytes read
+ */
+int Transport::read_hex(const char *hex, uint8_t *out, int size){
+    int n = 0;
+    while (n < size) {
+        int value = 0;
+        for (int k = 0; k < 2; k++) {
+            char c = hex[2 * n + k];
+            int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'A' && c <= 'F' ? c - 'A' + 10 : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+            if (digit < 0) return n;
+            value = value * 16 + digit;
+        }
+        out[n++] = value;
+    }
+    return n;
+}
+
+
+
+
+/* SWARM */
+
+/**
+ * check the M138 is there and running by asking for its configuration ($CS)
+ * returns ISBD_SUCCESS, or ISBD_NO_MODEM_DETECTED if it doesn't answer
+ */
+int SwarmTransport::begin(){
+    char line[TRANSPORT_LINE_BYTES];
+    while (serial.available() > 0) serial.read();        // anything the modem said since the last session
+    serial.print("$CS*10\n");
+    return command_reply("$CS ", line, SWARM_REPLY_MS) ? ISBD_SUCCESS : ISBD_NO_MODEM_DETECTED;
+}
+
+/**
+ * queue a message on the M138 ($TD with the message as hex), text exactly as binary
+ * the modem sends it on the next satellite pass - success here means it was queued
+ * returns ISBD_SUCCESS, ISBD_MSG_TOO_LONG, ISBD_PROTOCOL_ERROR if the modem refused it (e.g. queue full),
+ * or ISBD_SENDRECEIVE_TIMEOUT if it didn't answer
+ */
+int SwarmTransport::send(const uint8_t *data, int len, bool binary, uint8_t *rx, size_t &rx_len){
+    (void)binary;
+    (void)rx;
+    rx_len = 0;
+    if (len > SWARM_MTU) return ISBD_MSG_TOO_LONG;
+
+    // checksum is the XOR of everything between $ and *
+    uint8_t check = 'T' ^ 'D' ^ ' ';
+    serial.print("$TD ");
+    check = write_hex(serial, data, len, check);
+    char tail[6];
+    snprintf(tail, sizeof(tail), "*%02x\n", check);
+    serial.print(tail);
+
+    char line[TRANSPORT_LINE_BYTES];
+    int reply = command_reply("$TD ", line, SWARM_REPLY_MS);
+    if (reply == 0) return ISBD_SENDRECEIVE_TIMEOUT;
+    return strncmp(line + 4, "OK", 2) == 0 ? ISBD_SUCCESS : ISBD_PROTOCOL_ERROR;
+}
+
+/**
+ * helper function
+ * wait for the line starting with reply (e.g. "$TD "), skipping anything else the modem says
+ * returns its length, 0 if it didn't come within ms
+ */
+int SwarmTransport::command_reply(const char *reply, char *line, unsigned long ms){
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        int len = read_line(serial, line, TRANSPORT_LINE_BYTES, ms - (millis() - start));
+        if (len < 0) break;
+        if (strncmp(line, reply, strlen(reply)) == 0) return len;
+    }
+    return 0;
+}
+
+
+
+
+/* SERIAL BRIDGE */
+
+/**
+ * power up the bridge board and wait until it says it is connected (UP), asking once a second
+ * returns ISBD_SUCCESS, ISBD_NO_NETWORK if it stayed DOWN, ISBD_NO_MODEM_DETECTED if it never answered
+ */
+int SerialBridgeTransport::begin(){
+    if (powerPin >= 0) {
+        pinMode(powerPin, OUTPUT);
+        digitalWrite(powerPin, HIGH);
+    }
+
+    char line[TRANSPORT_LINE_BYTES];
+    bool answered = false;
+    unsigned long start = millis();
+    while (millis() - start < BRIDGE_UP_MS) {
+        serial.print("UP?\n");
+        if (read_line(serial, line, sizeof(line), 1000) < 0) continue;
+        answered = true;
+        if (strcmp(line, "UP") == 0) return ISBD_SUCCESS;
+        delay(1000);
+    }
+    return answered ? ISBD_NO_NETWORK : ISBD_NO_MODEM_DETECTED;
+}
+
+/**
+ * send a message as hex (TX) and wait for the board to publish it
+ * a message for the logger can come back with the OK, as hex
+ * returns ISBD_SUCCESS, ISBD_MSG_TOO_LONG, ISBD_PROTOCOL_ERROR if the board said ERR,
+ * or ISBD_SENDRECEIVE_TIMEOUT
+ */
+int SerialBridgeTransport::send(const uint8_t *data, int len, bool binary, uint8_t *rx, size_t &rx_len){
+    (void)binary;
+    size_t room = rx_len;
+    rx_len = 0;
+    if (len > mtu) return ISBD_MSG_TOO_LONG;
+
+    serial.print("TX ");
+    write_hex(serial, data, len);
+    serial.print("\n");
+
+    // long enough for a reply carrying a whole message for the logger
+    char line[2 * 270 + 8];
+    while (true) {
+        int got = read_line(serial, line, sizeof(line), BRIDGE_REPLY_MS);
+        if (got < 0) return ISBD_SENDRECEIVE_TIMEOUT;
+        if (strncmp(line, "ERR", 3) == 0) return ISBD_PROTOCOL_ERROR;
+        if (strncmp(line, "OK", 2) == 0) break;         // anything else is the board talking - skip it
+    }
+    if (line[2] == ' ') rx_len = read_hex(line + 3, rx, room);
+    return ISBD_SUCCESS;
+}
+
+/**
+ * power the bridge board down (if it has a power pin)
+ */
+void SerialBridgeTransport::end(int err){
+    (void)err;
+    if (powerPin >= 0) digitalWrite(powerPin, LOW);
+}
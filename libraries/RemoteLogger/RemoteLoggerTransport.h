@@ -0,0 +1,113 @@
+/**
+ * telemetry links for the RemoteLogger outbox
+ * a transport powers up a link, sends messages over it and says what they cost; the logger sends
+ * the outbox over the cheapest link that is up (see add_transport), with Iridium as the fallback
+ * errors are the IridiumSBD codes (ISBD_SUCCESS etc.) so the send counters treat every link the same
+ *
+ * backends: IridiumTransport (the logger's own RockBLOCK, always there), SwarmTransport (Swarm M138),
+ * SerialBridgeTransport (a cellular board such as a Particle Boron on a serial line)
+ * costs are in whatever unit the sketch likes - the defaults are rough US cents
+*/
+
+#ifndef RemoteLoggerTransport_h
+#define RemoteLoggerTransport_h
+
+#include <Arduino.h>
+#include <IridiumSBD.h>
+
+#define SWARM_MTU 192               // longest Swarm message
+#define SWARM_REPLY_MS 5000         // wait for the M138 to answer a command
+#define BRIDGE_MTU 340              // longest message for the bridge board (outbox frames are no longer)
+#define BRIDGE_UP_MS 60000          // wait for the bridge board to get a cellular connection
+#define BRIDGE_REPLY_MS 30000       // wait for the bridge board to publish a message
+#define TRANSPORT_LINE_BYTES 96     // longest reply line read from a serial link
+
+class RemoteLogger;
+
+/**
+ * one way of getting messages off the logger
+ * a session is begin, link_up before each message, send for each message, receive until nothing comes, end
+*/
+class Transport
+{
+    public:
+        Transport(const char *name, int mtu, float msg_cost, float byte_cost, int billed_bytes, unsigned long latency_s)
+            : name(name), mtu(mtu), msg_cost(msg_cost), byte_cost(byte_cost), billed_bytes(billed_bytes), latency_s(latency_s) {}
+
+        virtual int begin() = 0;            // power up and find the network, ISBD_SUCCESS if ready to send
+        virtual bool link_up() { return true; }        // worth sending the next message now
+        virtual int send(const uint8_t *data, int len, bool binary, uint8_t *rx, size_t &rx_len) = 0;   // text is null terminated
+        virtual int receive(uint8_t *rx, size_t &rx_len) { (void)rx; rx_len = 0; return ISBD_SUCCESS; }  // a message waiting for the logger
+        virtual void end(int err) { (void)err; }       // power down, err is the session result
+        float cost(int len);                // cost of one message of len bytes
+
+        const char *name;
+        int mtu;                            // longest message in bytes
+        float msg_cost;                     // cost of every message
+        float byte_cost;                    // cost of every byte, billed in blocks of billed_bytes
+        int billed_bytes;
+        unsigned long latency_s;            // typical time from send to the message reaching the server
+
+    protected:
+        static int read_line(Stream &serial, char *line, int size, unsigned long ms);
+        static uint8_t write_hex(Stream &serial, const uint8_t *data, int len, uint8_t check = 0);
+        static int read_hex(const char *hex, uint8_t *out, int size);
+};
+
+/**
+ * the logger's RockBLOCK - 340 byte messages, billed in 50 byte credits
+ * sessions are the same as begin_session / session_send / end_session
+*/
+class IridiumTransport : public Transport
+{
+    public:
+        IridiumTransport(RemoteLogger &logger) : Transport("iridium", 340, 0, 0.2, 50, 60), logger(logger) {}
+        int begin() override;
+        bool link_up() override;
+        int send(const uint8_t *data, int len, bool binary, uint8_t *rx, size_t &rx_len) override;
+        int receive(uint8_t *rx, size_t &rx_len) override;
+        void end(int err) override;
+
+    private:
+        RemoteLogger &logger;
+};
+
+/**
+ * Swarm M138 modem on a serial port (115200 baud) - messages are queued on the modem and go up on the
+ * next satellite pass, so the M138 needs its own power to stay on between wakes
+ * messages are sent as hex ($TD) and arrive as the same bytes; nothing is received
+*/
+class SwarmTransport : public Transport
+{
+    public:
+        SwarmTransport(Stream &serial) : Transport("swarm", SWARM_MTU, 0.67, 0, 1, 7200), serial(serial) {}
+        int begin() override;
+        int send(const uint8_t *data, int len, bool binary, uint8_t *rx, size_t &rx_len) override;
+
+    private:
+        int command_reply(const char *reply, char *line, unsigned long ms);
+        Stream &serial;
+};
+
+/**
+ * a board with its own cellular (or other) link on a serial port, e.g. a Particle Boron publishing
+ * to the cloud, talking one line each way:
+ *   logger "UP?"       board "UP" once it is connected, "DOWN" until then
+ *   logger "TX <hex>"  board "OK" once the message went, "OK <hex>" with a message for the logger, or "ERR"
+ * powerPin (if not -1) is set high for the session
+*/
+class SerialBridgeTransport : public Transport
+{
+    public:
+        SerialBridgeTransport(Stream &serial, int powerPin = -1)
+            : Transport("bridge", BRIDGE_MTU, 0.01, 0.001, 1, 10), serial(serial), powerPin(powerPin) {}
+        int begin() override;
+        int send(const uint8_t *data, int len, bool binary, uint8_t *rx, size_t &rx_len) override;
+        void end(int err) override;
+
+    private:
+        Stream &serial;
+        int powerPin;
+};
+
+#endif
@@ -55,7 +55,7 @@ void loop(void){
     // determine whether or not to write to hourly
     int samplesSinceHourly = logger.num_samples();
     if (samplesSinceHourly == 4) {    // it's been an hour --> write to hourly
-        logger.write_to_csv(header, presentTime.timestamp() + "," + sample, "/HOURLY.csv");
+        logger.write_hourly(presentTime, sample);
         logger.reset_sample_counter();      // reset the tracker - wrote to hourly
 
         // determine whether or not to send a message
@@ -49,7 +49,7 @@ void loop(){
 
     int samplesSinceHourly = logger.num_samples();      // number of samples since last write to hourly
     if (samplesSinceHourly == 4){        // it's been an hour --> write to hourly
-        logger.write_to_csv(header, presentTime.timestamp() + "," + sample, "/HOURLY.csv");
+        logger.write_hourly(presentTime, sample);
         logger.reset_sample_counter();          // reset the since-hourly counter
 
         int hourlySamples = logger.num_hours();     // number of hours since a message was sent
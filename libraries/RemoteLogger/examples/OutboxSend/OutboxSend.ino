@@ -0,0 +1,70 @@
+/**
+ * sample from Hydros21 and send through the outbox
+ * https://metergroup.com/products/hydros-21/ 
+ * same logger as FullCode/Hydros21, but every 4 hours the hourly samples are moved into the outbox
+ * on the SD card and sent from there - messages that don't go through are kept and sent on a later
+ * wake instead of being deleted, so data from a long outage still arrives
+ * designed for use with TPL nano timer set to 15 minutes
+*/
+
+#include <RemoteLogger.h>
+
+const int dataPin = 12;             //pin for SDI-12 data bus on Hydros (can attach to any digital pin)
+const int sensorAddress = 0;        //address for Hydros on SDI-12 (factory default is 0)
+SDI12 mySDI12(dataPin);             //data bus object
+
+String header = "datetime,batt_v,memory,water_level_mm,water_temp_c,water_ec_dcm";      // header for CSV file
+const byte num_params = 3;        // number of sampled parameters 
+float multipliers[num_params] = {1, 10, 1};         // multipliers for parameters (in order) to remove decimals for messages
+String letters = "ABC";         // letters for start of message, correspond to sampled parameters
+
+const int maxPerSession = 4;        // most messages to send each time (each one uses credits)
+
+RemoteLogger logger(header, num_params, multipliers, letters);        // custom library instance
+Measurement msmt;       // filled in place every wake
+
+void setup(void){
+    // if you want to change any pins from the preset do it here (see docs for preset)
+    delay(500);
+    
+    logger.begin();     // start up the logger
+    mySDI12.begin();    // start up data bus for hydros (user is reponsible for external sensors)
+
+}
+
+void loop(void){
+    delay(100);
+
+    DateTime presentTime = logger.rtc.now();    // wake up, check time
+
+    // take measurement
+    logger.start_measurement(&msmt);
+    logger.sample_hydros_M(mySDI12, sensorAddress, &msmt);
+    
+    // write to DATA.csv
+    logger.write_measurement(presentTime, &msmt, "/DATA.csv");
+
+    // increment sample tracker (since last write to hourly)
+    logger.increment_samples();
+
+    if (logger.num_samples() >= 4) {    // it's been an hour --> write to hourly
+        logger.write_hourly(presentTime, &msmt);
+        logger.reset_sample_counter();      // reset the tracker - wrote to hourly
+
+        // every 4 hours move the hourly samples into the outbox
+        if (logger.num_hours() >= 4) {
+            logger.queue_hourly();
+        }
+
+        // send whatever is waiting - anything that doesn't go stays for next hour
+        if (logger.num_outbox() > 0) {
+            logger.send_outbox(maxPerSession);
+        }
+    }
+
+    // for visual done: 
+    logger.blinky(3, 500, 500, 1000);   // blink 3 times to simulate tpl done
+
+    // trigger done pin on TPL
+    logger.tpl_done();
+}
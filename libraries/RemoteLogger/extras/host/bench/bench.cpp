@@ -0,0 +1,361 @@
+/**
+ * host benchmarks for the RemoteLogger hot paths, built over the mocks in ../mock
+ * for each case reports host time per call, heap allocations per call, peak heap above the start,
+ * SD traffic per call, and virtual (on-device) time per call from the mocked clock
+ *
+ * usage: build/bench [filter]     - runs every case whose name contains filter
+*/
+
+#include <RemoteLogger.h>
+#include <CSV_Parser.h>
+#include <chrono>
+#include <vector>
+#include <malloc.h>
+
+/* heap accounting - every allocation on the host goes through these (glibc) */
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+namespace heap {
+    unsigned long allocs = 0;
+    long live = 0;
+    long peak = 0;
+    bool counting = false;
+
+    static void added(void *p){
+        if (!counting || p == NULL) return;
+        allocs++;
+        live += malloc_usable_size(p);
+        if (live > peak) peak = live;
+    }
+    static void removed(void *p){
+        if (!counting || p == NULL) return;
+        live -= malloc_usable_size(p);
+    }
+}
+
+extern "C" void *malloc(size_t size){
+    void *p = __libc_malloc(size);
+    heap::added(p);
+    return p;
+}
+
+extern "C" void *calloc(size_t n, size_t size){
+    void *p = __libc_calloc(n, size);
+    heap::added(p);
+    return p;
+}
+
+extern "C" void *realloc(void *ptr, size_t size){
+    heap::removed(ptr);
+    void *p = __libc_realloc(ptr, size);
+    heap::added(p);
+    return p;
+}
+
+extern "C" void free(void *ptr){
+    heap::removed(ptr);
+    __libc_free(ptr);
+}
+
+void *operator new(size_t size){ return malloc(size); }
+void *operator new[](size_t size){ return malloc(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+/* running a case */
+
+static const char *filter = NULL;
+
+/**
+ * time iters calls of body and print one line of results
+ * setup runs before each call and is not counted (e.g. filling the hourly store the call empties)
+*/
+template <class Setup, class Body> void bench(const char *name, int iters, Setup setup, Body body){
+    if (filter != NULL && strstr(name, filter) == NULL) return;
+
+    unsigned long opens = 0, bytes_written = 0;
+    uint64_t virtual_us = 0;
+    double ns = 0;
+    heap::allocs = 0;
+    heap::peak = 0;
+
+    for (int i = 0; i < iters; i++) {
+        setup(i);
+        heap::live = 0;         // peak is above the start of the call
+        mock::SDStats before = mock::sd_stats;
+        uint64_t virtual_start = mock::clock_us;
+        heap::counting = true;
+        auto start = std::chrono::steady_clock::now();
+        body(i);
+        auto end = std::chrono::steady_clock::now();
+        heap::counting = false;
+        ns += std::chrono::duration<double, std::nano>(end - start).count();
+        virtual_us += mock::clock_us - virtual_start;
+        opens += mock::sd_stats.opens - before.opens;
+        bytes_written += mock::sd_stats.bytes_written - before.bytes_written;
+    }
+
+    printf("%-34s %7d %12.0f %9.2f %8ld %8.1f %10.0f %12.1f\n", name, iters, ns / iters, (double)heap::allocs / iters, heap::peak,
+        (double)opens / iters, (double)bytes_written / iters, (double)virtual_us / iters);
+}
+
+template <class Body> void bench(const char *name, int iters, Body body){
+    bench(name, iters, [](int){}, body);
+}
+
+/* fixtures */
+
+static float multipliers[3] = {1, 10, 1};
+static const char *header = "datetime,batt_v,memory,water_level_mm,water_temp_c,water_ec_dcm";
+
+/**
+ * fresh card and logger with rows waiting in the hourly store
+*/
+static void fill_hourly(RemoteLogger &logger, int rows){
+    Measurement msmt;
+    for (int i = 0; i < rows; i++) {
+        logger.start_measurement(&msmt);
+        logger.add_value(&msmt, 1000 + (i * 37) % 200);
+        logger.add_value(&msmt, 4.5 + (i % 24) * 0.1);
+        logger.add_value(&msmt, 120 + i % 7);
+        logger.write_hourly(DateTime(2024, 6, 1, 0, 5, 0) + TimeSpan((int32_t)i * 3600), &msmt);
+    }
+}
+
+/**
+ * HOURLY.csv as the sketches wrote it before the binary ring store, for the CSV_Parser baseline
+*/
+static void write_hourly_csv(int rows){
+    std::vector<uint8_t> &file = mock::sd_files["/HOURLY.CSV"];
+    file.clear();
+    std::string text = std::string(header) + "\r\n";
+    char line[96];
+    for (int i = 0; i < rows; i++) {
+        DateTime t = DateTime(2024, 6, 1, 0, 5, 0) + TimeSpan((int32_t)i * 3600);
+        snprintf(line, sizeof(line), "%s,4.1,24000,%d,%.1f,%d\r\n", t.timestamp().c_str(),
+            1000 + (i * 37) % 200, 4.5 + (i % 24) * 0.1, 120 + i % 7);
+        text += line;
+    }
+    file.assign(text.begin(), text.end());
+}
+
+int main(int argc, char **argv){
+    if (argc > 1) filter = argv[1];
+    mock::analog_value[9] = 620;
+
+    printf("%-34s %7s %12s %9s %8s %8s %10s %12s\n", "case", "iters", "host ns", "allocs", "peak B",
+        "SD opens", "SD bytes", "device us");
+
+    /* messages from the hourly store */
+    int sizes[4] = {10, 100, 1000, 10000};
+    for (int s = 0; s < 4; s++) {
+        char name[64];
+
+        mock::sd_reset();
+        RemoteLogger logger(header, 3, multipliers, "ABC");
+        logger.begin();
+        fill_hourly(logger, sizes[s]);      // the ring keeps the newest HOURLY_CAPACITY
+
+        snprintf(name, sizeof(name), "prep_msg/%d", sizes[s]);
+        bench(name, 200, [&](int){ logger.prep_msg(); });
+
+        uint8_t buf[OUTBOX_FRAME_BYTES];
+        snprintf(name, sizeof(name), "prep_binary_msg/%d", sizes[s]);
+        bench(name, 200, [&](int){ logger.prep_binary_msg(buf, sizeof(buf)); });
+
+        // the old path: parse all of HOURLY.csv with CSV_Parser to find the last rows
+        write_hourly_csv(sizes[s]);
+        snprintf(name, sizeof(name), "csv_parser_hourly/%d", sizes[s]);
+        bench(name, sizes[s] >= 1000 ? 5 : 50, [&](int){
+            CSV_Parser cp("sffddd", true, ',');
+            cp.readSDfile("/HOURLY.csv");
+            char **times = (char **)cp[0];
+            for (int i = 0; i < cp.getRowsCount(); i++) free(times[i]);
+            delete[] times;                     // the caller owns the column arrays
+            delete[] (float *)cp[1];
+            delete[] (float *)cp[2];
+            for (int i = 3; i < 6; i++) delete[] (int16_t *)cp[i];
+        });
+    }
+
+    /* splitting the whole ring into outbox messages */
+    {
+        mock::sd_reset();
+        RemoteLogger logger(header, 3, multipliers, "ABC");
+        logger.begin();
+        auto refill = [&](int){ logger.clear_outbox(); fill_hourly(logger, HOURLY_CAPACITY); };
+        bench("queue_hourly/240 text", 20, refill, [&](int){ logger.queue_hourly(false); });
+        bench("queue_hourly/240 binary", 20, refill, [&](int){ logger.queue_hourly(true); });
+        bench("num_outbox", 1000, [&](int){ logger.num_outbox(); });
+    }
+
+    /* counters */
+    {
+        mock::sd_reset();
+        RemoteLogger logger(header, 3, multipliers, "ABC");
+        logger.begin();
+        fill_hourly(logger, 50);
+        bench("num_samples", 10000, [&](int){ logger.num_samples(); });
+        bench("num_hours", 10000, [&](int){ logger.num_hours(); });
+        bench("increment_samples", 2000, [&](int){ logger.increment_samples(); });
+    }
+
+    /* appending to DATA.csv */
+    {
+        mock::sd_reset();
+        RemoteLogger logger(header, 3, multipliers, "ABC");
+        logger.begin();
+        String line = "2024-06-01T00:05:00,4.1,24000,1034,4.6,121";
+        bench("write_to_csv", 10000, [&](int){ logger.write_to_csv(header, line, "/DATA.csv"); });
+        bench("flush_logs", 1, [&](int){ logger.flush_logs(); });
+
+        Measurement msmt;
+        logger.start_measurement(&msmt);
+        logger.add_value(&msmt, 1034);
+        logger.add_value(&msmt, 4.6);
+        logger.add_value(&msmt, 121);
+        bench("write_measurement", 10000, [&](int i){
+            logger.write_measurement(DateTime(2024, 6, 1) + TimeSpan((int32_t)i * 900), &msmt, "/DATA.csv");
+        });
+        bench("format_measurement", 10000, [&](int){ logger.format_measurement(DateTime(2024, 6, 1), &msmt); });
+
+        // the same measurements into daily binary segments, then a week back out of 400 days
+        bench("write_archive", 38400, [&](int i){
+            logger.write_archive(DateTime(2024, 6, 1) + TimeSpan((int32_t)i * 900), &msmt);
+        });
+        static HourlyRecord week[7 * 96];
+        uint32_t from = DateTime(2025, 3, 1).unixtime();
+        bench("read_archive/week of 400 days", 100, [&](int){ logger.read_archive(from, from + 7 * 86400, week, 7 * 96); });
+    }
+
+    /* SDI-12 - the host time is reply parsing, device time includes the sensor's own wait */
+    {
+        mock::sd_reset();
+        mock::sdi12_reset();
+        mock::sdi12_add_sensor('0', "13METER HYDROS21", 1000, "+1034.5+4.62+121");
+        SDI12 bus(12);
+        bus.begin();
+        RemoteLogger logger(header, 3, multipliers, "ABC");
+        logger.begin();
+        Measurement msmt;
+        bench("sample_hydros_M", 200, [&](int){ logger.start_measurement(&msmt); logger.sample_hydros_M(bus, 0, &msmt); });
+        bench("sample_hydros_M String", 200, [&](int){ logger.sample_hydros_M(bus, 0); });
+
+        // discovery scans every address once, later wakes read the sensors back from /SDI12.bin
+        bench("find_sdi12_bus search", 5, [&](int){ logger.find_sdi12_bus(bus, true); });
+        bench("find_sdi12_bus saved", 200, [&](int){
+            RemoteLogger wake(header, 3, multipliers, "ABC");
+            wake.find_sdi12_bus(bus);
+        });
+        bench("sample_sdi12_bus/found", 200, [&](int){ logger.start_measurement(&msmt); logger.sample_sdi12_bus(bus, &msmt); });
+        logger.clear_sdi12_sensors();
+    }
+
+    /* DS18B20 - three probes one at a time (a conversion and a bus search each) against one chain conversion */
+    {
+        mock::sd_reset();
+        mock::ds18b20_count = 3;
+        OneWire wire(12);
+        DallasTemperature sensors(&wire);
+        RemoteLogger logger(header, 3, multipliers, "ABC");
+        logger.begin();
+        Measurement msmt;
+        float temps[3];
+        bench("sample_DS18B20 x3", 20, [&](int){
+            logger.start_measurement(&msmt);
+            for (int i = 0; i < 3; i++) logger.sample_DS18B20(sensors, i, &msmt);
+        });
+        logger.find_DS18B20_chain(sensors);
+        bench("sample_DS18B20_chain/3", 20, [&](int){ logger.sample_DS18B20_chain(sensors, temps, 3); });
+        mock::ds18b20_count = 1;
+    }
+
+    /* a send wake - the modem powered up after the sampling, against warm_modem powering it up before
+       (a 9 s SDI-12 sensor, and a modem that takes 6 s to find the network) */
+    {
+        mock::sd_reset();
+        mock::sdi12_reset();
+        mock::sdi12_add_sensor('0', "13METER HYDROS21", 9000, "+1034.5+4.62+121");
+        mock::irid_model.success_probability = 1;
+        unsigned long begin_ms = mock::irid_model.begin_ms;
+        mock::irid_model.begin_ms = 6000;
+        SDI12 bus(12);
+        bus.begin();
+        RemoteLogger logger(header, 3, multipliers, "ABC");
+        logger.begin();
+        Measurement msmt;
+        bench("send wake", 5, [&](int){
+            logger.start_measurement(&msmt);
+            logger.sample_hydros_M(bus, 0, &msmt);
+            logger.send_msg("hi");
+        });
+        bench("send wake, warm_modem", 5, [&](int){
+            logger.warm_modem();
+            logger.start_measurement(&msmt);
+            logger.sample_hydros_M(bus, 0, &msmt);
+            logger.send_msg("hi");
+        });
+        mock::irid_sent.clear();
+        mock::irid_model.begin_ms = begin_ms;
+    }
+
+    /* settings */
+    {
+        mock::sd_reset();
+        RemoteLogger logger(header, 3, multipliers, "ABC");
+        logger.begin();
+        bench("apply_params", 1000, [&](int i){ logger.apply_params(i % 2 ? "sample_freq_m,irid_freq_h\n15,4" : "sample_freq_m,irid_freq_h\n30,6"); });
+
+        mock::sd_files["/PARAM.TXT"].clear();
+        const char *param = "sample_freq_m,irid_freq_h\r\n15,4\r\n";
+        mock::sd_files["/PARAM.TXT"].assign(param, param + strlen(param));
+        bench("csv_parser_param", 1000, [&](int){
+            CSV_Parser cp("dd", true, ',');
+            cp.readSDfile("/PARAM.txt");
+            delete[] (int16_t *)cp[0];
+            delete[] (int16_t *)cp[1];
+        });
+    }
+
+    /* decoding archived messages - 10000 messages per call, the way a backfill reads them */
+    {
+        mock::sd_reset();
+        RemoteLogger logger(header, 3, multipliers, "ABC");
+        logger.begin();
+        rl_codec::Schema schema = {"ABC", 3, multipliers};
+
+        int hours[2] = {4, 240};
+        for (int h = 0; h < 2; h++) {
+            fill_hourly(logger, hours[h]);
+            String text = logger.prep_msg();
+            uint8_t buf[OUTBOX_FRAME_BYTES];
+            int len = logger.prep_binary_msg(buf, sizeof(buf));
+
+            std::vector<uint8_t> text_dump, binary_dump;
+            for (int i = 0; i < 10000; i++) {
+                text_dump.push_back(text.length() & 0xFF);
+                text_dump.push_back(text.length() >> 8);
+                text_dump.insert(text_dump.end(), text.c_str(), text.c_str() + text.length());
+                binary_dump.push_back(len & 0xFF);
+                binary_dump.push_back(len >> 8);
+                binary_dump.insert(binary_dump.end(), buf, buf + len);
+            }
+
+            long rows = 0;
+            auto sink = [&](const rl_codec::Message &msg, const rl_codec::Row *){ rows += msg.rows; };
+            char name[64];
+            snprintf(name, sizeof(name), "decode_dump/10000 text %dh", hours[h]);
+            bench(name, 20, [&](int){ rl_codec::decode_dump(text_dump.data(), text_dump.size(), &schema, 1, sink); });
+            snprintf(name, sizeof(name), "decode_dump/10000 binary %dh", hours[h]);
+            bench(name, 20, [&](int){ rl_codec::decode_dump(binary_dump.data(), binary_dump.size(), &schema, 1, sink); });
+        }
+    }
+
+    return 0;
+}
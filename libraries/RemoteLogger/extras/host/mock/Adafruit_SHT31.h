@@ -0,0 +1,24 @@
+/**
+ * host mock of Adafruit_SHT31
+ */
+
+#ifndef ADAFRUIT_SHT31_H
+#define ADAFRUIT_SHT31_H
+
+#include <Arduino.h>
+
+namespace mock {
+    extern float sht31_temp;
+    extern float sht31_rh;
+}
+
+class Adafruit_SHT31 {
+    public:
+        bool begin(uint8_t i2caddr = 0x44) { (void)i2caddr; delay(2); return true; }
+        float readTemperature() { delay(15); return mock::sht31_temp; }
+        float readHumidity() { delay(15); return mock::sht31_rh; }
+        bool readBoth(float *t, float *h) { delay(15); *t = mock::sht31_temp; *h = mock::sht31_rh; return true; }
+        void heater(bool h) { (void)h; }
+};
+
+#endif
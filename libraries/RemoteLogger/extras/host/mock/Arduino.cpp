@@ -0,0 +1,203 @@
+/**
+ * host mock of the Arduino core - see Arduino.h
+ */
+
+#include <Arduino.h>
+
+namespace mock {
+    uint64_t clock_us = 0;
+    int analog_value[32] = {0};
+    int digital_value[32] = {0};
+    unsigned long pulse_us = 5000;
+    void advance_us(uint64_t us){ clock_us += us; }
+
+    static uint64_t carry_ns = 0;
+    void advance_ns(uint64_t ns){
+        carry_ns += ns;
+        clock_us += carry_ns / 1000;
+        carry_ns %= 1000;
+    }
+}
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+
+unsigned long millis(){ return (unsigned long)(mock::clock_us / 1000); }
+unsigned long micros(){ return (unsigned long)mock::clock_us; }
+void delay(unsigned long ms){ mock::clock_us += (uint64_t)ms * 1000; }
+void delayMicroseconds(unsigned int us){ mock::clock_us += us; }
+void pinMode(uint8_t pin, uint8_t mode){ (void)pin; (void)mode; }
+void digitalWrite(uint8_t pin, uint8_t val){ if (pin < 32) mock::digital_value[pin] = val; }
+int digitalRead(uint8_t pin){ return pin < 32 ? mock::digital_value[pin] : 0; }
+int analogRead(uint8_t pin){ mock::clock_us += 10; return pin < 32 ? mock::analog_value[pin] : 0; }
+void analogReadResolution(int bits){ (void)bits; }
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout){
+    (void)pin; (void)state; (void)timeout;
+    mock::clock_us += mock::pulse_us * 2;
+    return mock::pulse_us;
+}
+void attachInterrupt(uint8_t irq, void (*isr)(void), int mode){ (void)irq; (void)isr; (void)mode; }
+void detachInterrupt(uint8_t irq){ (void)irq; }
+void noInterrupts(){}
+void interrupts(){}
+void yield(){}
+
+/* String */
+
+String::String(const char *s) : buf(nullptr), len(0), cap(0) { assign(s, strlen(s)); }
+String::String(const String &s) : buf(nullptr), len(0), cap(0) { assign(s.c_str(), s.len); }
+String::String(char c) : buf(nullptr), len(0), cap(0) { assign(&c, 1); }
+String::String(int v, unsigned char base) : buf(nullptr), len(0), cap(0) {
+    char t[34]; if (base == 16) snprintf(t, sizeof(t), "%x", v); else snprintf(t, sizeof(t), "%d", v); assign(t, strlen(t));
+}
+String::String(unsigned int v, unsigned char base) : buf(nullptr), len(0), cap(0) {
+    char t[34]; snprintf(t, sizeof(t), base == 16 ? "%x" : "%u", v); assign(t, strlen(t));
+}
+String::String(long v, unsigned char base) : buf(nullptr), len(0), cap(0) {
+    char t[34]; snprintf(t, sizeof(t), base == 16 ? "%lx" : "%ld", v); assign(t, strlen(t));
+}
+String::String(unsigned long v, unsigned char base) : buf(nullptr), len(0), cap(0) {
+    char t[34]; snprintf(t, sizeof(t), base == 16 ? "%lx" : "%lu", v); assign(t, strlen(t));
+}
+String::String(float v, unsigned char decimals) : buf(nullptr), len(0), cap(0) {
+    char t[48]; snprintf(t, sizeof(t), "%.*f", decimals, (double)v); assign(t, strlen(t));
+}
+String::String(double v, unsigned char decimals) : buf(nullptr), len(0), cap(0) {
+    char t[48]; snprintf(t, sizeof(t), "%.*f", decimals, v); assign(t, strlen(t));
+}
+String::~String(){ free(buf); }
+
+void String::assign(const char *s, unsigned int n){
+    reserve(n);
+    memmove(buf, s, n);
+    len = n;
+    buf[len] = '\0';
+}
+
+bool String::reserve(unsigned int size){
+    if (buf && cap >= size) return true;
+    char *nb = (char *)realloc(buf, size + 1);
+    if (!nb) return false;
+    if (!buf) nb[0] = '\0';
+    buf = nb;
+    cap = size;
+    return true;
+}
+
+void String::concat(const char *s, unsigned int n){
+    if (len + n > cap) reserve(len + n);
+    memcpy(buf + len, s, n);
+    len += n;
+    buf[len] = '\0';
+}
+
+String &String::operator=(const String &s){ if (this != &s) assign(s.c_str(), s.len); return *this; }
+String &String::operator=(const char *s){ assign(s, strlen(s)); return *this; }
+String &String::operator+=(const String &s){ concat(s.c_str(), s.len); return *this; }
+String &String::operator+=(const char *s){ concat(s, strlen(s)); return *this; }
+String &String::operator+=(char c){ concat(&c, 1); return *this; }
+String &String::operator+=(int v){ return *this += String(v); }
+String &String::operator+=(long v){ return *this += String(v); }
+String &String::operator+=(unsigned long v){ return *this += String(v); }
+String &String::operator+=(float v){ return *this += String(v); }
+String &String::operator+=(double v){ return *this += String(v); }
+bool String::operator==(const String &s) const { return len == s.len && memcmp(c_str(), s.c_str(), len) == 0; }
+bool String::operator==(const char *s) const { return strcmp(c_str(), s) == 0; }
+
+char String::charAt(unsigned int i) const { return i < len ? buf[i] : 0; }
+void String::setCharAt(unsigned int i, char c){ if (i < len) buf[i] = c; }
+String String::substring(unsigned int from) const { return substring(from, len); }
+String String::substring(unsigned int from, unsigned int to) const {
+    if (to > len) to = len;
+    if (from > to) from = to;
+    String out;
+    out.assign(c_str() + from, to - from);
+    return out;
+}
+void String::toCharArray(char *out, unsigned int size, unsigned int index) const {
+    if (!size) return;
+    unsigned int n = (index < len) ? len - index : 0;
+    if (n > size - 1) n = size - 1;
+    memcpy(out, c_str() + index, n);
+    out[n] = '\0';
+}
+int String::indexOf(char c, unsigned int from) const {
+    for (unsigned int i = from; i < len; i++) if (buf[i] == c) return i;
+    return -1;
+}
+int String::indexOf(const char *s, unsigned int from) const {
+    if (from >= len) return -1;
+    const char *p = strstr(c_str() + from, s);
+    return p ? (int)(p - c_str()) : -1;
+}
+long String::toInt() const { return strtol(c_str(), nullptr, 10); }
+float String::toFloat() const { return strtof(c_str(), nullptr); }
+void String::trim(){
+    unsigned int a = 0, b = len;
+    while (a < b && (buf[a] == ' ' || buf[a] == '\r' || buf[a] == '\n' || buf[a] == '\t')) a++;
+    while (b > a && (buf[b-1] == ' ' || buf[b-1] == '\r' || buf[b-1] == '\n' || buf[b-1] == '\t')) b--;
+    String t = substring(a, b);
+    *this = t;
+}
+bool String::startsWith(const char *s) const { return strncmp(c_str(), s, strlen(s)) == 0; }
+
+String operator+(const String &a, const String &b){ String r(a); r += b; return r; }
+String operator+(const String &a, const char *b){ String r(a); r += b; return r; }
+String operator+(const char *a, const String &b){ String r(a); r += b; return r; }
+String operator+(const String &a, char b){ String r(a); r += b; return r; }
+String operator+(const String &a, int b){ String r(a); r += b; return r; }
+String operator+(const String &a, long b){ String r(a); r += b; return r; }
+String operator+(const String &a, unsigned long b){ String r(a); r += b; return r; }
+String operator+(const String &a, float b){ String r(a); r += b; return r; }
+String operator+(const String &a, double b){ String r(a); r += b; return r; }
+
+/* Print / Stream */
+
+size_t Print::write(const uint8_t *data, size_t n){
+    size_t w = 0;
+    while (n--) w += write(*data++);
+    return w;
+}
+size_t Print::print(int v, int base){ return print(String(v, (unsigned char)base)); }
+size_t Print::print(unsigned int v, int base){ return print(String(v, (unsigned char)base)); }
+size_t Print::print(long v, int base){ return print(String(v, (unsigned char)base)); }
+size_t Print::print(unsigned long v, int base){ return print(String(v, (unsigned char)base)); }
+size_t Print::print(double v, int decimals){ return print(String(v, (unsigned char)decimals)); }
+
+size_t Stream::readBytes(char *out, size_t n){
+    size_t got = 0;
+    unsigned long start = millis();
+    while (got < n && millis() - start < timeout) {
+        int c = read();
+        if (c < 0) { delay(1); continue; }
+        out[got++] = (char)c;
+    }
+    return got;
+}
+
+float Stream::parseFloat(){
+    std::string t;
+    unsigned long start = millis();
+    while (millis() - start < timeout) {
+        int c = peek();
+        if (c < 0) { delay(1); continue; }
+        if ((c >= '0' && c <= '9') || c == '.' || c == '-') { t += (char)read(); }
+        else if (t.empty()) { read(); }
+        else break;
+    }
+    return t.empty() ? 0 : strtof(t.c_str(), nullptr);
+}
+
+size_t HardwareSerial::write(uint8_t c){
+    tx += (char)c;
+    if (echo) fputc(c, stdout);
+    return 1;
+}
+int HardwareSerial::available(){ return (int)rx.size(); }
+int HardwareSerial::read(){
+    if (rx.empty()) return -1;
+    int c = (uint8_t)rx[0];
+    rx.erase(0, 1);
+    return c;
+}
+int HardwareSerial::peek(){ return rx.empty() ? -1 : (uint8_t)rx[0]; }
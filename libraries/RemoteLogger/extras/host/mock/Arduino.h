@@ -0,0 +1,187 @@
+/**
+ * host mock of the Arduino core used by RemoteLogger
+ * just enough of String, Print/Stream, timing and pin I/O to build the library on a desktop
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 2
+#define FALLING 3
+#define RISING 4
+#define DEC 10
+#define HEX 16
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+#define F(s) (s)
+#define PROGMEM
+#define digitalPinToInterrupt(p) (p)
+
+/* virtual clock - advanced by delay() and by the mocked peripherals */
+namespace mock {
+    extern uint64_t clock_us;
+    extern int analog_value[32];
+    extern int digital_value[32];
+    extern unsigned long pulse_us;
+    void advance_us(uint64_t us);
+    void advance_ns(uint64_t ns);          // for costs under a microsecond - carried until they add up to one
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogReadResolution(int bits);
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 1000000UL);
+void attachInterrupt(uint8_t irq, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t irq);
+void noInterrupts();
+void interrupts();
+void yield();
+
+template <class T> static inline T constrain_(T x, T a, T b){ return x < a ? a : (x > b ? b : x); }
+#define constrain(x, a, b) constrain_((x), (decltype(x))(a), (decltype(x))(b))
+
+class __FlashStringHelper;
+
+class String {
+    public:
+        String(const char *s = "");
+        String(const String &s);
+        String(char c);
+        String(int v, unsigned char base = 10);
+        String(unsigned int v, unsigned char base = 10);
+        String(long v, unsigned char base = 10);
+        String(unsigned long v, unsigned char base = 10);
+        String(float v, unsigned char decimals = 2);
+        String(double v, unsigned char decimals = 2);
+        ~String();
+
+        String &operator=(const String &s);
+        String &operator=(const char *s);
+        String &operator+=(const String &s);
+        String &operator+=(const char *s);
+        String &operator+=(char c);
+        String &operator+=(int v);
+        String &operator+=(long v);
+        String &operator+=(unsigned long v);
+        String &operator+=(float v);
+        String &operator+=(double v);
+        bool operator==(const String &s) const;
+        bool operator==(const char *s) const;
+        bool operator!=(const String &s) const { return !(*this == s); }
+        bool operator!=(const char *s) const { return !(*this == s); }
+        char operator[](unsigned int i) const { return charAt(i); }
+
+        bool reserve(unsigned int size);
+        unsigned int length() const { return len; }
+        const char *c_str() const { return buf ? buf : ""; }
+        char charAt(unsigned int i) const;
+        void setCharAt(unsigned int i, char c);
+        String substring(unsigned int from) const;
+        String substring(unsigned int from, unsigned int to) const;
+        void toCharArray(char *out, unsigned int size, unsigned int index = 0) const;
+        int indexOf(char c, unsigned int from = 0) const;
+        int indexOf(const char *s, unsigned int from = 0) const;
+        long toInt() const;
+        float toFloat() const;
+        void trim();
+        bool startsWith(const char *s) const;
+        void concat(const char *s, unsigned int n);
+
+    private:
+        void assign(const char *s, unsigned int n);
+        char *buf;
+        unsigned int len;
+        unsigned int cap;
+};
+
+String operator+(const String &a, const String &b);
+String operator+(const String &a, const char *b);
+String operator+(const char *a, const String &b);
+String operator+(const String &a, char b);
+String operator+(const String &a, int b);
+String operator+(const String &a, long b);
+String operator+(const String &a, unsigned long b);
+String operator+(const String &a, float b);
+String operator+(const String &a, double b);
+
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *data, size_t n);
+        size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+        size_t print(const char *s) { return write(s); }
+        size_t print(const String &s) { return write(s.c_str()); }
+        size_t print(char c) { return write((uint8_t)c); }
+        size_t print(int v, int base = DEC);
+        size_t print(unsigned int v, int base = DEC);
+        size_t print(long v, int base = DEC);
+        size_t print(unsigned long v, int base = DEC);
+        size_t print(double v, int decimals = 2);
+        size_t println() { return write("\r\n"); }
+        template <class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+        template <class T> size_t println(T v, int f) { size_t n = print(v, f); return n + println(); }
+        virtual void flush() {}
+};
+
+class Stream : public Print {
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+        size_t readBytes(char *out, size_t n);
+        void setTimeout(unsigned long ms) { timeout = ms; }
+        float parseFloat();
+    protected:
+        unsigned long timeout = 1000;
+};
+
+class HardwareSerial : public Stream {
+    public:
+        void begin(unsigned long baud) { (void)baud; }
+        void end() {}
+        operator bool() const { return true; }
+        size_t write(uint8_t c) override;
+        using Print::write;
+        int available() override;
+        int read() override;
+        int peek() override;
+
+        /* host hooks: bytes queued for read and everything written */
+        std::string rx;
+        std::string tx;
+        bool echo = false;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif
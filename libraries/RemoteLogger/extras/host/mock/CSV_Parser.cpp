@@ -0,0 +1,84 @@
+/**
+ * host mock of michalmonday/CSV-Parser - see CSV_Parser.h
+ */
+
+#include <CSV_Parser.h>
+#include <SD.h>
+
+CSV_Parser::CSV_Parser(const char *fmt, bool has_header, char delimiter)
+    : types(fmt), hasHeader(has_header), delim(delimiter), rows(0) {}
+
+CSV_Parser::~CSV_Parser(){}     // caller owns the column arrays it asked for
+
+static std::vector<std::string> split(const std::string &line, char delim){
+    std::vector<std::string> out;
+    size_t start = 0;
+    for (size_t i = 0; i <= line.size(); i++) {
+        if (i == line.size() || line[i] == delim) {
+            out.push_back(line.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+    return out;
+}
+
+bool CSV_Parser::readSDfile(const char *path){
+    File f = SD.open(path, FILE_READ);
+    if (!f) return false;
+    std::vector<std::vector<std::string> > cells;
+    std::string line;
+    bool first = true;
+    int c;
+    /* read byte by byte like the real parser does over SPI */
+    while ((c = f.read()) >= 0) {
+        if (c == '\r') continue;
+        if (c != '\n') { line += (char)c; continue; }
+        std::vector<std::string> parts = split(line, delim);
+        line.clear();
+        if (first && hasHeader) { names = parts; first = false; continue; }
+        first = false;
+        cells.push_back(parts);
+    }
+    f.close();
+    rows = (int)cells.size();
+    columns.assign(types.size(), nullptr);
+    for (size_t col = 0; col < types.size(); col++) {
+        switch (types[col]) {
+            case 's': {
+                char **v = new char *[rows ? rows : 1];
+                for (int r = 0; r < rows; r++) v[r] = strdup(col < cells[r].size() ? cells[r][col].c_str() : "");
+                columns[col] = v;
+                break;
+            }
+            case 'f': {
+                float *v = new float[rows ? rows : 1];
+                for (int r = 0; r < rows; r++) v[r] = col < cells[r].size() ? strtof(cells[r][col].c_str(), nullptr) : 0;
+                columns[col] = v;
+                break;
+            }
+            case 'd': {
+                int16_t *v = new int16_t[rows ? rows : 1];
+                for (int r = 0; r < rows; r++) v[r] = col < cells[r].size() ? (int16_t)atoi(cells[r][col].c_str()) : 0;
+                columns[col] = v;
+                break;
+            }
+            case 'L': {
+                int32_t *v = new int32_t[rows ? rows : 1];
+                for (int r = 0; r < rows; r++) v[r] = col < cells[r].size() ? (int32_t)atol(cells[r][col].c_str()) : 0;
+                columns[col] = v;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+void *CSV_Parser::operator[](int col){
+    if (col < 0 || (size_t)col >= columns.size()) return nullptr;
+    return columns[col];
+}
+
+void *CSV_Parser::operator[](const char *name){
+    for (size_t i = 0; i < names.size(); i++) if (names[i] == name) return (*this)[(int)i];
+    return nullptr;
+}
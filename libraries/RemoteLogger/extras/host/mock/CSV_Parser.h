@@ -0,0 +1,33 @@
+/**
+ * host mock of michalmonday/CSV-Parser, limited to the column types RemoteLogger uses ('s', 'f', 'd', 'L')
+ * column arrays are handed to the caller the same way the real parser does
+ */
+
+#ifndef CSV_PARSER_H
+#define CSV_PARSER_H
+
+#include <Arduino.h>
+#include <vector>
+#include <string>
+
+class CSV_Parser {
+    public:
+        CSV_Parser(const char *fmt, bool has_header = true, char delimiter = ',');
+        ~CSV_Parser();
+        bool readSDfile(const char *path);
+        int getRowsCount() { return rows; }
+        int getColumnsCount() { return (int)types.size(); }
+        void *operator[](int col);
+        void *operator[](const char *name);
+        void parseLeftover() {}
+
+    private:
+        std::string types;
+        bool hasHeader;
+        char delim;
+        int rows;
+        std::vector<std::string> names;
+        std::vector<void *> columns;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * host mock of DallasTemperature - probes are scripted in mock::ds18b20_temps
+ */
+
+#ifndef DallasTemperature_h
+#define DallasTemperature_h
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+#define DEVICE_DISCONNECTED_C -127
+
+typedef uint8_t DeviceAddress[8];
+
+namespace mock {
+    extern float ds18b20_temps[8];
+    extern uint8_t ds18b20_count;
+    extern unsigned long ds18b20_searches;      // bus enumerations (getAddress/ByIndex)
+    extern unsigned long ds18b20_conversions;
+    extern uint8_t ds18b20_bits[8];             // resolution of each probe
+    extern unsigned long ds18b20_eeprom_writes; // setResolution on a probe (copied to its EEPROM)
+}
+
+class DallasTemperature {
+    public:
+        DallasTemperature() : wire(nullptr) {}
+        DallasTemperature(OneWire *w) : wire(w) {}
+        void begin();
+        uint8_t getDeviceCount() { return mock::ds18b20_count; }
+        bool getAddress(uint8_t *address, uint8_t index);
+        bool isConnected(const uint8_t *address) { return address[1] < mock::ds18b20_count; }
+        bool setResolution(const uint8_t *address, uint8_t bits, bool skipGlobal = false);
+        void setResolution(uint8_t bits) { res = bits; }
+        uint8_t getResolution() { return res; }
+        uint8_t getResolution(const uint8_t *address) { return address[1] < mock::ds18b20_count ? mock::ds18b20_bits[address[1]] : 0; }
+        void setWaitForConversion(bool wait) { waitForConversion = wait; }
+        bool getWaitForConversion() { return waitForConversion; }
+        void requestTemperatures();
+        bool requestTemperaturesByAddress(const uint8_t *address) { (void)address; requestTemperatures(); return true; }
+        bool isConversionComplete() { return mock::clock_us >= conversionDone; }
+        int16_t millisToWaitForConversion(uint8_t bits) { return bits >= 12 ? 750 : bits == 11 ? 375 : bits == 10 ? 188 : 94; }
+        float getTempC(const uint8_t *address);
+        float getTempCByIndex(uint8_t index);
+
+    private:
+        OneWire *wire;
+        uint8_t res = 9;                // the library's default until begin() reads the probes
+        bool waitForConversion = true;
+        uint64_t conversionDone = 0;
+        uint64_t conversionStart = 0;
+        bool converted = false;
+};
+
+#endif
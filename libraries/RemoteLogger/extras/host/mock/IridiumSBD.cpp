@@ -0,0 +1,117 @@
+/**
+ * host mock of the IridiumSBD library - see IridiumSBD.h
+ */
+
+#include <IridiumSBD.h>
+#include <RTClib.h>
+
+namespace mock {
+    IridiumModel irid_model = {1500, 20000, 3, 0.8, true};
+    std::vector<std::string> irid_sent;
+    std::deque<std::string> irid_mt_queue;
+    unsigned long irid_attempts = 0;
+    unsigned long irid_begins = 0;
+    unsigned long irid_random_state = 12345;
+
+    void irid_reset(){
+        irid_sent.clear();
+        irid_mt_queue.clear();
+        irid_attempts = 0;
+        irid_begins = 0;
+    }
+
+    static double irid_random(){
+        irid_random_state = irid_random_state * 1103515245UL + 12345UL;
+        return ((irid_random_state >> 8) & 0xffffff) / (double)0x1000000;
+    }
+}
+
+IridiumSBD::IridiumSBD(Stream &str, int sleepPinNo, int ringPinNo)
+    : stream(str), sleepPin(sleepPinNo), asleep(true), waiting(0), sendReceiveTimeout(300) { (void)ringPinNo; }
+
+/* long operations call ISBDCallback every few ms like the real library */
+bool IridiumSBD::wait(unsigned long ms){
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        unsigned long before = millis();
+        if (ISBDCallback != NULL && !ISBDCallback()) return false;
+        if (millis() == before) delay(10);
+    }
+    return true;
+}
+
+int IridiumSBD::begin(){
+    mock::irid_begins++;
+    if (!mock::irid_model.present) { wait(240 * 1000UL / 100); return ISBD_NO_MODEM_DETECTED; }
+    if (!wait(mock::irid_model.begin_ms)) return ISBD_CANCELLED;
+    bool wasAsleep = asleep;
+    asleep = false;
+    return wasAsleep ? ISBD_SUCCESS : ISBD_ALREADY_AWAKE;
+}
+
+int IridiumSBD::session(const uint8_t *tx, size_t txSize, uint8_t *rx, size_t *rxSize){
+    if (asleep) return ISBD_IS_ASLEEP;
+    if (txSize > 340) return ISBD_MSG_TOO_LONG;
+    mock::irid_attempts++;
+    if (!wait(mock::irid_model.send_ms)) return ISBD_CANCELLED;
+    double p = mock::irid_model.success_probability;
+    if (mock::irid_model.signal_quality == 0 || mock::irid_random() > p) return ISBD_SENDRECEIVE_TIMEOUT;
+    if (txSize > 0) mock::irid_sent.push_back(std::string((const char *)tx, txSize));
+    if (rxSize) {
+        if (!mock::irid_mt_queue.empty()) {
+            std::string mt = mock::irid_mt_queue.front();
+            mock::irid_mt_queue.pop_front();
+            if (mt.size() > *rxSize) return ISBD_RX_OVERFLOW;
+            memcpy(rx, mt.data(), mt.size());
+            *rxSize = mt.size();
+        } else {
+            *rxSize = 0;
+        }
+    }
+    return ISBD_SUCCESS;
+}
+
+int IridiumSBD::sendSBDText(const char *message){ return session((const uint8_t *)message, strlen(message), nullptr, nullptr); }
+int IridiumSBD::sendSBDBinary(const uint8_t *txData, size_t txDataSize){ return session(txData, txDataSize, nullptr, nullptr); }
+int IridiumSBD::sendReceiveSBDText(const char *message, uint8_t *rxBuffer, size_t &rxBufferSize){
+    return session((const uint8_t *)message, message ? strlen(message) : 0, rxBuffer, &rxBufferSize);
+}
+int IridiumSBD::sendReceiveSBDBinary(const uint8_t *txData, size_t txDataSize, uint8_t *rxBuffer, size_t &rxBufferSize){
+    return session(txData, txDataSize, rxBuffer, &rxBufferSize);
+}
+
+int IridiumSBD::getSignalQuality(int &quality){
+    if (asleep) return ISBD_IS_ASLEEP;
+    delay(50);
+    quality = mock::irid_model.signal_quality;
+    return ISBD_SUCCESS;
+}
+
+int IridiumSBD::getWaitingMessageCount(){ return (int)mock::irid_mt_queue.size(); }
+
+int IridiumSBD::getSystemTime(struct tm &tm){
+    if (asleep) return ISBD_IS_ASLEEP;
+    delay(50);
+    RTC_PCF8523 truth;
+    DateTime now = truth.now();
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year = now.year() - 1900;
+    tm.tm_mon = now.month() - 1;
+    tm.tm_mday = now.day();
+    tm.tm_hour = now.hour();
+    tm.tm_min = now.minute();
+    tm.tm_sec = now.second();
+    return ISBD_SUCCESS;
+}
+
+int IridiumSBD::getFirmwareVersion(char *version, size_t bufferSize){
+    if (asleep) return ISBD_IS_ASLEEP;
+    snprintf(version, bufferSize, "TA16005");
+    return ISBD_SUCCESS;
+}
+
+int IridiumSBD::sleep(){
+    if (asleep) return ISBD_IS_ASLEEP;
+    asleep = true;
+    return ISBD_SUCCESS;
+}
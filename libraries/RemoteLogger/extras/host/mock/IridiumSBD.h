@@ -0,0 +1,87 @@
+/**
+ * host mock of the IridiumSBD library (RockBLOCK 9603)
+ * sends are recorded in mock::irid_sent; outcome and timing follow mock::irid_model
+ */
+
+#ifndef IridiumSBD_h
+#define IridiumSBD_h
+
+#include <Arduino.h>
+#include <time.h>
+#include <vector>
+#include <string>
+#include <deque>
+
+#define ISBD_SUCCESS 0
+#define ISBD_ALREADY_AWAKE 1
+#define ISBD_SERIAL_FAILURE 2
+#define ISBD_PROTOCOL_ERROR 3
+#define ISBD_CANCELLED 4
+#define ISBD_NO_MODEM_DETECTED 5
+#define ISBD_SBDIX_FATAL_ERROR 6
+#define ISBD_SENDRECEIVE_TIMEOUT 7
+#define ISBD_RX_OVERFLOW 8
+#define ISBD_REENTRANT 9
+#define ISBD_IS_ASLEEP 10
+#define ISBD_NO_SLEEP_PIN 11
+#define ISBD_NO_NETWORK 12
+#define ISBD_MSG_TOO_LONG 13
+
+#define ISBD_CLEAR_MO 0
+#define ISBD_CLEAR_MT 1
+#define ISBD_CLEAR_BOTH 2
+
+namespace mock {
+    struct IridiumModel {
+        unsigned long begin_ms;         // power-up to first AT response
+        unsigned long send_ms;          // one SBDIX session
+        int signal_quality;             // 0..5 reported by getSignalQuality
+        double success_probability;     // chance one SBDIX session succeeds
+        bool present;                   // false -> ISBD_NO_MODEM_DETECTED
+    };
+    extern IridiumModel irid_model;
+    extern std::vector<std::string> irid_sent;          // every successful MO payload
+    extern std::deque<std::string> irid_mt_queue;       // MT messages waiting at the gateway
+    extern unsigned long irid_attempts;
+    extern unsigned long irid_begins;
+    extern unsigned long irid_random_state;
+    void irid_reset();
+}
+
+bool ISBDCallback() __attribute__((weak));      // defined by the sketch (or RemoteLogger), as in the real library
+
+class IridiumSBD {
+    public:
+        enum POWERPROFILE { DEFAULT_POWER_PROFILE = 0, USB_POWER_PROFILE = 1 };
+
+        IridiumSBD(Stream &str, int sleepPinNo = -1, int ringPinNo = -1);
+        int begin();
+        int sendSBDText(const char *message);
+        int sendSBDBinary(const uint8_t *txData, size_t txDataSize);
+        int sendReceiveSBDText(const char *message, uint8_t *rxBuffer, size_t &rxBufferSize);
+        int sendReceiveSBDBinary(const uint8_t *txData, size_t txDataSize, uint8_t *rxBuffer, size_t &rxBufferSize);
+        int getSignalQuality(int &quality);
+        int getWaitingMessageCount();
+        int getSystemTime(struct tm &tm);
+        int getFirmwareVersion(char *version, size_t bufferSize);
+        int sleep();
+        bool isAsleep() { return asleep; }
+        void setPowerProfile(POWERPROFILE profile) { (void)profile; }
+        void adjustATTimeout(int seconds) { (void)seconds; }
+        void adjustSendReceiveTimeout(int seconds) { sendReceiveTimeout = seconds; }
+        void useMSSTMWorkaround(bool use) { (void)use; }
+        void enableRingAlerts(bool enable) { (void)enable; }
+        bool hasRingAsserted() { return false; }
+        int clearBuffers(int buffers = ISBD_CLEAR_MO) { (void)buffers; return ISBD_SUCCESS; }
+
+    private:
+        int session(const uint8_t *tx, size_t txSize, uint8_t *rx, size_t *rxSize);
+        bool wait(unsigned long ms);
+        Stream &stream;
+        int sleepPin;
+        bool asleep;
+        int waiting;
+        int sendReceiveTimeout;
+};
+
+#endif
@@ -0,0 +1,10 @@
+/**
+ * host mock of the MemoryFree library
+ */
+
+#ifndef MEMORY_FREE_H
+#define MEMORY_FREE_H
+
+int freeMemory();
+
+#endif
@@ -0,0 +1,18 @@
+/**
+ * host mock of the OneWire library
+ */
+
+#ifndef OneWire_h
+#define OneWire_h
+
+#include <Arduino.h>
+
+class OneWire {
+    public:
+        OneWire(uint8_t pin = 0) : pin(pin) {}
+        uint8_t reset() { return 1; }
+        void reset_search() {}
+        uint8_t pin;
+};
+
+#endif
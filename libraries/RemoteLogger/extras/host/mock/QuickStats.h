@@ -0,0 +1,22 @@
+/**
+ * host mock of the QuickStats library (median, minimum, average)
+ */
+
+#ifndef QuickStats_h
+#define QuickStats_h
+
+#include <Arduino.h>
+
+class QuickStats {
+    public:
+        float average(float samples[], int m){ float s = 0; for (int i = 0; i < m; i++) s += samples[i]; return m ? s / m : 0; }
+        float minimum(float samples[], int m){ float v = samples[0]; for (int i = 1; i < m; i++) if (samples[i] < v) v = samples[i]; return v; }
+        float maximum(float samples[], int m){ float v = samples[0]; for (int i = 1; i < m; i++) if (samples[i] > v) v = samples[i]; return v; }
+        float median(float samples[], int m){
+            /* the real library bubble sorts in place */
+            for (int i = 1; i < m; i++) for (int j = 0; j < m - i; j++) if (samples[j] > samples[j+1]) { float t = samples[j]; samples[j] = samples[j+1]; samples[j+1] = t; }
+            return (m % 2) ? samples[m / 2] : (samples[m / 2 - 1] + samples[m / 2]) / 2;
+        }
+};
+
+#endif
@@ -0,0 +1,82 @@
+/**
+ * host mock of Adafruit RTClib - date arithmetic copied in spirit from the real library
+ */
+
+#include <RTClib.h>
+
+namespace mock {
+    uint32_t rtc_base_unix = 1704067200UL;      // 2024-01-01T00:00:00
+    uint32_t countdown_secs = 0;
+}
+
+static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
+
+static uint16_t date2days(uint16_t y, uint8_t m, uint8_t d){
+    if (y >= 2000U) y -= 2000U;
+    uint16_t days = d;
+    for (uint8_t i = 1; i < m; ++i) days += daysInMonth[i - 1];
+    if (m > 2 && y % 4 == 0) ++days;
+    return days + 365 * y + (y + 3) / 4 - 1;
+}
+
+DateTime::DateTime(uint32_t t){
+    t -= SECONDS_FROM_1970_TO_2000;
+    ss = t % 60; t /= 60;
+    mm = t % 60; t /= 60;
+    hh = t % 24;
+    uint16_t days = t / 24;
+    uint8_t leap;
+    for (yOff = 0;; ++yOff) {
+        leap = yOff % 4 == 0;
+        if (days < 365U + leap) break;
+        days -= 365 + leap;
+    }
+    for (m = 1; m < 12; ++m) {
+        uint8_t daysPerMonth = daysInMonth[m - 1];
+        if (leap && m == 2) ++daysPerMonth;
+        if (days < daysPerMonth) break;
+        days -= daysPerMonth;
+    }
+    d = days + 1;
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec){
+    if (year >= 2000U) year -= 2000U;
+    yOff = year; m = month; d = day; hh = hour; mm = min; ss = sec;
+}
+
+uint8_t DateTime::dayOfTheWeek() const {
+    uint16_t day = date2days(yOff, m, d);
+    return (day + 6) % 7;
+}
+
+uint32_t DateTime::unixtime() const {
+    uint16_t days = date2days(yOff, m, d);
+    return ((uint32_t)days * 24 + hh) * 3600 + (uint32_t)mm * 60 + ss + SECONDS_FROM_1970_TO_2000;
+}
+
+String DateTime::timestamp(timestampOpt opt) const {
+    char buffer[25];
+    switch (opt) {
+        case TIMESTAMP_TIME: snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", hh, mm, ss); break;
+        case TIMESTAMP_DATE: snprintf(buffer, sizeof(buffer), "%u-%02d-%02d", 2000U + yOff, m, d); break;
+        default: snprintf(buffer, sizeof(buffer), "%u-%02d-%02dT%02d:%02d:%02d", 2000U + yOff, m, d, hh, mm, ss);
+    }
+    return String(buffer);
+}
+
+void RTC_PCF8523::adjust(const DateTime &dt){
+    mock::rtc_base_unix = dt.unixtime() - (uint32_t)(mock::clock_us / 1000000ULL);
+}
+
+DateTime RTC_PCF8523::now(){
+    return DateTime(mock::rtc_base_unix + (uint32_t)(mock::clock_us / 1000000ULL));
+}
+
+void RTC_PCF8523::enableCountdownTimer(PCF8523TimerClockFreq clkFreq, uint8_t numPeriods, uint8_t lowPulseWidth){
+    (void)lowPulseWidth;
+    uint32_t unit = clkFreq == PCF8523_FrequencyHour ? 3600 : clkFreq == PCF8523_FrequencyMinute ? 60 : 1;
+    mock::countdown_secs = unit * numPeriods;
+}
+
+void RTC_PCF8523::disableCountdownTimer(){ mock::countdown_secs = 0; }
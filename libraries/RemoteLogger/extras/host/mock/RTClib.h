@@ -0,0 +1,81 @@
+/**
+ * host mock of Adafruit RTClib (DateTime, TimeSpan, RTC_PCF8523)
+ * the PCF8523 runs off the mocked virtual clock from a settable base time
+ */
+
+#ifndef RTClib_h
+#define RTClib_h
+
+#include <Arduino.h>
+
+#define SECONDS_FROM_1970_TO_2000 946684800
+
+class TimeSpan {
+    public:
+        TimeSpan(int32_t seconds = 0) : _seconds(seconds) {}
+        TimeSpan(int16_t days, int8_t hours, int8_t minutes, int8_t seconds)
+            : _seconds((int32_t)days * 86400L + (int32_t)hours * 3600 + (int32_t)minutes * 60 + seconds) {}
+        int32_t totalseconds() const { return _seconds; }
+    private:
+        int32_t _seconds;
+};
+
+class DateTime {
+    public:
+        DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
+        DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0);
+        uint16_t year() const { return 2000U + yOff; }
+        uint8_t month() const { return m; }
+        uint8_t day() const { return d; }
+        uint8_t hour() const { return hh; }
+        uint8_t minute() const { return mm; }
+        uint8_t second() const { return ss; }
+        uint8_t dayOfTheWeek() const;
+        uint32_t unixtime() const;
+        uint32_t secondstime() const { return unixtime() - SECONDS_FROM_1970_TO_2000; }
+        bool isValid() const { return yOff < 100 && m >= 1 && m <= 12 && d >= 1 && d <= 31; }
+
+        enum timestampOpt { TIMESTAMP_FULL, TIMESTAMP_TIME, TIMESTAMP_DATE };
+        String timestamp(timestampOpt opt = TIMESTAMP_FULL) const;
+
+        DateTime operator+(const TimeSpan &span) const { return DateTime(unixtime() + span.totalseconds()); }
+        DateTime operator-(const TimeSpan &span) const { return DateTime(unixtime() - span.totalseconds()); }
+        TimeSpan operator-(const DateTime &right) const { return TimeSpan((int32_t)(unixtime() - right.unixtime())); }
+        bool operator<(const DateTime &right) const { return unixtime() < right.unixtime(); }
+        bool operator==(const DateTime &right) const { return unixtime() == right.unixtime(); }
+
+    protected:
+        uint8_t yOff, m, d, hh, mm, ss;
+};
+
+enum PCF8523TimerClockFreq {
+    PCF8523_Frequency4kHz = 0,
+    PCF8523_Frequency64Hz = 1,
+    PCF8523_FrequencySecond = 2,
+    PCF8523_FrequencyMinute = 3,
+    PCF8523_FrequencyHour = 4,
+};
+
+enum PCF8523SqwPinMode { PCF8523_OFF = 7 };
+
+class RTC_PCF8523 {
+    public:
+        bool begin() { return true; }
+        void adjust(const DateTime &dt);
+        DateTime now();
+        bool lostPower() { return false; }
+        bool initialized() { return true; }
+        void start() {}
+        void stop() {}
+        void enableCountdownTimer(PCF8523TimerClockFreq clkFreq, uint8_t numPeriods, uint8_t lowPulseWidth = 0);
+        void disableCountdownTimer();
+        void deconfigureAllTimers() { disableCountdownTimer(); }
+        void writeSqwPinMode(PCF8523SqwPinMode mode) { (void)mode; }
+};
+
+namespace mock {
+    extern uint32_t rtc_base_unix;          // RTC time at virtual clock zero
+    extern uint32_t countdown_secs;         // countdown timer armed last, in seconds (0 = off)
+}
+
+#endif
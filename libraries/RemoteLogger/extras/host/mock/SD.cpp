@@ -0,0 +1,175 @@
+/**
+ * host mock of the Arduino SD library - see SD.h
+ */
+
+#include <SD.h>
+
+#define SD_READ_CALL_NS 1500        // rough cost of one read() call on the SAMD21 - cache lookup and the checks
+#define SD_READ_BYTE_NS 500         // and of each byte, SPI at 12 MHz with the block reads spread over it
+
+namespace mock {
+    SDStats sd_stats;
+    std::map<std::string, std::vector<uint8_t> > sd_files;
+    static std::map<std::string, bool> sd_dirs;
+
+    long sd_bytes_to_cut = -1;
+    bool sd_powered = true;
+    std::string sd_fail_open;
+
+    void sd_reset(){
+        sd_files.clear();
+        sd_dirs.clear();
+        memset(&sd_stats, 0, sizeof(sd_stats));
+        sd_power_on();
+    }
+
+    void sd_cut_after(long bytes){ sd_bytes_to_cut = bytes; }
+
+    void sd_power_on(){
+        sd_bytes_to_cut = -1;
+        sd_powered = true;
+        sd_fail_open.clear();
+    }
+
+    /* SD paths are case-insensitive 8.3 names */
+    static std::string norm(const std::string &p){
+        std::string out = (p.empty() || p[0] != '/') ? "/" + p : p;
+        for (size_t i = 0; i < out.size(); i++) out[i] = (char)toupper((unsigned char)out[i]);
+        return out;
+    }
+}
+
+SDClass SD;
+
+File::File(const std::string &p, uint8_t m, bool dir) : path(p), mode(m), pos(0), open_(true), dir_(dir) {
+    shortname[0] = '\0';
+}
+
+size_t File::write(uint8_t c){ return write(&c, 1); }
+
+size_t File::write(const uint8_t *data, size_t n){
+    if (!open_ || !(mode & O_WRITE) || !mock::sd_powered) return 0;
+    if (mock::sd_bytes_to_cut >= 0 && (long)n >= mock::sd_bytes_to_cut) {
+        n = mock::sd_bytes_to_cut;          // the power goes part way through
+        mock::sd_powered = false;
+    } else if (mock::sd_bytes_to_cut >= 0) {
+        mock::sd_bytes_to_cut -= n;
+    }
+    std::vector<uint8_t> &f = mock::sd_files[path];
+    if (mode & O_APPEND) pos = f.size();
+    if (pos + n > f.size()) f.resize(pos + n);
+    memcpy(&f[pos], data, n);
+    pos += n;
+    mock::sd_stats.bytes_written += n;
+    mock::sd_stats.write_calls++;
+    mock::advance_us(200 + n);          // rough SPI cost
+    return n;
+}
+
+int File::available(){
+    if (!open_) return 0;
+    return (int)(mock::sd_files[path].size() - pos);
+}
+
+int File::read(){
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek(){
+    if (!open_) return -1;
+    std::vector<uint8_t> &f = mock::sd_files[path];
+    return pos < f.size() ? f[pos] : -1;
+}
+
+int File::read(void *buf, uint16_t n){
+    if (!open_) return -1;
+    std::vector<uint8_t> &f = mock::sd_files[path];
+    if (pos >= f.size()) return 0;
+    size_t k = f.size() - pos;
+    if (k > n) k = n;
+    memcpy(buf, &f[pos], k);
+    pos += k;
+    mock::sd_stats.bytes_read += k;
+    mock::advance_ns(SD_READ_CALL_NS + k * SD_READ_BYTE_NS);       // so a byte at a time (CSV_Parser) costs what it does
+    return (int)k;
+}
+
+bool File::seek(uint32_t p){
+    if (!open_) return false;
+    mock::sd_stats.seeks++;
+    if (p > mock::sd_files[path].size()) return false;
+    pos = p;
+    return true;
+}
+
+uint32_t File::size(){ return open_ ? (uint32_t)mock::sd_files[path].size() : 0; }
+
+void File::close(){
+    if (open_) mock::sd_stats.closes++;
+    open_ = false;
+}
+
+char *File::name(){
+    size_t slash = path.find_last_of('/');
+    std::string base = path.substr(slash + 1);
+    strncpy(shortname, base.c_str(), 12);
+    shortname[12] = '\0';
+    return shortname;
+}
+
+File File::openNextFile(uint8_t m){
+    std::string prefix = path == "/" ? "/" : path + "/";
+    size_t i = 0;
+    for (std::map<std::string, std::vector<uint8_t> >::iterator it = mock::sd_files.begin(); it != mock::sd_files.end(); ++it) {
+        if (it->first.compare(0, prefix.size(), prefix) != 0) continue;
+        if (it->first.find('/', prefix.size()) != std::string::npos) continue;
+        if (i++ == dir_index) {
+            dir_index++;
+            return File(it->first, m);
+        }
+    }
+    return File();
+}
+
+bool SDClass::begin(uint8_t cs){
+    (void)cs;
+    mock::sd_stats.begins++;
+    mock::advance_us(20000);
+    return true;
+}
+
+bool SDClass::exists(const char *p){
+    mock::sd_stats.exists++;
+    std::string n = mock::norm(p);
+    return mock::sd_files.count(n) || mock::sd_dirs.count(n);
+}
+
+File SDClass::open(const char *p, uint8_t mode){
+    mock::sd_stats.opens++;
+    mock::advance_us(2000);
+    std::string n = mock::norm(p);
+    if (!mock::sd_powered || n == mock::sd_fail_open) return File();
+    if (n == "/" || mock::sd_dirs.count(n)) return File(n, mode, true);
+    if (!mock::sd_files.count(n)) {
+        if (!(mode & O_CREAT)) return File();
+        mock::sd_files[n];
+    }
+    if (mode & O_TRUNC) mock::sd_files[n].clear();
+    File f(n, mode);
+    if (mode & O_APPEND) f.seek(mock::sd_files[n].size());
+    return f;
+}
+
+bool SDClass::remove(const char *p){
+    return mock::sd_files.erase(mock::norm(p)) > 0;
+}
+
+bool SDClass::mkdir(const char *p){
+    mock::sd_dirs[mock::norm(p)] = true;
+    return true;
+}
+
+bool SDClass::rmdir(const char *p){
+    return mock::sd_dirs.erase(mock::norm(p)) > 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * host mock of the Arduino SD library
+ * files live in memory; every call is counted so benchmarks can report SD traffic
+ */
+
+#ifndef SD_h
+#define SD_h
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+#include <string>
+
+#define O_READ 0x01
+#define O_RDONLY O_READ
+#define O_WRITE 0x02
+#define O_WRONLY O_WRITE
+#define O_RDWR (O_READ | O_WRITE)
+#define O_APPEND 0x04
+#define O_SYNC 0x08
+#define O_TRUNC 0x10
+#define O_CREAT 0x20
+#define O_EXCL 0x40
+
+#define FILE_READ O_READ
+#define FILE_WRITE (O_READ | O_WRITE | O_CREAT | O_APPEND)
+
+namespace mock {
+    struct SDStats {
+        unsigned long opens;
+        unsigned long exists;
+        unsigned long closes;
+        unsigned long bytes_read;
+        unsigned long bytes_written;
+        unsigned long write_calls;
+        unsigned long seeks;
+        unsigned long begins;
+    };
+    extern SDStats sd_stats;
+    extern std::map<std::string, std::vector<uint8_t> > sd_files;
+    void sd_reset();
+
+    // faults, for the recovery tests: the power cut part way through a write, or a file that won't open
+    extern long sd_bytes_to_cut;            // bytes written before the power goes, -1 for never
+    extern bool sd_powered;                 // false once cut - every open and write fails until sd_power_on
+    extern std::string sd_fail_open;        // path whose opens fail ("/OUTBOX.BIN"), "" for none
+    void sd_cut_after(long bytes);
+    void sd_power_on();
+}
+
+class File : public Stream {
+    public:
+        File() {}
+        File(const std::string &path, uint8_t mode, bool dir = false);
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t *data, size_t n) override;
+        using Print::write;
+        int available() override;
+        int read() override;
+        int peek() override;
+        int read(void *buf, uint16_t n);
+        bool seek(uint32_t pos);
+        uint32_t position() { return pos; }
+        uint32_t size();
+        void flush() override {}
+        void close();
+        operator bool() const { return open_; }
+        char *name();
+        bool isDirectory() { return dir_; }
+        File openNextFile(uint8_t mode = O_READ);
+        void rewindDirectory() { dir_index = 0; }
+
+    private:
+        std::string path;
+        uint8_t mode = 0;
+        uint32_t pos = 0;
+        bool open_ = false;
+        bool dir_ = false;
+        size_t dir_index = 0;
+        char shortname[13];
+};
+
+class SDClass {
+    public:
+        bool begin(uint8_t cs = 4);
+        bool exists(const char *path);
+        bool exists(const String &path) { return exists(path.c_str()); }
+        File open(const char *path, uint8_t mode = FILE_READ);
+        File open(const String &path, uint8_t mode = FILE_READ) { return open(path.c_str(), mode); }
+        bool remove(const char *path);
+        bool remove(const String &path) { return remove(path.c_str()); }
+        bool mkdir(const char *path);
+        bool rmdir(const char *path);
+};
+
+extern SDClass SD;
+
+#endif
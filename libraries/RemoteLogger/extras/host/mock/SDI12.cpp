@@ -0,0 +1,145 @@
+/**
+ * host mock of the EnviroDIY Arduino-SDI-12 library - see SDI12.h
+ */
+
+#include <SDI12.h>
+
+#define SDI12_CHAR_US 8333UL        // one character at 1200 baud
+#define SDI12_REPLY_US 15000UL      // marking + sensor turnaround after a command
+
+namespace mock {
+    std::map<char, SDI12Sensor> sdi12_sensors;
+    unsigned long sdi12_commands = 0;
+
+    void sdi12_add_sensor(char address, const std::string &identity, unsigned long measure_ms,
+                          const std::string &m_values, const std::string &v_values){
+        SDI12Sensor s;
+        s.identity = identity;
+        s.measure_ms = measure_ms;
+        s.m_values = m_values;
+        s.v_values = v_values;
+        s.measuring = false;
+        s.ready_us = 0;
+        sdi12_sensors[address] = s;
+    }
+
+    void sdi12_reset(){ sdi12_sensors.clear(); sdi12_commands = 0; }
+}
+
+SDI12::SDI12() : pin(-1) {}
+SDI12::SDI12(int8_t dataPin) : pin(dataPin) {}
+void SDI12::begin() {}
+void SDI12::end() {}
+
+void SDI12::queue(const std::string &reply, unsigned long delay_us){
+    uint64_t t = mock::clock_us + delay_us;
+    for (size_t i = 0; i < reply.size(); i++) {
+        t += SDI12_CHAR_US;
+        insert(reply[i], t);
+    }
+}
+
+/* keep the receive queue in arrival order (service requests are scheduled ahead of time) */
+void SDI12::insert(char c, uint64_t at){
+    Byte b = {c, at};
+    std::deque<Byte>::iterator it = rx.end();
+    while (it != rx.begin() && (it - 1)->at > at) --it;
+    rx.insert(it, b);
+}
+
+void SDI12::sendCommand(String &cmd, int8_t extraWakeTime){ sendCommand(cmd.c_str(), extraWakeTime); }
+
+/* values are split across D0..D9 so no single reply exceeds the SDI-12 limit */
+static std::string data_frame(const std::string &values, int index, size_t limit){
+    std::string frame;
+    int current = 0;
+    size_t i = 0;
+    while (i < values.size()) {
+        size_t j = i + 1;
+        while (j < values.size() && values[j] != '+' && values[j] != '-') j++;
+        std::string v = values.substr(i, j - i);
+        if (frame.size() + v.size() > limit) { current++; frame = ""; }
+        if (current == index) frame += v;
+        else if (current > index) break;
+        i = j;
+    }
+    return current >= index ? frame : "";
+}
+
+void SDI12::sendCommand(const char *cmd, int8_t extraWakeTime){
+    (void)extraWakeTime;
+    mock::sdi12_commands++;
+    mock::advance_us(12000 + strlen(cmd) * SDI12_CHAR_US);     // break + marking + command
+    std::string c(cmd);
+    if (c == "?!") {
+        if (!mock::sdi12_sensors.empty()) queue(std::string(1, mock::sdi12_sensors.begin()->first) + "\r\n", SDI12_REPLY_US);
+        return;
+    }
+    if (c.size() < 2 || c[c.size() - 1] != '!') return;
+    char a = c[0];
+    std::map<char, mock::SDI12Sensor>::iterator it = mock::sdi12_sensors.find(a);
+    if (it == mock::sdi12_sensors.end()) return;        // nobody home - no reply
+    mock::SDI12Sensor &s = it->second;
+    std::string op = c.substr(1, c.size() - 2);
+    std::string addr(1, a);
+    char ttt[24];
+    // stated time covers the sensor's whole measurement, counted from the end of the command
+    unsigned long total_ms = (SDI12_REPLY_US + 8 * SDI12_CHAR_US) / 1000 + s.measure_ms;
+    snprintf(ttt, sizeof(ttt), "%03lu", (total_ms + 999) / 1000);
+
+    if (op.empty()) {
+        queue(addr + "\r\n", SDI12_REPLY_US);
+    } else if (op == "I") {
+        queue(addr + s.identity + "\r\n", SDI12_REPLY_US);
+    } else if (op[0] == 'A' && op.size() == 2) {
+        mock::SDI12Sensor moved = s;
+        mock::sdi12_sensors.erase(it);
+        mock::sdi12_sensors[op[1]] = moved;
+        queue(std::string(1, op[1]) + "\r\n", SDI12_REPLY_US);
+    } else if (op == "M" || op == "V" || op == "C") {
+        const std::string &vals = (op == "V") ? s.v_values : s.m_values;
+        int n = 0;
+        for (size_t i = 0; i < vals.size(); i++) if (vals[i] == '+' || vals[i] == '-') n++;
+        s.pending = vals;
+        s.measuring = true;
+        s.ready_us = mock::clock_us + SDI12_REPLY_US + 8 * SDI12_CHAR_US + s.measure_ms * 1000UL;
+        char count[4];
+        snprintf(count, sizeof(count), op == "C" ? "%02d" : "%d", n);
+        queue(addr + ttt + count + "\r\n", SDI12_REPLY_US);
+        if (op != "C") {        // service request when the measurement completes
+            uint64_t t = s.ready_us;
+            insert(a, t);
+            insert('\r', t + SDI12_CHAR_US);
+            insert('\n', t + 2 * SDI12_CHAR_US);
+        }
+    } else if (op[0] == 'D' && op.size() == 2) {
+        if (s.measuring && mock::clock_us < s.ready_us) {
+            queue(addr + "\r\n", SDI12_REPLY_US);       // nothing ready yet
+            return;
+        }
+        s.measuring = false;
+        queue(addr + data_frame(s.pending, op[1] - '0', 33) + "\r\n", SDI12_REPLY_US);
+    }
+}
+
+int SDI12::available(){
+    int n = 0;
+    for (size_t i = 0; i < rx.size() && rx[i].at <= mock::clock_us; i++) n++;
+    return n;
+}
+
+int SDI12::read(){
+    if (available() == 0) return -1;
+    char c = rx.front().c;
+    rx.pop_front();
+    return (uint8_t)c;
+}
+
+int SDI12::peek(){
+    if (available() == 0) return -1;
+    return (uint8_t)rx.front().c;
+}
+
+void SDI12::clearBuffer(){
+    while (!rx.empty() && rx.front().at <= mock::clock_us) rx.pop_front();
+}
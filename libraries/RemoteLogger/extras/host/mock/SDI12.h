@@ -0,0 +1,59 @@
+/**
+ * host mock of the EnviroDIY Arduino-SDI-12 library
+ * sensors on the bus are scripted with mock::sdi12_add_sensor; replies arrive at 1200 baud on the virtual clock
+ */
+
+#ifndef SDI12_h
+#define SDI12_h
+
+#include <Arduino.h>
+#include <map>
+#include <deque>
+#include <string>
+
+namespace mock {
+    struct SDI12Sensor {
+        std::string identity;       // aI! reply without the address, e.g. "13METER   HYD21 400"
+        unsigned long measure_ms;   // time the sensor takes for M/C/V
+        std::string m_values;       // e.g. "+123+21.3+45"
+        std::string v_values;
+        bool measuring;
+        unsigned long ready_us;
+        std::string pending;        // values of the last measurement
+    };
+    extern std::map<char, SDI12Sensor> sdi12_sensors;
+    extern unsigned long sdi12_commands;
+    void sdi12_add_sensor(char address, const std::string &identity, unsigned long measure_ms,
+                          const std::string &m_values, const std::string &v_values = "+0+0+0");
+    void sdi12_reset();
+}
+
+class SDI12 : public Stream {
+    public:
+        SDI12();
+        explicit SDI12(int8_t dataPin);
+        void begin();
+        void end();
+        void sendCommand(String &cmd, int8_t extraWakeTime = 0);
+        void sendCommand(const char *cmd, int8_t extraWakeTime = 0);
+        int available() override;
+        int read() override;
+        int peek() override;
+        void clearBuffer();
+        size_t write(uint8_t c) override { (void)c; return 1; }
+        using Print::write;
+        bool setActive() { return true; }
+        bool isActive() { return true; }
+        void forceHold() {}
+        void forceListen() {}
+        int8_t getDataPin() { return pin; }
+
+    private:
+        void queue(const std::string &reply, unsigned long delay_us);
+        void insert(char c, uint64_t at);
+        struct Byte { char c; uint64_t at; };
+        std::deque<Byte> rx;
+        int8_t pin;
+};
+
+#endif
@@ -0,0 +1,18 @@
+/**
+ * host mock of the Arduino SPI library
+ */
+
+#ifndef _SPI_H_INCLUDED
+#define _SPI_H_INCLUDED
+
+#include <Arduino.h>
+
+class SPIClass {
+    public:
+        void begin() {}
+        uint8_t transfer(uint8_t data) { (void)data; return 0; }
+};
+
+extern SPIClass SPI;
+
+#endif
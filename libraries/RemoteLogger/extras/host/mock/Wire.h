@@ -0,0 +1,37 @@
+/**
+ * host mock of the Arduino Wire (I2C) library - a register file per device address
+ */
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include <Arduino.h>
+
+namespace mock {
+    extern uint8_t i2c_regs[128][64];
+}
+
+class TwoWire : public Stream {
+    public:
+        void begin() {}
+        void beginTransmission(uint8_t address) { addr = address; txCount = 0; }
+        uint8_t endTransmission(bool sendStop = true);
+        uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+        size_t write(uint8_t c) override;
+        using Print::write;
+        int available() override { return rxCount - rxPos; }
+        int read() override { return rxPos < rxCount ? rxBuf[rxPos++] : -1; }
+        int peek() override { return rxPos < rxCount ? rxBuf[rxPos] : -1; }
+        void setClock(uint32_t hz) { (void)hz; }
+
+    private:
+        uint8_t addr = 0, reg = 0;
+        uint8_t txBuf[32];
+        int txCount = 0;
+        uint8_t rxBuf[32];
+        int rxCount = 0, rxPos = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * host mocks without their own translation unit: MemoryFree, Wire, SPI, SHT31, DallasTemperature
+ */
+
+#include <Arduino.h>
+#include <MemoryFree.h>
+#include <Wire.h>
+#include <SPI.h>
+#include <Adafruit_SHT31.h>
+#include <DallasTemperature.h>
+
+namespace mock {
+    uint8_t i2c_regs[128][64];
+    float sht31_temp = 21.5, sht31_rh = 45.2;
+    float ds18b20_temps[8] = {4.25, 4.5, 5.0, 5.5, 6.0, 6.5, 7.0, 7.5};
+    uint8_t ds18b20_count = 1;
+    unsigned long ds18b20_searches = 0;
+    unsigned long ds18b20_conversions = 0;
+    uint8_t ds18b20_bits[8] = {12, 12, 12, 12, 12, 12, 12, 12};
+    unsigned long ds18b20_eeprom_writes = 0;
+}
+
+TwoWire Wire;
+SPIClass SPI;
+
+int freeMemory(){ return 24000; }
+
+uint8_t TwoWire::endTransmission(bool sendStop){
+    (void)sendStop;
+    if (txCount > 0) {
+        reg = txBuf[0];
+        for (int i = 1; i < txCount; i++) mock::i2c_regs[addr & 0x7f][(reg + i - 1) & 0x3f] = txBuf[i];
+    }
+    delayMicroseconds(100 * txCount);
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop){
+    (void)sendStop;
+    if (quantity > sizeof(rxBuf)) quantity = sizeof(rxBuf);
+    for (int i = 0; i < quantity; i++) rxBuf[i] = mock::i2c_regs[address & 0x7f][(reg + i) & 0x3f];
+    rxCount = quantity; rxPos = 0;
+    delayMicroseconds(100 * quantity);
+    return quantity;
+}
+
+size_t TwoWire::write(uint8_t c){
+    if (txCount < (int)sizeof(txBuf)) txBuf[txCount++] = c;
+    return 1;
+}
+
+bool DallasTemperature::getAddress(uint8_t *address, uint8_t index){
+    mock::ds18b20_searches++;
+    delay(15);          // a full search ROM pass
+    if (index >= mock::ds18b20_count) return false;
+    uint8_t a[8] = {0x28, index, 0, 0, 0, 0, 0, 0};
+    memcpy(address, a, 8);
+    return true;
+}
+
+void DallasTemperature::begin(){
+    mock::ds18b20_searches++;
+    delay(15 * (mock::ds18b20_count + 1));      // a search ROM pass per probe, and one to find the end
+    for (int i = 0; i < mock::ds18b20_count; i++) {
+        if (mock::ds18b20_bits[i] > res) res = mock::ds18b20_bits[i];       // the finest probe, as the library does
+    }
+}
+
+bool DallasTemperature::setResolution(const uint8_t *address, uint8_t bits, bool skipGlobal){
+    if (address[1] >= mock::ds18b20_count) return false;
+    mock::ds18b20_bits[address[1]] = bits;
+    mock::ds18b20_eeprom_writes++;
+    delay(10);          // copy scratchpad
+    if (!skipGlobal && bits > res) res = bits;
+    return true;
+}
+
+void DallasTemperature::requestTemperatures(){
+    mock::ds18b20_conversions++;
+    conversionStart = mock::clock_us;
+    converted = true;
+    conversionDone = mock::clock_us + (uint64_t)millisToWaitForConversion(res) * 1000;
+    if (waitForConversion) delay(millisToWaitForConversion(res));
+}
+
+float DallasTemperature::getTempC(const uint8_t *address){
+    delay(2);
+    if (address[1] >= mock::ds18b20_count) return DEVICE_DISCONNECTED_C;
+    // each probe converts at its own resolution - read too soon, it still holds its power-on value
+    uint64_t done = conversionStart + (uint64_t)millisToWaitForConversion(mock::ds18b20_bits[address[1]]) * 1000;
+    if (!converted || mock::clock_us < done) return 85.0;
+    return mock::ds18b20_temps[address[1]];
+}
+
+float DallasTemperature::getTempCByIndex(uint8_t index){
+    DeviceAddress a;
+    if (!getAddress(a, index)) return DEVICE_DISCONNECTED_C;
+    return getTempC(a);
+}
@@ -0,0 +1,224 @@
+/**
+ * power cut tests for the SD card writes - every write is cut at each byte in turn (mock::sd_cut_after),
+ * the power comes back and begin() recovers; the card must then hold the write whole or not at all
+ *
+ * usage: build/recovery   (make test) - prints a line per check, exits 1 if any failed
+*/
+
+#include <RemoteLogger.h>
+#include <stdio.h>
+
+#define SIM_VBAT_PIN 9              // A7, the Feather's battery divider (vbatPin)
+
+static float multipliers[3] = {1, 10, 1};
+static const char *header = "datetime,batt_v,memory,water_level_mm,water_temp_c,water_ec_dcm";
+static int failures = 0;
+
+static void check(const char *name, bool good){
+    printf("%-52s %s\n", name, good ? "ok" : "FAIL");
+    if (!good) failures++;
+}
+
+static DateTime hour(int i){
+    return DateTime(2024, 6, 1, 0, 5, 0) + TimeSpan((int32_t)i * 3600);
+}
+
+static void measurement(RemoteLogger &logger, Measurement *msmt, int i){
+    logger.start_measurement(msmt);
+    logger.add_value(msmt, 1000 + i);
+    logger.add_value(msmt, 4.5);
+    logger.add_value(msmt, 120);
+}
+
+static void fill(int rows){
+    RemoteLogger logger(header, 3, multipliers, "ABC");
+    logger.begin();
+    Measurement msmt;
+    for (int i = 0; i < rows; i++) {
+        measurement(logger, &msmt, i);
+        logger.write_hourly(hour(i), &msmt);
+    }
+}
+
+/* the rows of the hourly store are 0 .. n-1 in order, each with its own value */
+static bool hourly_intact(RemoteLogger &logger, int n){
+    if (logger.num_hours() != n) return false;
+    for (int i = 0; i < n; i++) {
+        HourlyRecord record;
+        if (!logger.read_hourly(i, &record) || record.timestamp != hour(i).unixtime() || record.values[0] != 1000 + i) return false;
+    }
+    return true;
+}
+
+/* bytes a call writes to the card, uncut */
+template <class Body> long bytes_written(const std::map<std::string, std::vector<uint8_t> > &card, Body body){
+    mock::sd_files = card;
+    unsigned long before = mock::sd_stats.bytes_written;
+    body();
+    return mock::sd_stats.bytes_written - before;
+}
+
+int main(){
+    mock::analog_value[SIM_VBAT_PIN] = 620;
+
+    /* an hourly row with its header: after the cut the store has the old rows, or the old rows and the new one */
+    {
+        mock::sd_reset();
+        fill(5);
+        std::map<std::string, std::vector<uint8_t> > card = mock::sd_files;
+        auto write = [](){
+            RemoteLogger logger(header, 3, multipliers, "ABC");
+            logger.begin();
+            Measurement msmt;
+            measurement(logger, &msmt, 5);
+            logger.write_hourly(hour(5), &msmt);
+        };
+        long total = bytes_written(card, write);
+        bool good = total > 0;
+        for (long cut = 0; cut <= total && good; cut++) {
+            mock::sd_files = card;
+            mock::sd_cut_after(cut);
+            write();
+            mock::sd_power_on();
+            RemoteLogger logger(header, 3, multipliers, "ABC");
+            logger.begin();
+            good = hourly_intact(logger, 5) || hourly_intact(logger, 6);
+        }
+        check("write_hourly cut at every byte", good);
+    }
+
+    /* a message into the outbox with the rows it takes: the rows are in the store or in the outbox, once */
+    {
+        mock::sd_reset();
+        fill(10);
+        std::map<std::string, std::vector<uint8_t> > card = mock::sd_files;
+        auto queue = [](){
+            RemoteLogger logger(header, 3, multipliers, "ABC");
+            logger.begin();
+            logger.queue_hourly(false);
+        };
+        long total = bytes_written(card, queue);
+        RemoteLogger uncut(header, 3, multipliers, "ABC");
+        uncut.begin();
+        bool good = total > 0 && uncut.num_hours() == 0 && uncut.num_outbox() == 1;
+        for (long cut = 0; cut <= total && good; cut++) {
+            mock::sd_files = card;
+            mock::sd_cut_after(cut);
+            queue();
+            mock::sd_power_on();
+            RemoteLogger logger(header, 3, multipliers, "ABC");
+            logger.begin();
+            good = (hourly_intact(logger, 10) && logger.num_outbox() == 0) || (logger.num_hours() == 0 && logger.num_outbox() == 1);
+        }
+        check("queue_hourly cut at every byte", good);
+    }
+
+    /* a journaled write that fails part way is made before the next one, in the same wake */
+    {
+        mock::sd_reset();
+        fill(3);
+        RemoteLogger logger(header, 3, multipliers, "ABC");
+        logger.begin();
+        logger.num_hours();             // store header in memory
+        Measurement msmt;
+        measurement(logger, &msmt, 3);
+        mock::sd_fail_open = "/HOURLY.BIN";      // copied to the journal, can't be made
+        logger.write_hourly(hour(3), &msmt);
+        mock::sd_fail_open.clear();
+        measurement(logger, &msmt, 4);
+        logger.write_hourly(hour(4), &msmt);
+        check("failed journal entry replayed before the next", hourly_intact(logger, 5));
+
+        RemoteLogger next(header, 3, multipliers, "ABC");
+        next.begin();
+        check("  and still there after a power cycle", hourly_intact(next, 5));
+    }
+
+    /* DATA.csv is appended without the journal: a torn row doesn't swallow the next one */
+    {
+        mock::sd_reset();
+        std::map<std::string, std::vector<uint8_t> > card = mock::sd_files;
+        auto append = [](int i){
+            RemoteLogger logger(header, 3, multipliers, "ABC");
+            logger.begin();
+            Measurement msmt;
+            measurement(logger, &msmt, i);
+            logger.write_measurement(hour(i), &msmt, "/DATA.csv");
+            logger.flush_logs();
+        };
+        append(0);
+        card = mock::sd_files;
+        long total = bytes_written(card, [&](){ append(1); });
+        bool good = total > 0;
+        for (long cut = 1; cut < total && good; cut++) {
+            mock::sd_files = card;
+            mock::sd_cut_after(cut);
+            append(1);
+            mock::sd_power_on();
+            append(2);
+            const std::vector<uint8_t> &csv = mock::sd_files["/DATA.CSV"];
+            std::string text(csv.begin(), csv.end());
+            size_t at = text.rfind("\r\n", text.size() - 3);      // start of the last row, which is whole
+            good = at != std::string::npos && text.compare(at + 2, 4, "2024") == 0 && text.find(",1002,", at) != std::string::npos;
+        }
+        check("DATA.csv append cut at every byte", good);
+    }
+
+    /* the first record of a new day in the archive: whatever is left of its segment is found by read_archive */
+    {
+        mock::sd_reset();
+        auto archive = [](int i){
+            RemoteLogger logger(header, 3, multipliers, "ABC");
+            logger.begin();
+            Measurement msmt;
+            measurement(logger, &msmt, i);
+            logger.write_archive(hour(i), &msmt);
+        };
+        archive(0);
+        archive(1);
+        std::map<std::string, std::vector<uint8_t> > card = mock::sd_files;
+        long total = bytes_written(card, [&](){ archive(25); });
+        bool good = total > 0;
+        for (long cut = 0; cut <= total && good; cut++) {
+            mock::sd_files = card;
+            mock::sd_cut_after(cut);
+            archive(25);
+            mock::sd_power_on();
+            archive(26);
+            RemoteLogger logger(header, 3, multipliers, "ABC");
+            logger.begin();
+            HourlyRecord records[8];
+            int got = logger.read_archive(0, hour(48).unixtime(), records, 8);
+            good = (got == 3 || got == 4) && records[0].timestamp == hour(0).unixtime()
+                && records[1].timestamp == hour(1).unixtime() && records[got - 1].timestamp == hour(26).unixtime();
+        }
+        check("write_archive new day cut at every byte", good);
+    }
+
+    /* the counters (save_slots, like the other slot files): after the cut they are the old ones or the new */
+    for (int saved = 0; saved < 2; saved++) {
+        mock::sd_reset();
+        auto increment = [](){
+            RemoteLogger logger(header, 3, multipliers, "ABC");
+            logger.begin();
+            logger.increment_samples();
+        };
+        for (int i = 0; i < saved * 3; i++) increment();
+        std::map<std::string, std::vector<uint8_t> > card = mock::sd_files;
+        long total = bytes_written(card, increment);
+        bool good = total > 0;
+        for (long cut = 0; cut <= total && good; cut++) {
+            mock::sd_files = card;
+            mock::sd_cut_after(cut);
+            increment();
+            mock::sd_power_on();
+            RemoteLogger logger(header, 3, multipliers, "ABC");
+            logger.begin();
+            int n = logger.num_samples();
+            good = n == saved * 3 || n == saved * 3 + 1;
+        }
+        check(saved ? "counter save cut at every byte" : "first counter save cut at every byte", good);
+    }
+
+    return failures > 0 ? 1 : 0;
+}
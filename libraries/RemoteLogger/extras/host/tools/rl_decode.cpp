@@ -0,0 +1,77 @@
+/**
+ * decode an archive of RemoteLogger messages to CSV, with the same codec the logger encodes them with
+ * the archive is each message's length (2 bytes, little endian) then its bytes, text or binary
+ *
+ * usage: build/rl_decode DUMP SCHEMA [SCHEMA...] > rows.csv
+ *   SCHEMA is the letters then the multiplier of every parameter, as passed to the RemoteLogger
+ *   constructor: ABC/1,10,1 - or ABD/1,10,0,100 where the third parameter isn't sent
+ * writes letters,datetime,batt_v,memory then the values of each row; a summary goes to stderr
+*/
+
+#include <RemoteLoggerCodec.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+int main(int argc, char **argv){
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s DUMP LETTERS/MULT,MULT,... [LETTERS/MULT,...]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(argv[1], "rb");
+    if (f == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    std::vector<uint8_t> dump;
+    uint8_t chunk[65536];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), f)) > 0) dump.insert(dump.end(), chunk, chunk + got);
+    fclose(f);
+
+    // schemas from the command line
+    int num_schemas = argc - 2 < CODEC_MAX_SCHEMAS ? argc - 2 : CODEC_MAX_SCHEMAS;
+    rl_codec::Schema schemas[CODEC_MAX_SCHEMAS];
+    static float multipliers[CODEC_MAX_SCHEMAS][CODEC_MAX_VALUES * 4];
+    for (int s = 0; s < num_schemas; s++) {
+        char *spec = argv[s + 2];
+        char *slash = strchr(spec, '/');
+        if (slash == NULL) {
+            fprintf(stderr, "bad schema %s (letters/multipliers)\n", spec);
+            return 2;
+        }
+        *slash = '\0';
+        int n = 0;
+        for (char *p = slash + 1; *p && n < CODEC_MAX_VALUES * 4; n++) {
+            multipliers[s][n] = strtof(p, &p);
+            if (*p == ',') p++;
+        }
+        schemas[s] = {spec, n, multipliers[s]};
+    }
+
+    long rows = 0;
+    long bad = 0;
+    auto start = std::chrono::steady_clock::now();
+    long good = rl_codec::decode_dump(dump.data(), dump.size(), schemas, num_schemas,
+        [&](const rl_codec::Message &msg, const rl_codec::Row *row){
+            for (int r = 0; r < msg.rows && r < BINARY_MAX_ROWS; r++) {
+                int year, month, day, hour;
+                rl_codec::civil_time(row[r].time, &year, &month, &day, &hour);
+                uint32_t rest = row[r].time % 3600;
+                printf("%s,%04d-%02d-%02dT%02d:%02u:%02u,%.2f,%ld", msg.letters, year, month, day, hour,
+                    rest / 60, rest % 60, msg.batt / 100.0, msg.memory * 100L);
+                for (int i = 0; i < row[r].count; i++) {
+                    if (msg.match) printf(",%g", rl_codec::real_value(*msg.match, i, row[r].values[i]));
+                    else printf(",%d", row[r].values[i]);          // no multipliers for these letters
+                }
+                printf("\n");
+                rows++;
+            }
+        }, &bad);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    fprintf(stderr, "%ld messages, %ld rows, %ld not decoded, %.3f s\n", good, rows, bad, s);
+    return bad > 0 ? 1 : 0;
+}
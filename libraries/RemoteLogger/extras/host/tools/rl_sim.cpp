@@ -0,0 +1,497 @@
+/**
+ * deployment simulator - replays a DATA.csv series through the RemoteLogger library (over the mocks) one
+ * wake at a time, the way a TPL5110 sketch runs it, and projects what a configuration costs over the series:
+ * awake time, energy, Iridium credits and the data that never makes it off the logger
+ *
+ * usage: build/rl_sim DATA.csv SCHEMA [--OPTION VALUE ...] [--profile PROFILE.bin] [--sweep OPTION=V,V,... ...]
+ *   SCHEMA is the letters then the multiplier of every parameter, as for rl_decode: ABC/1,10,1
+ *   --profile takes the sensor and modem power-up times from a card's /PROFILE.bin (means over its wakes)
+ *   --sweep runs every combination of the values given, one CSV line each
+ *   --jobs runs that many configurations at once, each in its own process (the mocks are global)
+ * writes the swept options then the results of each configuration as CSV; a summary goes to stderr
+ *
+ * each wake: begin, start_measurement, the sensors (the sensor time, as PHASE_JOBS), the row of the series
+ * closest before the wake, write_measurement, increment_samples, and once an hour write_hourly and auto_send,
+ * then tpl_done - the time and energy come from /PROFILE.bin as the logger writes it
+ * the modem is the mock's: each session succeeds with the success probability and takes send_ms
+ * a lost row is an hourly row written but neither sent nor still waiting (the hourly store or the outbox
+ * overwrote it); a dark hour is one the battery was flat for (only with a modelled battery)
+*/
+
+#include <RemoteLogger.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define SIM_VBAT_PIN 9              // A7, the Feather's battery divider (vbatPin)
+#define SIM_MAX_SWEEPS 8
+
+/**
+ * a setting of the simulation, given as --name value or swept with --sweep name=v,v,...
+*/
+struct Option {
+    const char *name;
+    double value;
+    const char *help;
+};
+
+enum { INTERVAL_M, SEND_ROWS, MAX_FRAMES, LOW_V, CRITICAL_V, SUCCESS, SIGNAL, BEGIN_MS, SEND_MS, SENSOR_MS,
+    AWAKE_MA, SENSOR_MA, MODEM_MA, SLEEP_UA, BATTERY_MAH, PANEL_MA, TZ_H, DAYS, SEED, NUM_OPTIONS };
+
+static Option options[NUM_OPTIONS] = {
+    {"interval_m", 15, "minutes between wakes (the TPL5110 setting)"},
+    {"send_rows", 4, "hourly rows before a send (setSendBatch)"},
+    {"max_frames", 8, "messages per session (setSendBatch)"},
+    {"low_v", 3.6, "battery for low power sends (setSendBattery)"},
+    {"critical_v", 3.4, "battery below which nothing is sent (setSendBattery)"},
+    {"success", 0.9, "chance one SBD session succeeds"},
+    {"signal", 3, "signal quality the modem reports, 0-5 (0 never sends)"},
+    {"begin_ms", 2000, "modem power up"},
+    {"send_ms", 15000, "one SBD session"},
+    {"sensor_ms", 1500, "sensors, every wake"},
+    {"awake_ma", 15, "board current while awake"},
+    {"sensor_ma", 20, "sensor current on top, while sampling"},
+    {"modem_ma", 145, "modem current on top, while it is on"},
+    {"sleep_ua", 40, "everything while the TPL5110 has the power off"},
+    {"battery_mah", 0, "battery capacity, 0 to use the battery column of DATA.csv"},
+    {"panel_ma", 0, "solar charge at noon (a half sine from 06:00 to 18:00)"},
+    {"tz_h", 0, "hours from UTC to the site's local time, for the sun"},
+    {"days", 0, "days of the series to run, 0 for all of it"},
+    {"seed", 1, "for the modem's successes"},
+};
+
+/**
+ * one line of DATA.csv
+*/
+struct SeriesRow {
+    uint32_t time;
+    float batt_v;
+    int count;
+    float values[MAX_PARAMS];
+};
+
+/**
+ * totals over one run
+*/
+struct SimResult {
+    double days;
+    long wakes;
+    double awake_s;
+    double mah;
+    long credits;
+    long messages;              // outbox and text messages that got through
+    long previews;              // low power messages (one row, also kept for later)
+    long sessions;              // modem power ups
+    long failed;                // SBD sessions that didn't get through
+    long rows;                  // hourly rows written
+    long sent;
+    long waiting;               // still in the store or the outbox at the end
+    long lost;
+    long loss_events;           // times rows were lost, however many at once
+    double dark_h;
+    double min_charge;          // lowest state of charge, fraction of the battery
+};
+
+static std::vector<SeriesRow> series;
+static std::string header;
+static rl_codec::Schema schema;
+static float multipliers[MAX_PARAMS];
+static char letters[MAX_PARAMS + 1];
+static int num_params;
+static rl_codec::Row decoded[BINARY_MAX_ROWS];
+
+/**
+ * seconds since 1970 from a DATA.csv time (2024-06-01T12:00:00), 0 if it isn't one
+*/
+static uint32_t parse_time(const char *text){
+    int year, month, day, hour, minute, second;
+    if (sscanf(text, "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &minute, &second) != 6) return 0;
+    return rl_codec::unix_time(year, month, day, hour) + minute * 60 + second;
+}
+
+/**
+ * read the header and every row of DATA.csv, skipping anything that isn't a row (e.g. a header repeated
+ * after a wipe); rows must be in time order
+*/
+static bool load_series(const char *path){
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    char line[RECORD_CHARS * 2];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        uint32_t time = parse_time(line);
+        if (time == 0) {
+            if (header.empty() && line[0] != '\0') header = line;
+            continue;
+        }
+        if (!series.empty() && time <= series.back().time) continue;
+
+        SeriesRow row = {time, 0, 0, {0}};
+        char *p = strchr(line, ',');
+        for (int column = 0; p != NULL && row.count < MAX_PARAMS; column++) {
+            float value = strtof(p + 1, NULL);
+            if (column == 0) row.batt_v = value;
+            else if (column > 1) row.values[row.count++] = value;      // column 1 is memory - sampled again
+            p = strchr(p + 1, ',');
+        }
+        series.push_back(row);
+    }
+    fclose(f);
+    return !series.empty();
+}
+
+/**
+ * sensor and modem power-up times from a card's /PROFILE.bin, as the means over the wakes that had them
+*/
+static bool load_profile(const char *path){
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    ProfileHeader profile;
+    bool ok = fread(&profile, sizeof(profile), 1, f) == 1 && profile.magic == PROFILE_MAGIC &&
+        profile.record_size == sizeof(ProfileRecord);
+    double sensor_us = 0, modem_us = 0;
+    int sensor_n = 0, modem_n = 0;
+    for (int i = 0; ok && i < profile.count; i++) {
+        ProfileRecord record;
+        if (fread(&record, sizeof(record), 1, f) != 1) break;
+        unsigned long sensors = record.phase_us[PHASE_JOBS];
+        if (sensors == 0) {
+            for (int phase = PHASE_SDI12; phase <= PHASE_DS18B20; phase++) sensors += record.phase_us[phase];
+        }
+        if (sensors > 0) { sensor_us += sensors; sensor_n++; }
+        if (record.phase_us[PHASE_MODEM_ON] > 0) { modem_us += record.phase_us[PHASE_MODEM_ON]; modem_n++; }
+    }
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "%s isn't a RemoteLogger profile\n", path);
+        return false;
+    }
+    if (sensor_n > 0) options[SENSOR_MS].value = sensor_us / sensor_n / 1000;
+    if (modem_n > 0) options[BEGIN_MS].value = modem_us / modem_n / 1000;
+    fprintf(stderr, "profile: %d wakes, sensor_ms %.0f, begin_ms %.0f\n", profile.count,
+        options[SENSOR_MS].value, options[BEGIN_MS].value);
+    return true;
+}
+
+/**
+ * rows in the messages still waiting in the outbox, read from the mock card
+*/
+static long outbox_rows(){
+    auto file = mock::sd_files.find("/OUTBOX.BIN");
+    if (file == mock::sd_files.end()) return 0;
+    const std::vector<uint8_t> &bytes = file->second;
+    long rows = 0;
+    for (int i = 0; i < OUTBOX_SLOTS; i++) {
+        size_t offset = sizeof(OutboxHeader) + (size_t)i * (sizeof(OutboxSlot) + OUTBOX_FRAME_BYTES);
+        if (offset + sizeof(OutboxSlot) + OUTBOX_FRAME_BYTES > bytes.size()) break;
+        OutboxSlot slot;
+        memcpy(&slot, &bytes[offset], sizeof(slot));
+        if (slot.state != OUTBOX_PENDING) continue;
+        rl_codec::Message msg;
+        int n = rl_codec::decode(&bytes[offset + sizeof(OutboxSlot)], slot.len, &schema, 1, &msg, decoded, BINARY_MAX_ROWS);
+        if (n > 0) rows += n;
+    }
+    return rows;
+}
+
+/**
+ * fraction of the panel's noon current at time t (seconds since 1970, UTC)
+*/
+static double sun(uint32_t t, double tz_h){
+    double hour = fmod(t / 3600.0 + tz_h + 48, 24);
+    return hour > 6 && hour < 18 ? sin(M_PI * (hour - 6) / 12) : 0;
+}
+
+/**
+ * run the whole series with the settings in o (indexed as options)
+*/
+static SimResult simulate(const double *o){
+    SimResult r;
+    memset(&r, 0, sizeof(r));
+    r.min_charge = 1;
+
+    mock::sd_reset();
+    mock::irid_reset();
+    mock::irid_model.begin_ms = o[BEGIN_MS];
+    mock::irid_model.send_ms = o[SEND_MS];
+    mock::irid_model.signal_quality = o[SIGNAL];
+    mock::irid_model.success_probability = o[SUCCESS];
+    mock::irid_model.present = true;
+    mock::irid_random_state = o[SEED];
+
+    uint32_t interval = o[INTERVAL_M] * 60 > 60 ? o[INTERVAL_M] * 60 : 60;
+    int per_hour = interval < 3600 ? 3600 / interval : 1;
+    uint32_t start = series.front().time, end = series.back().time;
+    if (o[DAYS] > 0 && start + o[DAYS] * 86400 < end) end = start + o[DAYS] * 86400;
+
+    double capacity = o[BATTERY_MAH];
+    double charge = capacity;
+    size_t row = 0, seen = 0;
+    long last_lost = 0;
+
+    for (uint32_t t = start; t <= end; t += interval) {
+        while (row + 1 < series.size() && series[row + 1].time <= t) row++;
+
+        // the sleep before this wake
+        double sleep_h = interval / 3600.0;
+        r.mah += o[SLEEP_UA] / 1000 * sleep_h;
+        float batt_v = series[row].batt_v;
+        if (capacity > 0) {
+            charge += (o[PANEL_MA] * sun(t, o[TZ_H]) - o[SLEEP_UA] / 1000) * sleep_h;
+            if (charge > capacity) charge = capacity;
+            if (charge <= 0) {
+                charge = 0;
+                r.min_charge = 0;
+                r.dark_h += sleep_h;
+                continue;
+            }
+            batt_v = 3.3 + 0.9 * charge / capacity;      // linear from empty to full - enough for the thresholds
+        }
+        mock::analog_value[SIM_VBAT_PIN] = batt_v * 4096 / (4 * 6.6);   // 10 bit reads, scaled by read_adc
+        mock::rtc_base_unix = t;
+        mock::clock_us = 0;         // power up
+
+        RemoteLogger logger(header.c_str(), num_params, multipliers, letters);
+        logger.setProfiling(true);
+        logger.begin();
+        logger.setSendBatch(o[SEND_ROWS], o[MAX_FRAMES]);
+        logger.setSendBattery(o[LOW_V], o[CRITICAL_V]);
+
+        Measurement msmt;
+        logger.start_measurement(&msmt);
+        {
+            PhaseTimer timer(logger, PHASE_JOBS);
+            mock::advance_us(o[SENSOR_MS] * 1000);
+        }
+        for (int i = 0; i < series[row].count && i < num_params; i++) logger.add_value(&msmt, series[row].values[i]);
+        DateTime now = logger.rtc.now();
+        logger.write_measurement(now, &msmt, "/DATA.csv");
+        logger.increment_samples(&msmt);
+
+        if (logger.num_samples() >= per_hour) {
+            logger.write_hourly(now, &msmt);
+            logger.reset_sample_counter();
+            r.rows++;
+
+            unsigned long begins = mock::irid_begins, attempts = mock::irid_attempts;
+            byte plan = logger.plan_send();
+            logger.auto_send();
+            r.sessions += mock::irid_begins - begins;
+            r.failed += (mock::irid_attempts - attempts) - (mock::irid_sent.size() - seen);
+
+            for (; seen < mock::irid_sent.size(); seen++) {
+                const std::string &msg = mock::irid_sent[seen];
+                r.credits += msg.size() > 0 ? (msg.size() + 49) / 50 : 1;
+                if (plan == SEND_LOW_POWER) {
+                    r.previews++;
+                    continue;
+                }
+                rl_codec::Message decoded_msg;
+                int n = rl_codec::decode((const uint8_t *)msg.data(), msg.size(), &schema, 1, &decoded_msg, decoded, BINARY_MAX_ROWS);
+                if (n > 0) r.sent += n;
+                r.messages++;
+            }
+
+            r.waiting = logger.num_hours() + outbox_rows();
+            r.lost = r.rows - r.sent - r.waiting;
+            if (r.lost > last_lost) r.loss_events++;
+            last_lost = r.lost;
+        }
+        logger.tpl_done();
+
+        ProfileRecord record;
+        if (logger.read_profile(logger.num_profiles() - 1, &record)) {
+            double modem_ms = (record.phase_us[PHASE_MODEM_ON] + record.phase_us[PHASE_MODEM_SEND]) / 1000.0;
+            double sensor_ms = record.phase_us[PHASE_JOBS] / 1000.0;
+            double mah = (o[AWAKE_MA] * record.awake_ms + o[SENSOR_MA] * sensor_ms + o[MODEM_MA] * modem_ms) / 3.6e6;
+            r.awake_s += record.awake_ms / 1000.0;
+            r.mah += mah;
+            if (capacity > 0) charge -= mah;
+        }
+        if (capacity > 0 && charge / capacity < r.min_charge) r.min_charge = charge > 0 ? charge / capacity : 0;
+        r.wakes++;
+    }
+    r.days = (end - start) / 86400.0;
+    if (capacity <= 0) r.min_charge = NAN;
+    return r;
+}
+
+/**
+ * helper function
+ * read len bytes from a pipe, however many reads it takes
+*/
+static bool read_all(int fd, void *out, size_t len){
+    uint8_t *p = (uint8_t *)out;
+    while (len > 0) {
+        ssize_t got = read(fd, p, len);
+        if (got <= 0) return false;
+        p += got;
+        len -= got;
+    }
+    return true;
+}
+
+/**
+ * helper function
+ * the option called name, NULL if there isn't one
+*/
+static Option *find_option(const char *name, int len){
+    for (int i = 0; i < NUM_OPTIONS; i++) {
+        if ((int)strlen(options[i].name) == len && strncmp(options[i].name, name, len) == 0) return &options[i];
+    }
+    return NULL;
+}
+
+static void usage(const char *name){
+    fprintf(stderr, "usage: %s DATA.csv LETTERS/MULT,MULT,... [--OPTION VALUE] [--profile PROFILE.bin] [--sweep OPTION=V,V,...] [--jobs N]\n", name);
+    for (int i = 0; i < NUM_OPTIONS; i++) fprintf(stderr, "  --%-12s %-8g %s\n", options[i].name, options[i].value, options[i].help);
+}
+
+int main(int argc, char **argv){
+    if (argc < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // schema, as for rl_decode
+    char *slash = strchr(argv[2], '/');
+    if (slash == NULL) {
+        fprintf(stderr, "bad schema %s (letters/multipliers)\n", argv[2]);
+        return 2;
+    }
+    *slash = '\0';
+    for (char *p = slash + 1; *p && num_params < MAX_PARAMS; num_params++) {
+        multipliers[num_params] = strtof(p, &p);
+        if (*p == ',') p++;
+    }
+    snprintf(letters, sizeof(letters), "%s", argv[2]);
+    schema = {letters, num_params, multipliers};
+
+    if (!load_series(argv[1])) {
+        fprintf(stderr, "no rows in %s\n", argv[1]);
+        return 1;
+    }
+
+    // options, then the sweeps
+    Option *swept[SIM_MAX_SWEEPS];
+    std::vector<double> values[SIM_MAX_SWEEPS];
+    int num_sweeps = 0;
+    int jobs = 1;
+    for (int i = 3; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0 || i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        const char *name = argv[i] + 2, *value = argv[++i];
+        if (strcmp(name, "jobs") == 0) {
+            jobs = atoi(value) > 0 ? atoi(value) : 1;
+        } else if (strcmp(name, "profile") == 0) {
+            if (!load_profile(value)) return 1;
+        } else if (strcmp(name, "sweep") == 0) {
+            const char *equals = strchr(value, '=');
+            Option *option = equals ? find_option(value, equals - value) : NULL;
+            if (option == NULL || num_sweeps == SIM_MAX_SWEEPS) {
+                fprintf(stderr, "bad sweep %s\n", value);
+                return 2;
+            }
+            char *p = (char *)equals + 1;
+            while (*p) {
+                char *after;
+                values[num_sweeps].push_back(strtod(p, &after));
+                if (after == p || (*after != ',' && *after != '\0')) {
+                    fprintf(stderr, "bad sweep %s\n", value);
+                    return 2;
+                }
+                p = *after == ',' ? after + 1 : after;
+            }
+            swept[num_sweeps++] = option;
+        } else {
+            Option *option = find_option(name, strlen(name));
+            if (option == NULL) {
+                usage(argv[0]);
+                return 2;
+            }
+            option->value = strtod(value, NULL);
+        }
+    }
+
+    for (int s = 0; s < num_sweeps; s++) printf("%s,", swept[s]->name);
+    printf("days,wakes,awake_s_day,mah_day,credits_month,messages_month,previews,sessions,failed_sessions,"
+        "rows,rows_sent,rows_waiting,rows_lost,loss_events,dark_h,min_charge_pct\n");
+
+    // every combination of the swept values, the first sweep changing slowest
+    long configs = 1;
+    for (int s = 0; s < num_sweeps; s++) configs *= values[s].size();
+    std::vector<std::vector<double> > settings(configs, std::vector<double>(NUM_OPTIONS));
+    for (long c = 0; c < configs; c++) {
+        for (int i = 0; i < NUM_OPTIONS; i++) settings[c][i] = options[i].value;
+        long rest = c;
+        for (int s = num_sweeps - 1; s >= 0; s--) {
+            settings[c][swept[s] - options] = values[s][rest % values[s].size()];
+            rest /= values[s].size();
+        }
+    }
+
+    // job j runs configurations j, j + jobs, ... and sends back the results in that order
+    auto started = std::chrono::steady_clock::now();
+    std::vector<SimResult> results(configs);
+    if (jobs > configs) jobs = configs;
+    if (jobs == 1) {
+        for (long c = 0; c < configs; c++) results[c] = simulate(settings[c].data());
+    } else {
+        std::vector<int> pipes;
+        for (int j = 0; j < jobs; j++) {
+            int fd[2];
+            if (pipe(fd) != 0) {
+                perror("pipe");
+                return 1;
+            }
+            fflush(stdout);
+            if (fork() == 0) {
+                close(fd[0]);
+                for (long c = j; c < configs; c += jobs) {
+                    SimResult r = simulate(settings[c].data());
+                    if (write(fd[1], &r, sizeof(r)) != sizeof(r)) _exit(1);
+                }
+                _exit(0);
+            }
+            close(fd[1]);
+            pipes.push_back(fd[0]);
+        }
+        for (int j = 0; j < jobs; j++) {
+            for (long c = j; c < configs; c += jobs) {
+                if (!read_all(pipes[j], &results[c], sizeof(SimResult))) {
+                    fprintf(stderr, "job %d failed\n", j);
+                    return 1;
+                }
+            }
+            close(pipes[j]);
+        }
+        while (wait(NULL) > 0) {}
+    }
+
+    long wakes = 0;
+    for (long c = 0; c < configs; c++) {
+        const SimResult &r = results[c];
+        wakes += r.wakes;
+        double days = r.days > 0 ? r.days : 1;
+        for (int s = 0; s < num_sweeps; s++) printf("%g,", settings[c][swept[s] - options]);
+        printf("%.1f,%ld,%.1f,%.2f,%.1f,%.1f,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%.1f,%.0f\n", r.days, r.wakes,
+            r.awake_s / days, r.mah / days, r.credits * 30 / days, r.messages * 30 / days, r.previews, r.sessions,
+            r.failed, r.rows, r.sent, r.waiting, r.lost, r.loss_events, r.dark_h, r.min_charge * 100);
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    fprintf(stderr, "%ld configurations, %ld wakes, %.2f s\n", configs, wakes, secs);
+    return 0;
+}
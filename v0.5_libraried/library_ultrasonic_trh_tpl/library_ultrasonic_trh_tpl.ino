@@ -67,7 +67,7 @@ void loop(){
     Serial.print(F("it's been ")); Serial.print(samplesSinceHourly); Serial.println(F(" samples since a write to hourly"));
     if (samplesSinceHourly == 4) {    // it's been an hour --> write to hourly
         Serial.println(F("writing to hourly..."));
-        logger.write_to_csv(header, presentTime.timestamp() + "," + sample, "/HOURLY.csv");
+        logger.write_hourly(presentTime, sample);
         logger.reset_sample_counter();      // reset the tracker - wrote to hourly
 
         // determine whether or not to send a message
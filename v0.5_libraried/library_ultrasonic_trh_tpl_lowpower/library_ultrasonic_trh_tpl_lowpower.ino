@@ -71,7 +71,7 @@ void loop(){
 
         if (samplesSinceHourly == 4) {    // it's been an hour --> write to hourly
             Serial.println(F("writing to hourly..."));
-            logger.write_to_csv(header, presentTime.timestamp() + "," + sample, "/HOURLY.csv");
+            logger.write_hourly(presentTime, sample);
             logger.reset_sample_counter();      // reset the tracker - wrote to hourly
 
             // determine whether or not to send a message
@@ -113,7 +113,7 @@ void loop(){
             Serial.print(F("sample: ")); Serial.println(sample);
             Serial.println(F("writing to data file and hourly..."));
             logger.write_to_csv(header, presentTime.timestamp() + "," + sample, "/DATA.csv");
-            logger.write_to_csv(header, presentTime.timestamp() + "," + sample, "/HOURLY.csv");
+            logger.write_hourly(presentTime, sample);
             logger.reset_sample_counter();
 
             // need hours > 2 condition here to make sure it will send exactly once per day
@@ -0,0 +1,56 @@
+/**
+ * cellular link for a RemoteLogger (SerialBridgeTransport) at 115200 baud - the Feather's second serial port
+ * (a SERCOM Uart, since Serial1 is the RockBLOCK's) to the Boron's Serial1, common ground
+ * answers the logger one line at a time:
+ *   "UP?"       -> "UP" once connected to the Particle Cloud, "DOWN" until then
+ *   "TX <hex>"  -> publishes the hex as event "rl" and answers "OK", "OK <hex>" with a message waiting
+ *                  for the logger (from the "config" cloud function), or "ERR"
+ * messages for the logger are the same text as PARAM.txt, e.g. call config with "sample_freq_m\n30"
+ * a 340 byte message is 680 characters of hex - needs Device OS 3.1 or later (events up to 1024 characters)
+ *
+ * note: must be compiled in Particle IDE (web-based) - libraries are different
+*/
+
+#include "Particle.h"
+
+SYSTEM_MODE(AUTOMATIC);
+
+String line = "";
+String waiting = "";        // message for the logger, as hex
+
+int config(String text){
+    waiting = "";
+    for (unsigned int i = 0; i < text.length(); i++) {
+        char hex[3];
+        snprintf(hex, sizeof(hex), "%02X", (uint8_t)text.charAt(i));
+        waiting += hex;
+    }
+    return 0;
+}
+
+void setup() {
+    Serial1.begin(115200);
+    Particle.function("config", config);
+}
+
+void loop() {
+    while (Serial1.available() > 0) {
+        char c = Serial1.read();
+        if (c != '\n') {
+            if (c != '\r') line += c;
+            continue;
+        }
+
+        if (line == "UP?") {
+            Serial1.print(Particle.connected() ? "UP\n" : "DOWN\n");
+        } else if (line.startsWith("TX ")) {
+            if (Particle.connected() && Particle.publish("rl", line.substring(3), PRIVATE)) {
+                Serial1.print(waiting.length() > 0 ? "OK " + waiting + "\n" : "OK\n");
+                waiting = "";
+            } else {
+                Serial1.print("ERR\n");
+            }
+        }
+        line = "";
+    }
+}
@@ -44,7 +44,7 @@ void loop(){
 
     String sample = take_measurement();
 
-    logger.write_to_csv(header, presentTime.timestamp() + "," + sample, "/HOURLY.csv");
+    logger.write_hourly(presentTime, sample);
 
     logger.blinky(3, 500, 500, 1000);       // show
 }
\ No newline at end of file